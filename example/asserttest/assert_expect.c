@@ -0,0 +1,36 @@
+#include "asserttest.h"
+
+TEST(expect_success) {
+	int squares[100];
+	for (int i = 0; i < 100; ++i) {
+		squares[i] = i * i;
+	}
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_INT_EQ_M(squares[i], i * i, "This message is never printed");
+		EXPECT_TRUE(squares[i] >= i);
+	}
+	EXPECT_STRZ_EQ("expecto", "expecto");
+	ASSERT_INT_EQ(squares[99], 9801);
+}
+
+TEST(expect_continue_fail) {
+	int i = 42;
+	EXPECT_INT_EQ_M(i, 43, "Soft assertion failed, the test goes on");
+	EXPECT_UINT_GT(1u, 2u);
+	ASSERT_INT_EQ(i, 41);
+	EXPECT_TRUE(0); // not reached
+}
+
+// fails 9000 times at one site, only the first ones are printed in full
+TEST(expect_loop_fail) {
+	for (int i = 0; i < 10000; ++i) {
+		EXPECT_INT_LT_M(i, 1000, "Value %d out of range", i);
+	}
+}
+
+void register_asserttest_expect(ea_group_t* parent) {
+	ea_group_t* group = ea_group_create(parent, "expect");
+	ea_test_add(group, expect_success);
+	ea_test_add(group, expect_continue_fail);
+	ea_test_add(group, expect_loop_fail);
+}
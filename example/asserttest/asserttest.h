@@ -6,13 +6,20 @@ void register_asserttest_uint(ea_group_t* parent);
 void register_asserttest_str(ea_group_t* parent);
 void register_asserttest_ptr(ea_group_t* parent);
 void register_asserttest_double(ea_group_t* parent);
+void register_asserttest_expect(ea_group_t* parent);
 
-static void register_asserttest_all(ea_group_t* parent) {
-	ea_group_t* group = ea_group_create(parent, "asserts");
+// registered only if the filter can select an assertion test
+static void register_asserttest_lazy(ea_group_t* group, void* opaque) {
+	(void)opaque;
 	register_asserttest_bool(group);
 	register_asserttest_int(group);
 	register_asserttest_uint(group);
 	register_asserttest_str(group);
 	register_asserttest_ptr(group);
 	register_asserttest_double(group);
+	register_asserttest_expect(group);
+}
+
+static void register_asserttest_all(ea_group_t* parent) {
+	ea_group_create_lazy(parent, "asserts", register_asserttest_lazy, 0);
 }
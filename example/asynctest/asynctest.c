@@ -0,0 +1,116 @@
+#include "asynctest.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+ASYNC_TEST(socket_echo) {
+	int fds[2];
+	ASSERT_INT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+	ASSERT_INT_EQ(write(fds[0], "ping", 4), 4);
+	ASSERT_INT_EQ(EA_AWAIT_READABLE(fds[1]), 1);
+	char buf[8] = { 0 };
+	int n = (int)read(fds[1], buf, sizeof(buf) - 1);
+	close(fds[0]);
+	close(fds[1]);
+	ASSERT_INT_EQ(n, 4);
+	ASSERT_STRZ_EQ(buf, "ping");
+}
+
+static long long now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// a sleep after an await lasts its full time, although other tests of the
+// group (await_timeout_fail) wake up meanwhile
+ASYNC_TEST(await_then_sleep) {
+	int fds[2];
+	ASSERT_INT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+	ASSERT_INT_EQ(write(fds[0], "x", 1), 1);
+	int ready = EA_AWAIT_READABLE(fds[1]);
+	close(fds[0]);
+	close(fds[1]);
+	ASSERT_INT_EQ(ready, 1);
+	long long start_ms = now_ms();
+	EA_SLEEP(50);
+	ASSERT_INT_GE(now_ms() - start_ms, 50);
+}
+
+// the writer and the reader wait at the same time, the reader is woken up by the writer
+static int pipe_fds[2];
+
+static void open_pipe(void* opaque) {
+	(void)opaque;
+	if (pipe(pipe_fds) != 0) {
+		pipe_fds[0] = pipe_fds[1] = -1;
+	}
+}
+
+static void close_pipe(void* opaque) {
+	(void)opaque;
+	close(pipe_fds[0]);
+	close(pipe_fds[1]);
+}
+
+ASYNC_TEST(pipe_writer) {
+	EA_SLEEP(20);
+	ASSERT_INT_EQ(write(pipe_fds[1], "x", 1), 1);
+}
+
+ASYNC_TEST(pipe_reader) {
+	ASSERT_INT_EQ(ea_await_readable(ea__current_test_info, pipe_fds[0], 1000), 1);
+	char c = 0;
+	ASSERT_INT_EQ(read(pipe_fds[0], &c, 1), 1);
+	ASSERT_INT_EQ(c, 'x');
+}
+
+ASYNC_TEST(await_timeout_fail) {
+	// nothing is written, the wait times out and the failure is reported for this test
+	int fds[2];
+	ASSERT_INT_EQ(pipe(fds), 0);
+	int ready = ea_await_readable(ea__current_test_info, fds[0], 10);
+	close(fds[0]);
+	close(fds[1]);
+	ASSERT_INT_EQ(ready, 1);
+}
+
+// these sleep at the same time, the group takes about 100 ms instead of 500 ms
+#define SLEEPER(name) ASYNC_TEST(name) { EA_SLEEP(100); }
+SLEEPER(sleeper1)
+SLEEPER(sleeper2)
+SLEEPER(sleeper3)
+SLEEPER(sleeper4)
+SLEEPER(sleeper5)
+
+void register_asynctest(ea_group_t* parent) {
+	ea_group_t* main = ea_group_create(parent, "async");
+	ea_test_add_async(main, socket_echo);
+	ea_test_add_async(main, await_timeout_fail);
+	ea_test_add_async(main, await_then_sleep);
+
+	ea_group_t* pipes = ea_group_create(main, "pipe");
+	ea_group_set_setup(pipes, open_pipe, 0);
+	ea_group_set_teardown(pipes, close_pipe, 0);
+	ea_test_add_async(pipes, pipe_writer);
+	ea_test_add_async(pipes, pipe_reader);
+
+	ea_group_t* sleepers = ea_group_create(main, "sleepers");
+	ea_test_add_async(sleepers, sleeper1);
+	ea_test_add_async(sleepers, sleeper2);
+	ea_test_add_async(sleepers, sleeper3);
+	ea_test_add_async(sleepers, sleeper4);
+	ea_test_add_async(sleepers, sleeper5);
+}
+
+#else
+
+void register_asynctest(ea_group_t* parent) {
+	(void)parent;
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include "benchtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int* make_sorted(long long n) {
+	int* data = (int*)malloc(sizeof(int) * (size_t)n);
+	for (long long i = 0; i < n; ++i) {
+		data[i] = (int)(i * 2);
+	}
+	return data;
+}
+
+BENCHMARK(linear_search) {
+	long long n = BENCH_N();
+	int* data = make_sorted(n);
+	int key = (int)(n * 2 - 2); // last element, the worst case
+	BENCH_LOOP() {
+		long long i = 0;
+		while ((i < n) && (data[i] != key)) {
+			i++;
+		}
+		BENCH_KEEP(i);
+	}
+	BENCH_BYTES(n * (long long)sizeof(int));
+	free(data);
+	EA_EXPECT_COMPLEXITY(O_N);
+}
+
+BENCHMARK(binary_search) {
+	long long n = BENCH_N();
+	int* data = make_sorted(n);
+	int key = (int)(n * 2 - 2);
+	BENCH_LOOP() {
+		long long lo = 0, hi = n;
+		while (lo < hi) {
+			long long mid = lo + (hi - lo) / 2;
+			if (data[mid] < key) {
+				lo = mid + 1;
+			}
+			else {
+				hi = mid;
+			}
+		}
+		BENCH_KEEP(lo);
+	}
+	free(data);
+	EA_EXPECT_COMPLEXITY(O_LOG_N);
+}
+
+// insertion sort of reversed data is quadratic, the expectation fails
+BENCHMARK(insertion_sort_fail) {
+	long long n = BENCH_N();
+	int* data = (int*)malloc(sizeof(int) * (size_t)n);
+	BENCH_LOOP() {
+		for (long long i = 0; i < n; ++i) {
+			data[i] = (int)(n - i);
+		}
+		for (long long i = 1; i < n; ++i) {
+			int v = data[i];
+			long long j = i;
+			for (; (j > 0) && (data[j - 1] > v); --j) {
+				data[j] = data[j - 1];
+			}
+			data[j] = v;
+		}
+		BENCH_KEEP(data[0]);
+	}
+	free(data);
+	EA_EXPECT_COMPLEXITY(O_N_LOG_N);
+}
+
+BENCHMARK(copy_4k) {
+	static char src[4096], dst[4096];
+	BENCH_LOOP() {
+		memcpy(dst, src, sizeof(src));
+		BENCH_KEEP(dst);
+	}
+	BENCH_BYTES(sizeof(src));
+}
+
+void register_benchtest(ea_group_t* parent) {
+	ea_group_t* group = ea_group_create(parent, "bench");
+	ea_benchmark_add_range(group, linear_search, 1 << 6, 1 << 14);
+	ea_benchmark_add_range(group, binary_search, 1 << 6, 1 << 16);
+	ea_benchmark_add_range(group, insertion_sort_fail, 1 << 4, 1 << 11);
+	ea_benchmark_add(group, copy_4k);
+}
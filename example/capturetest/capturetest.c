@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "capturetest.h"
+
+// chatty code under test, run with --capture to see its output only on failure
+static int parse_config(const char* text) {
+	printf("parse_config: parsing \"%s\"\n", text);
+	int value = 0;
+	for (const char* p = text; *p; ++p) {
+		if ((*p < '0') || (*p > '9')) {
+			fprintf(stderr, "parse_config: unexpected character '%c'\n", *p);
+			return -1;
+		}
+		value = value * 10 + (*p - '0');
+	}
+	printf("parse_config: value %d\n", value);
+	return value;
+}
+
+TEST(chatty_pass) {
+	ASSERT_INT_EQ(parse_config("42"), 42);
+}
+
+// the output written with stdio and with write() is shown below the failure
+TEST(chatty_fail) {
+	static const char raw[] = "written with write()\n";
+	if (write(STDOUT_FILENO, raw, sizeof(raw) - 1) < 0) {
+		ASSERT_TRUE_M(0, "write failed");
+	}
+	ASSERT_INT_EQ(parse_config("4x2"), 42);
+}
+
+void register_capturetest(ea_group_t* parent) {
+	ea_group_t* group = ea_group_create(parent, "capture");
+	ea_test_add(group, chatty_pass);
+	ea_test_add(group, chatty_fail);
+}
@@ -0,0 +1,3 @@
+#include "expectoassertum.h"
+
+void register_capturetest(ea_group_t* parent);
@@ -0,0 +1,45 @@
+#include "concurrenttest.h"
+
+#define INCREMENTS 100000
+
+static long long counter = 0;
+static int slots[8];
+
+// lock-free counter: no increment may get lost
+TEST_CONCURRENT(atomic_counter, 4) {
+	for (int i = 0; i < INCREMENTS; ++i) {
+		__atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED);
+	}
+	CONCURRENT_OPS(INCREMENTS);
+}
+
+TEST(check_counter) {
+	ASSERT_INT_EQ(counter, 4 * INCREMENTS);
+	counter = 0;
+}
+
+// every thread gets its own index
+TEST_CONCURRENT(thread_indices, 8) {
+	ASSERT_INT_EQ(THREAD_COUNT(), 8);
+	ASSERT_INT_EQ(slots[THREAD_INDEX()], 0);
+	slots[THREAD_INDEX()] = CONCURRENT_ROUND() + 1;
+}
+
+TEST(check_slots) {
+	for (int i = 0; i < 8; ++i) {
+		ASSERT_INT_NE(slots[i], 0);
+		slots[i] = 0;
+	}
+}
+
+// the failures of threads 2 and 3 are both reported
+TEST_CONCURRENT(thread_fail, 4) {
+	ASSERT_INT_LT_M(THREAD_INDEX(), 2, "Thread %d should not get here", THREAD_INDEX());
+}
+
+void register_concurrenttest(ea_group_t* parent) {
+	ea_group_t* group = ea_group_create(parent, "concurrent");
+	ea_concurrent_add_ex(group, atomic_counter, 5, check_counter);
+	ea_concurrent_add_ex(group, thread_indices, 3, check_slots);
+	ea_concurrent_add(group, thread_fail);
+}
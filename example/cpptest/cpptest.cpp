@@ -0,0 +1,68 @@
+#include "cpptest.h"
+
+#include "expectoassertum.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct point {
+	int x, y;
+	bool operator==(const point& other) const { return (x == other.x) && (y == other.y); }
+};
+
+std::ostream& operator<<(std::ostream& os, const point& p) {
+	return os << "(" << p.x << ", " << p.y << ")";
+}
+
+enum class color { red, green };
+
+constexpr long long factorial(int n) {
+	return (n <= 1) ? 1 : n * factorial(n - 1);
+}
+
+constexpr int gcd(int a, int b) {
+	while (b != 0) {
+		int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+} // namespace
+
+TEST(same_type) {
+	std::vector<int> v = { 1, 2, 3 };
+	ASSERT_EQ(v.size(), 3); // size_t against int, compared by value
+	ASSERT_LT(-1, v.size());
+	ASSERT_EQ(std::string("abc"), "abc");
+	ASSERT_NE(color::red, color::green);
+}
+
+TEST(custom_printer_fail) {
+	point a = { 1, 2 };
+	point b = { 1, 3 };
+	ASSERT_EQ_M(a, b, "points of %s differ", "the grid");
+}
+
+TEST(string_fail) {
+	std::string greeting = "hello";
+	ASSERT_EQ(greeting, std::string("world"));
+}
+
+// checked by the compiler, reported at run time without running again
+CONSTEXPR_TEST(pure_functions) {
+	ASSERT_EQ(factorial(5), 120);
+	ASSERT_EQ(gcd(12, 18), 6);
+	ASSERT_GT(factorial(10), factorial(9));
+}
+
+extern "C" void register_cpptest(ea_group_t* parent) {
+	ea_group_t* group = ea_group_create(parent, "cpp");
+	ea_test_add(group, same_type);
+	ea_test_add(group, custom_printer_fail);
+	ea_test_add(group, string_fail);
+	ea_test_add(group, pure_functions);
+}
@@ -0,0 +1,11 @@
+#include "expectoassertum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void register_cpptest(ea_group_t* parent);
+
+#ifdef __cplusplus
+}
+#endif
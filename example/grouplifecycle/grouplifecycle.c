@@ -1,3 +1,6 @@
+#include <stdlib.h>
+#include <time.h>
+
 #include "grouplifecycle.h"
 
 static int value;
@@ -19,6 +22,152 @@ TEST(torndown) {
 	ASSERT_INT_EQ(value, 123);
 }
 
+
+static int fixture_builds, fixture_teardowns, fixture_live;
+static int unused_builds;
+
+static void fixture_setup(void* opaque) {
+	(void)opaque;
+	fixture_builds++;
+	fixture_live = 1;
+}
+static void fixture_teardown(void* opaque) {
+	(void)opaque;
+	fixture_teardowns++;
+	fixture_live = 0;
+}
+static void unused_setup(void* opaque) {
+	(void)opaque;
+	unused_builds++;
+}
+
+TEST(fixture_built_once) {
+	ASSERT_INT_EQ(fixture_live, 1);
+	ASSERT_INT_EQ(fixture_builds, 1);
+}
+
+TEST(fixture_torndown) {
+	ASSERT_INT_EQ(fixture_live, 0);
+	ASSERT_INT_EQ(fixture_teardowns, fixture_builds);
+}
+
+TEST(fixture_unused_never_built) {
+	ASSERT_INT_EQ(unused_builds, 0);
+}
+
+static void register_grouplifecycle_fixtures(ea_group_t* parent) {
+	ea_group_t* main = ea_group_create(parent, "fixtures");
+	ea_group_add_tags(main, "fixture");
+	ea_fixture_create(main, "shared", fixture_setup, fixture_teardown, 0);
+	ea_fixture_create(main, "unused", unused_setup, 0, 0);
+	ea_group_t* first = ea_group_create(main, "first");
+	ea_group_use_fixtures(first, "shared");
+	ea_test_add(first, fixture_built_once);
+	ea_group_t* second = ea_group_create(main, "second");
+	ea_test_add_fixtures(second, fixture_built_once, "shared");
+	ea_group_t* after = ea_group_create(main, "after");
+	ea_test_add_tags(after, fixture_torndown, "serial");
+	ea_test_add(after, fixture_unused_never_built);
+}
+
+
+// a slow setup built while the tests of the group before it run
+#define DATASET_LEN 1000
+static int dataset[DATASET_LEN];
+static int dataset_loaded;
+
+static void wait_ms(long ms) {
+	struct timespec ts = { 0, ms * 1000000L };
+	nanosleep(&ts, NULL);
+}
+
+static void load_dataset(void* opaque) {
+	(void)opaque;
+	wait_ms(30); // I/O
+	for (int i = 0; i < DATASET_LEN; ++i) {
+		dataset[i] = i * i;
+	}
+	dataset_loaded = 1;
+}
+static void unload_dataset(void* opaque) {
+	(void)opaque;
+	dataset_loaded = 0;
+}
+
+TEST(slow_indexing) {
+	wait_ms(30);
+	ASSERT_TRUE(1);
+}
+
+TEST(dataset_ready) {
+	ASSERT_INT_EQ(dataset_loaded, 1);
+	ASSERT_INT_EQ(dataset[DATASET_LEN - 1], (DATASET_LEN - 1) * (DATASET_LEN - 1));
+}
+
+static void register_grouplifecycle_prewarm(ea_group_t* parent) {
+	ea_group_t* main = ea_group_create(parent, "prewarm");
+	ea_group_t* indexing = ea_group_create(main, "indexing");
+	ea_test_add(indexing, slow_indexing);
+	ea_group_t* queries = ea_group_create(main, "queries");
+	ea_group_set_setup(queries, load_dataset, 0);
+	ea_group_set_teardown(queries, unload_dataset, 0);
+	ea_group_set_prewarmable(queries, 1);
+	ea_test_add(queries, dataset_ready);
+}
+
+// isolated tests: each runs in a forked child with a copy-on-write view of
+// the table built once by the setup, so changing it does not leak into the
+// next test
+#define TABLE_LEN 4096
+static int* table;
+static int table_builds;
+
+static void build_table(void* opaque) {
+	(void)opaque;
+	table = (int*)malloc(sizeof(int) * TABLE_LEN);
+	for (int i = 0; i < TABLE_LEN; ++i) {
+		table[i] = i;
+	}
+	table_builds++;
+}
+static void free_table(void* opaque) {
+	(void)opaque;
+	free(table);
+	table = NULL;
+}
+
+TEST(reverse_table) {
+	for (int i = 0; i < TABLE_LEN / 2; ++i) {
+		int t = table[i];
+		table[i] = table[TABLE_LEN - 1 - i];
+		table[TABLE_LEN - 1 - i] = t;
+	}
+	ASSERT_INT_EQ(table[0], TABLE_LEN - 1);
+}
+
+// sees the table as the setup built it, after the tests changing it
+TEST(table_untouched) {
+	ASSERT_INT_EQ(table_builds, 1);
+	ASSERT_INT_EQ(table[0], 0);
+	ASSERT_INT_EQ(table[TABLE_LEN - 1], TABLE_LEN - 1);
+}
+
+// the child dies, the test is reported as crashed and the run goes on
+TEST(abort_fail) {
+	table[0] = -1;
+	abort();
+}
+
+static void register_grouplifecycle_isolated(ea_group_t* parent) {
+	ea_group_t* isolated = ea_group_create(parent, "isolated");
+	ea_group_set_setup(isolated, build_table, 0);
+	ea_group_set_teardown(isolated, free_table, 0);
+	ea_group_set_isolated(isolated, 1);
+	ea_test_add(isolated, reverse_table);
+	ea_test_add(isolated, abort_fail);
+	ea_test_add(isolated, table_untouched);
+}
+
 void register_grouplifecycle(ea_group_t* parent) {
 	ea_group_t* main = ea_group_create(parent, "grouplifecycle");
 	ea_group_t* withlifecycle = ea_group_create(main, "withlifecycle");
@@ -27,4 +176,7 @@ void register_grouplifecycle(ea_group_t* parent) {
 	ea_test_add(withlifecycle, setup);
 	ea_group_t* nolifecycle = ea_group_create(main, "nolifecycle");
 	ea_test_add(nolifecycle, torndown);
+	register_grouplifecycle_fixtures(main);
+	register_grouplifecycle_prewarm(main);
+	register_grouplifecycle_isolated(main);
 }
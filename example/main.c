@@ -1,5 +1,17 @@
 #include "asserttest/asserttest.h"
+#include "asynctest/asynctest.h"
+#include "benchtest/benchtest.h"
+#include "capturetest/capturetest.h"
+#include "concurrenttest/concurrenttest.h"
+#ifdef EA_EXAMPLE_CPP
+#include "cpptest/cpptest.h"
+#endif
 #include "grouplifecycle/grouplifecycle.h"
+#ifdef EA_EXAMPLE_MOCK
+#include "mocktest/mocktest.h"
+#endif
+#include "propertytest/propertytest.h"
+#include "stacktest/stacktest.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -35,7 +47,40 @@ int main(int argc, char** argv) {
 	ea_group_t* root = ea_create_root_nomalloc(tracking_mem_alloc, NULL);
 	register_grouplifecycle(root);
 	register_asserttest_all(root);
+	register_propertytest(root);
+	register_asynctest(root);
+	register_stacktest(root);
+	register_benchtest(root);
+	register_concurrenttest(root);
+	register_capturetest(root);
+#ifdef EA_EXAMPLE_MOCK
+	register_mocktest(root);
+#endif
+#ifdef EA_EXAMPLE_CPP
+	register_cpptest(root);
+#endif
+	ea_parse_cmdline(root, argc, argv);
 	const char* filterstring = ea_parse_filter_cmdline(argc, argv);
-	ea_run(root, filterstring);
+
+	// run, then list the failures from the results, like a custom reporter would
+	ea_results_t* results = ea_run_ex(root, filterstring);
+	for (int i = 0; i < results->count; ++i) {
+		const ea_test_result_t* test = &results->tests[i];
+		if (test->status == EA_TEST_PASSED) {
+			continue;
+		}
+		if (test->failure_file) {
+			printf("Failed: %s (line %d, after %d assertion(s))\n", test->name, test->failure_line, test->assertion_count);
+		}
+		else {
+			printf("Failed: %s (%s)\n", test->name, (test->status == EA_TEST_CRASHED) ? "crashed" : "no assertion failed");
+		}
+	}
+	if (results->bench_environment.noisy_count) {
+		printf("Noisy benchmarks: %d on %s\n", results->bench_environment.noisy_count, results->bench_environment.cpu_model);
+	}
+	int exit_code = (results->failed_count > 0) ? 1 : 0;
+	ea_results_free(root, results);
 	ea_release_group(root);
+	return exit_code;
 }
@@ -0,0 +1,56 @@
+#include "mocktest.h"
+#include "sensor.h"
+
+// the functions are wrapped by ea_add_mocks() in example/CMakeLists.txt
+EA_MOCK(int, sensor_read, (int channel), (channel))
+EA_MOCK_VOID(sensor_log, (const char* text), (text))
+
+TEST(scripted_returns) {
+	EA_MOCK_RETURN(sensor_read, 10);
+	EA_MOCK_RETURN(sensor_read, 20);
+	EA_MOCK_RETURN(sensor_read, 30);
+	ASSERT_INT_EQ(thermostat_average(2, 3), 20);
+	ASSERT_CALLED_TIMES(sensor_read, 3);
+	ASSERT_CALLED_WITH(sensor_read, 2);
+}
+
+// without a script the real function runs, the calls of the previous test are forgotten
+TEST(real_function) {
+	ASSERT_INT_EQ(thermostat_average(1, 4), 21);
+	ASSERT_CALLED_TIMES(sensor_read, 4);
+	ASSERT_INT_EQ(EA_MOCK_ARG(sensor_read, -1, 0), 1);
+}
+
+TEST(stubbed_log) {
+	EA_MOCK_RETURN_ALWAYS(sensor_read, 90);
+	EA_MOCK_STUB(sensor_log);
+	ASSERT_INT_EQ(thermostat_check(0, 50), 0);
+	ASSERT_INT_EQ(thermostat_check(1, 50), 0);
+	ASSERT_CALLED_TIMES(sensor_log, 2);
+	ASSERT_STRZ_EQ((const char*)EA_MOCK_ARG(sensor_log, 0, 0), "too hot");
+
+	EA_MOCK_RETURN(sensor_read, 10);
+	ASSERT_INT_EQ(thermostat_check(0, 50), 1);
+	ASSERT_CALLED_TIMES(sensor_log, 2);
+}
+
+TEST(not_called) {
+	ASSERT_INT_EQ(thermostat_average(0, 0), 0);
+	ASSERT_NOT_CALLED(sensor_read);
+}
+
+// fails, the recorded calls are listed
+TEST(called_with_fail) {
+	thermostat_average(1, 2);
+	thermostat_check(3, 99);
+	ASSERT_CALLED_WITH(sensor_read, 7);
+}
+
+void register_mocktest(ea_group_t* parent) {
+	ea_group_t* group = ea_group_create(parent, "mock");
+	ea_test_add(group, scripted_returns);
+	ea_test_add(group, real_function);
+	ea_test_add(group, stubbed_log);
+	ea_test_add(group, not_called);
+	ea_test_add(group, called_with_fail);
+}
@@ -0,0 +1,12 @@
+#include <stdio.h>
+
+#include "sensor.h"
+
+// the real functions, called by the mocks unless a test scripts them
+int sensor_read(int channel) {
+	return 20 + channel;
+}
+
+void sensor_log(const char* text) {
+	printf("sensor: %s\n", text);
+}
@@ -0,0 +1,7 @@
+// hardware access, mocked by the tests (see example/CMakeLists.txt)
+int sensor_read(int channel);
+void sensor_log(const char* text);
+
+// code under test (thermostat.c)
+int thermostat_average(int channel, int samples);
+int thermostat_check(int channel, int limit);
@@ -0,0 +1,63 @@
+#include "propertytest.h"
+
+#include <string.h>
+
+static void reverse(char* s, int len) {
+	for (int i = 0, j = len - 1; i < j; ++i, --j) {
+		char tmp = s[i];
+		s[i] = s[j];
+		s[j] = tmp;
+	}
+}
+
+PROPERTY(reverse_twice_is_identity) {
+	char original[65], reversed[65];
+	int len = GEN_STR(original, 64, NULL);
+	memcpy(reversed, original, len + 1);
+	reverse(reversed, len);
+	reverse(reversed, len);
+	ASSERT_STRZ_EQ(reversed, original);
+}
+
+PROPERTY(addition_commutes) {
+	long long a = GEN_INT(-1000000, 1000000);
+	long long b = GEN_INT(-1000000, 1000000);
+	ASSERT_INT_EQ(a + b, b + a);
+}
+
+PROPERTY(sum_fail) {
+	// shrinks to a minimal counterexample with a + b == 1001
+	long long a = GEN_INT(0, 1000000);
+	long long b = GEN_INT(0, 1000000);
+	ASSERT_INT_LE_M(a + b, 1000, "Sum is too large");
+}
+
+PROPERTY(bytes_fail) {
+	// shrinks to a single 0x80 byte
+	unsigned char buf[256];
+	int len = GEN_BYTES(buf, 0, 256);
+	for (int i = 0; i < len; ++i) {
+		ASSERT_UINT_LT(buf[i], 0x80);
+	}
+}
+
+PROPERTY(double_square_nonnegative) {
+	double d = GEN_DOUBLE(-1e6, 1e6);
+	ASSERT_DOUBLE_GE(d * d, 0.0);
+}
+
+PROPERTY(parallel_million_cases) {
+	unsigned long long u = GEN_UINT(0, 1ull << 40);
+	ASSERT_UINT_EQ((u * 3) / 3, u);
+}
+
+void register_propertytest(ea_group_t* parent) {
+	ea_group_t* group = ea_group_create(parent, "property");
+	ea_group_add_tags(group, "slow");
+	ea_property_add(group, reverse_twice_is_identity);
+	ea_property_add(group, addition_commutes);
+	ea_property_add(group, sum_fail);
+	ea_property_add(group, bytes_fail);
+	ea_property_add(group, double_square_nonnegative);
+	ea_property_add_ex(group, parallel_million_cases, 1000000, 10000, 4);
+}
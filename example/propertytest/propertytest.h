@@ -0,0 +1,3 @@
+#include "expectoassertum.h"
+
+void register_propertytest(ea_group_t* parent);
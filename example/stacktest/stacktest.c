@@ -0,0 +1,43 @@
+#include "stacktest.h"
+
+#include <string.h>
+
+// touches about depth * 256 bytes of stack, volatile so it is not optimized away
+static int recurse(int depth) {
+	volatile char frame[256];
+	memset((char*)frame, depth, sizeof(frame));
+	if (depth == 0) {
+		return frame[0];
+	}
+	return recurse(depth - 1) + frame[1];
+}
+
+TEST(small_frame) {
+	ASSERT_INT_EQ(recurse(4), 10);
+}
+
+TEST(within_budget) {
+	ASSERT_INT_GT(recurse(16), 0);
+}
+
+// touches about 8 KB with a budget of 2 KB
+TEST(over_budget_fail) {
+	ASSERT_INT_GT(recurse(32), 0);
+}
+
+#ifdef __linux__
+// runs into the guard page of the default 256 KB test stack, reported as failure
+TEST(overflow_fail) {
+	ASSERT_INT_GT(recurse(4096), 0);
+}
+#endif
+
+void register_stacktest(ea_group_t* parent) {
+	ea_group_t* group = ea_group_create(parent, "stack");
+	ea_test_add_stack(group, small_frame, 4 * 1024);
+	ea_test_add_stack(group, within_budget, 16 * 1024);
+	ea_test_add_stack(group, over_budget_fail, 2 * 1024);
+#ifdef __linux__
+	ea_test_add_stack(group, overflow_fail, 16 * 1024);
+#endif
+}
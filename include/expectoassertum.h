@@ -1,6 +1,10 @@
 #ifndef EXPECTOASSERTUM_H_INCLUDED
 #define EXPECTOASSERTUM_H_INCLUDED
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief Opaque type representing a group in the test framework.
  */
@@ -31,7 +35,8 @@ ea_group_t* ea_create_root_nomalloc(ea_mem_alloc_func_t mem_alloc, void* opaque)
 /**
  * @brief Clean up the group and free associated memory. Usually called on the
  * root group, but can be called on any group. Must be called when done with
- * the tests to avoid memory leaks.
+ * the tests to avoid memory leaks. Group setups and shared fixtures left up
+ * by the serve option are torn down here.
  */
 void ea_release_group(ea_group_t* group);
 
@@ -42,6 +47,96 @@ void ea_release_group(ea_group_t* group);
  */
 const char* ea_parse_filter_cmdline(int argc, char** argv);
 
+/**
+ * @brief Set a run option on the tree the group belongs to.
+ * @details Options are stored in the root group. Known options:
+ * - seed=<n>: base seed of the property generators (default: time based)
+ * - prop-cases=<n>: default number of cases per property (default: 100)
+ * - prop-time=<ms>: default time budget per property, 0 for none
+ * - prop-threads=<n>: default number of threads per property (default: 1)
+ * - changed-since=<cache>: only run tests whose source files (or group
+ *   dependencies) changed, or which failed, since the run that wrote the cache
+ *   file; the cache is updated after the run
+ * - tags=<selector>: only run tests having any of the listed tags (own or
+ *   inherited), tags prefixed with a tilde '~' exclude tests, e.g. "slow,~flaky"
+ * - list[=json]: print the selected tests with their tags and source location
+ *   instead of running them (no setup or test is run)
+ * - jobs=<n|auto>: run the tests in n worker processes (auto: one per CPU),
+ *   a crashing test is reported as failed
+ * - durations=<file>: keep a per-test duration history in the file and run the
+ *   longest work first in worker processes
+ * - journal=<file>: record each test's result in a crash-safe journal file as
+ *   soon as it finishes (a new journal is started)
+ * - resume=<file>: continue the run recorded in the journal: tests that
+ *   finished are reported from it instead of being run again, the test that
+ *   was running when the run died is reported as crashed; new results are
+ *   appended to the journal. Without a file it resumes the journal option.
+ * - async-timeout=<ms>: time limit of async tests (default: 10000)
+ * - stack=<bytes>: run every test on a dedicated stack of this size behind a
+ *   guard page and report the bytes it touched, an overflow fails the test
+ * - stack-budget=<bytes>: fail tests touching more stack than this, unless
+ *   they declare their own budget (implies stack measurement)
+ * - bench-time=<ms>: minimum timed duration of a benchmark per size (default: 20)
+ * - bench-trials=<n>: measure each benchmark size in n trials after a warmup
+ *   to a steady state, reject outliers and print the mean with its 95%
+ *   confidence interval, the environment and the reasons the results may be
+ *   noisy (default: 1, no warmup)
+ * - bench-cpu=<n>: pin benchmarks to CPU n (Linux) and raise their scheduling
+ *   priority as far as allowed, with the warmup and environment of bench-trials
+ * - profile[=<dir>]: sample the stacks of each test, write them to
+ *   <dir>/<test name>.folded (default: the current directory) and print the
+ *   functions with the most samples after the result
+ * - profile-hz=<n>: profiler samples per second of CPU time (default: 1000, the
+ *   kernel's tick rate may limit it, the delivered rate is printed)
+ * - serve=<path>: instead of running the tests, serve runs on a Unix domain
+ *   socket until a shutdown request: each connection sends a line "run
+ *   [filter]" (the usual output) or "json [filter]" (the results as JSON), or
+ *   "shutdown". Group setups run once, before the first test of the group, and
+ *   shared fixtures stay built between runs, ea_release_group() tears them
+ *   down. Runs are in-process (jobs is ignored); ea_run_ex() returns no results.
+ * - failures-per-site=<n|all>: failures of an assertion site (file and line)
+ *   printed in full per run (default: 5), later ones are only counted with the
+ *   range of their actual values; every site that failed is listed with its
+ *   count after the summary. With jobs the limit applies per worker process,
+ *   the counts of the workers are merged into one list.
+ * - capture[=<bytes>]: redirect stdout and stderr (file descriptors 1 and 2)
+ *   of each test to a pipe, whose last bytes (default: 65536) a reader thread
+ *   keeps in a ring buffer; the output of a passed test is dropped, that of a
+ *   failed test is printed below its failure and kept in the output of its
+ *   ea_run_ex() result (not with jobs, the workers print it). stdout is made
+ *   line buffered for the run unless it is unbuffered. The framework's own
+ *   output still goes to stdout. Async tests are not captured.
+ * - isolate: run each test in a child process forked right before it (see
+ *   ea_group_set_isolated()).
+ * The value strings must stay valid until the tests are run.
+ * @return Nonzero if the option is known and the value is valid.
+ */
+int ea_set_option(ea_group_t* group, const char* name, const char* value);
+
+/**
+ * @brief Parse command line arguments of the form --name=value and set them
+ * as options with ea_set_option(). The --filter argument is skipped, use
+ * ea_parse_filter_cmdline() for it.
+ */
+void ea_parse_cmdline(ea_group_t* group, int argc, char** argv);
+
+/**
+ * @brief Output function type, receives the output of the framework in blocks.
+ * @param data Text, not null-terminated.
+ * @param len Length of the text.
+ * @param opaque User-defined pointer passed through.
+ */
+typedef void(*ea_output_func_t)(const char* data, int len, void* opaque);
+
+/**
+ * @brief Send all output of the framework to the given function instead of
+ * stdout, e.g. to a UART. In a freestanding build (EA_FREESTANDING) this is
+ * the only output. A character sink simply writes the block byte by byte.
+ * @param func Output function, NULL to restore the default.
+ * @param opaque User-defined pointer passed to the output function.
+ */
+void ea_set_output(ea_output_func_t func, void* opaque);
+
 /**
  * @brief Run the test framework starting from the given group (usually the root).
  * @param filterstring The filterstring contains one or more comma-separated
@@ -51,6 +146,83 @@ const char* ea_parse_filter_cmdline(int argc, char** argv);
  */
 void ea_run(ea_group_t* group, const char* filterstring);
 
+/**
+ * @brief Status of a test run by ea_run_ex().
+ */
+typedef enum {
+	EA_TEST_PASSED = 0,
+	EA_TEST_FAILED,
+	EA_TEST_CRASHED, // the process running the test (a worker or an isolated child) died
+} ea_test_status_t;
+
+#ifndef EA_RESULT_MESSAGE_LEN
+#define EA_RESULT_MESSAGE_LEN 256
+#endif
+
+/**
+ * @brief Result of a test run by ea_run_ex().
+ */
+typedef struct {
+	const char* name; // full name, as seen from the run group
+	const char* file; // file registering the test
+	int line; // line of the test definition
+	ea_test_status_t status;
+	unsigned long long duration_ns; // 0 in a freestanding build
+	int assertion_count; // number of assertions checked
+
+	// first failed assertion, failure_file is NULL if no assertion failed
+	// (passed, crashed, or failed e.g. a stack budget)
+	const char* failure_file;
+	int failure_line;
+	char failure_message[EA_RESULT_MESSAGE_LEN]; // details as printed (truncated), empty if none
+
+	// resources
+	int stack_bytes; // stack touched, 0 if not measured (see the stack option)
+
+	// stdout and stderr of a failed test (see the capture option), NULL if none
+	char* output;
+} ea_test_result_t;
+
+/**
+ * @brief Machine state seen by the benchmarks of a run with noise control
+ * (see the bench-trials and bench-cpu options), to flag noisy runs.
+ */
+typedef struct {
+	int measured; // a benchmark ran with noise control, the rest is unset if not
+	char cpu_model[64];
+	char governor[32]; // CPU frequency governor, empty if unknown
+	int load_hundredths; // highest 1 minute load average * 100, -1 if unknown
+	int cpus;
+	int noisy_count; // benchmarks with a reason not to trust their results
+} ea_bench_environment_t;
+
+/**
+ * @brief Results of an ea_run_ex() call, a single block.
+ */
+typedef struct {
+	int total_count; // executed tests, including the resumed ones
+	int failed_count; // failed (or crashed) tests
+	int filtered_count; // tests filtered out
+	int unchanged_count; // tests skipped as unchanged
+	int resumed_count; // tests finished in a previous run (see the resume option)
+	int count; // number of records in tests (total_count)
+	ea_test_result_t* tests; // in the order the tests finished
+	ea_bench_environment_t bench_environment; // of in-process runs
+} ea_results_t;
+
+/**
+ * @brief Run the tests like ea_run() (printing the same output) and return
+ * the results. The results are allocated with the group's mem_alloc in one
+ * block (captured outputs apart), release them with ea_results_free().
+ * @return Results, never NULL. No test is run in list mode, count is 0 then.
+ */
+ea_results_t* ea_run_ex(ea_group_t* group, const char* filterstring);
+
+/**
+ * @brief Release results returned by ea_run_ex() on the same group.
+ */
+void ea_results_free(ea_group_t* group, ea_results_t* results);
+
 /**
  * @brief Create a test group.
  * @param parent Pointer to the parent group.
@@ -58,6 +230,27 @@ void ea_run(ea_group_t* group, const char* filterstring);
  * @return Pointer to the created group.
  */
 ea_group_t* ea_group_create(ea_group_t* parent, const char* name);
+
+/**
+ * @brief Register function of a lazy group, adds the tests and subgroups.
+ */
+typedef void(*ea_group_register_func_t)(ea_group_t* group, void* opaque);
+
+/**
+ * @brief Create a test group whose content is registered on demand.
+ * @details register_func is called once, when a run (or listing) selects
+ * tests and the filter or tag selector could match something below the
+ * group: a test name starting with the group's path, no negated prefix
+ * filter covering it, no excluded tag on the group or its ancestors. A narrow
+ * run never pays for registering the rest of the tree. Change-based selection
+ * registers every lazy group (it has to see the files of all tests).
+ * @param parent Pointer to the parent group.
+ * @param name Name of the group.
+ * @param register_func Function adding the tests and subgroups.
+ * @param opaque User-defined pointer passed to register_func.
+ * @return Pointer to the created group.
+ */
+ea_group_t* ea_group_create_lazy(ea_group_t* parent, const char* name, ea_group_register_func_t register_func, void* opaque);
 /**
  * @brief Set setup and teardown functions for a test group.
  * @param group Pointer to the group.
@@ -76,25 +269,108 @@ void ea_group_set_setup(ea_group_t* group, ea_group_setup_teardown_func_t setup,
  */
 void ea_group_set_teardown(ea_group_t* group, ea_group_setup_teardown_func_t teardown, void* opaque);
 
+/**
+ * @brief Declare that the setup of a group may run ahead, on a thread.
+ * @details In a serial in-process run the setup of the next group with a
+ * setup (in run order) is started on a thread when the group before it
+ * starts, and runs while that group's tests run; the group waits for it
+ * instead of calling the setup. The setups of its ancestors have run by
+ * then, but the tests and teardowns of the groups before it may run at the
+ * same time, so the setup must not share unsynchronized state with them.
+ * Needs thread support, otherwise the setup runs as usual.
+ * @param group Pointer to the group.
+ * @param prewarmable Nonzero to allow prewarming (default: 0).
+ */
+void ea_group_set_prewarmable(ea_group_t* group, int prewarmable);
+
+/**
+ * @brief Run each test of a group and its subgroups in a forked child.
+ * @details The group setups and shared fixtures are built once in the parent;
+ * the child of a test gets their memory copy-on-write, so the test may change
+ * them without affecting the tests after it. The teardowns run once in the
+ * parent. A test whose child dies is reported as crashed. Property tests,
+ * benchmarks, concurrent tests and async tests run in the parent, as do all
+ * tests while profiling. Failures in children are not counted per assertion
+ * site. Needs fork(), otherwise the tests run in-process.
+ * @param group Pointer to the group.
+ * @param isolated Nonzero to isolate the tests (default: 0).
+ */
+void ea_group_set_isolated(ea_group_t* group, int isolated);
+
+/**
+ * @brief Register a named fixture shared by all groups of the tree.
+ * @details A fixture is built (setup called) right before the first selected
+ * test that needs it and torn down right after the last one finished. Fixtures
+ * no selected test needs are never built.
+ * @param group Any group of the tree, the fixture is registered at the root.
+ * @param name Name of the fixture.
+ * @param setup Function building the fixture, can be NULL.
+ * @param teardown Function tearing down the fixture, can be NULL.
+ * @param opaque User-defined pointer passed to setup and teardown.
+ */
+void ea_fixture_create(ea_group_t* group, const char* name,
+	ea_group_setup_teardown_func_t setup, ea_group_setup_teardown_func_t teardown, void* opaque);
+
+/**
+ * @brief Declare that all tests of a group (including subgroups) need the
+ * given fixtures.
+ * @param fixture_names Comma-separated list of fixture names.
+ */
+void ea_group_use_fixtures(ea_group_t* group, const char* fixture_names);
+
+/**
+ * @brief Declare an extra source file the tests of a group (including
+ * subgroups) depend on, for change-based selection (see ea_set_option()).
+ * The file registering a test is always taken into account.
+ */
+void ea_group_add_dependency(ea_group_t* group, const char* path);
+
+/**
+ * @brief Add tags (comma-separated list, e.g. "slow,io") to a group. Tags are
+ * inherited by the tests of the group and its subgroups.
+ */
+void ea_group_add_tags(ea_group_t* group, const char* tags);
+
 typedef struct ea__test_info_s ea__test_info_t;
 
 #define ea__test_func_name(name) ea__testfunc_ ## name
+#define ea__test_line_name(name) ea__testline_ ## name
 
 /**
  * @brief Macro to define a test function.
  */
-#define TEST(name) static void ea__test_func_name(name)(ea__test_info_t* ea__current_test_info)
+#define TEST(name) enum { ea__test_line_name(name) = __LINE__ }; \
+	static void ea__test_func_name(name)(ea__test_info_t* ea__current_test_info)
 
 /**
- * @brief Macro to add a test to a group.
+ * @brief Macro to add a test to a group. The file registering the test is
+ * recorded as its source file.
  */
-#define ea_test_add(group, test) ea__test_add(group, ea__test_func_name(test), #test)
+#define ea_test_add(group, test) ea__test_add(group, ea__test_func_name(test), #test, __FILE__, ea__test_line_name(test))
+
+/**
+ * @brief Macro to add a test needing the given fixtures (comma-separated list) to a group.
+ */
+#define ea_test_add_fixtures(group, test, fixture_names) ea_test_add_with(group, test, 0, fixture_names)
+
+/**
+ * @brief Macro to add a test with tags (comma-separated list) to a group.
+ */
+#define ea_test_add_tags(group, test, tags) ea_test_add_with(group, test, tags, 0)
+
+/**
+ * @brief Macro to add a test with tags and fixtures (comma-separated lists,
+ * either can be NULL) to a group.
+ */
+#define ea_test_add_with(group, test, tags, fixture_names) ea__test_add_with(group, ea__test_func_name(test), #test, __FILE__, ea__test_line_name(test), tags, fixture_names)
 
 typedef void(*ea__test_func_t)(ea__test_info_t*);
-void ea__test_add(ea_group_t* group, ea__test_func_t test_func, const char* test_name);
+void ea__test_add(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line);
+void ea__test_add_with(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line, const char* tags, const char* fixture_names);
 
 // assertions
-void ea__print_assertion_failed(ea__test_info_t* test_info, const char* file, int line);
+// marks the current test as failed, returns nonzero if details should be printed
+int ea__print_assertion_failed(ea__test_info_t* test_info, const char* file, int line);
 
 enum {
 	ea__op_eq,
@@ -170,6 +446,7 @@ int ea__assert_str_check(ea__test_info_t* test_info, const char* a, const char*
 #define ASSERT_STRN_EQ(a, b, size) ASSERT_STRN_EQ_M(a, b, size, 0)
 #define ASSERT_STRN_NE(a, b, size) ASSERT_STRN_NE_M(a, b, size, 0)
 
+#ifndef EA_NO_DOUBLE
 int ea__assert_double_check(ea__test_info_t* test_info, double a, double b, double reltol, double abstol, int op, const char* sa, const char* sb, const char* file, int line, const char* msg, ...);
 #define ea__assert_double(a, b, relative_tolerance, absolute_tolerance, op, msg, ...) if (!ea__assert_double_check(ea__current_test_info, a, b, relative_tolerance, absolute_tolerance, op, #a, #b, __FILE__, __LINE__, msg, ##__VA_ARGS__)) return;
 #define ASSERT_DOUBLE_EQ_T_M(a, b, relative_tolerance, absolute_tolerance, msg, ...) ea__assert_double(a, b, relative_tolerance, absolute_tolerance, ea__op_eq, msg, ##__VA_ARGS__)
@@ -198,5 +475,512 @@ int ea__assert_double_check(ea__test_info_t* test_info, double a, double b, doub
 #define ASSERT_DOUBLE_LE(a, b) ASSERT_DOUBLE_LE_T_M(a, b, ea_default_double_tolerance_rel, ea_default_double_tolerance_abs, 0)
 #define ASSERT_DOUBLE_GT(a, b) ASSERT_DOUBLE_GT_T_M(a, b, ea_default_double_tolerance_rel, ea_default_double_tolerance_abs, 0)
 #define ASSERT_DOUBLE_GE(a, b) ASSERT_DOUBLE_GE_T_M(a, b, ea_default_double_tolerance_rel, ea_default_double_tolerance_abs, 0)
+#endif // EA_NO_DOUBLE
+
+// soft assertions: like the ASSERT_ macros, but the test goes on after a
+// failure (e.g. to check every element of an array). A failing EXPECT in a
+// loop prints its first failures in full, the rest is counted per assertion
+// site and summarized after the run (see the failures-per-site option).
+#define ea__expect_bool(actual, exp, msg, ...) ((void)ea__assert_bool_check(ea__current_test_info, !!(actual), #actual, exp, __FILE__, __LINE__, msg, ##__VA_ARGS__))
+#define EXPECT_TRUE_M(value, msg, ...) ea__expect_bool(value, 1, msg, ##__VA_ARGS__)
+#define EXPECT_FALSE_M(value, msg, ...) ea__expect_bool(value, 0, msg, ##__VA_ARGS__)
+#define EXPECT_TRUE(value) EXPECT_TRUE_M(value, 0)
+#define EXPECT_FALSE(value) EXPECT_FALSE_M(value, 0)
+#define ea__expect_int(a, b, op, msg, ...) ((void)ea__assert_int_check(ea__current_test_info, a, b, op, #a, #b, __FILE__, __LINE__, msg, ##__VA_ARGS__))
+#define EXPECT_INT_EQ_M(a, b, msg, ...) ea__expect_int(a, b, ea__op_eq, msg, ##__VA_ARGS__)
+#define EXPECT_INT_NE_M(a, b, msg, ...) ea__expect_int(a, b, ea__op_ne, msg, ##__VA_ARGS__)
+#define EXPECT_INT_LT_M(a, b, msg, ...) ea__expect_int(a, b, ea__op_lt, msg, ##__VA_ARGS__)
+#define EXPECT_INT_LE_M(a, b, msg, ...) ea__expect_int(a, b, ea__op_le, msg, ##__VA_ARGS__)
+#define EXPECT_INT_GT_M(a, b, msg, ...) ea__expect_int(a, b, ea__op_gt, msg, ##__VA_ARGS__)
+#define EXPECT_INT_GE_M(a, b, msg, ...) ea__expect_int(a, b, ea__op_ge, msg, ##__VA_ARGS__)
+#define EXPECT_INT_EQ(a, b) EXPECT_INT_EQ_M(a, b, 0)
+#define EXPECT_INT_NE(a, b) EXPECT_INT_NE_M(a, b, 0)
+#define EXPECT_INT_LT(a, b) EXPECT_INT_LT_M(a, b, 0)
+#define EXPECT_INT_LE(a, b) EXPECT_INT_LE_M(a, b, 0)
+#define EXPECT_INT_GT(a, b) EXPECT_INT_GT_M(a, b, 0)
+#define EXPECT_INT_GE(a, b) EXPECT_INT_GE_M(a, b, 0)
+#define ea__expect_uint(a, b, op, msg, ...) ((void)ea__assert_uint_check(ea__current_test_info, a, b, op, #a, #b, __FILE__, __LINE__, msg, ##__VA_ARGS__))
+#define EXPECT_UINT_EQ_M(a, b, msg, ...) ea__expect_uint(a, b, ea__op_eq, msg, ##__VA_ARGS__)
+#define EXPECT_UINT_NE_M(a, b, msg, ...) ea__expect_uint(a, b, ea__op_ne, msg, ##__VA_ARGS__)
+#define EXPECT_UINT_LT_M(a, b, msg, ...) ea__expect_uint(a, b, ea__op_lt, msg, ##__VA_ARGS__)
+#define EXPECT_UINT_LE_M(a, b, msg, ...) ea__expect_uint(a, b, ea__op_le, msg, ##__VA_ARGS__)
+#define EXPECT_UINT_GT_M(a, b, msg, ...) ea__expect_uint(a, b, ea__op_gt, msg, ##__VA_ARGS__)
+#define EXPECT_UINT_GE_M(a, b, msg, ...) ea__expect_uint(a, b, ea__op_ge, msg, ##__VA_ARGS__)
+#define EXPECT_UINT_EQ(a, b) EXPECT_UINT_EQ_M(a, b, 0)
+#define EXPECT_UINT_NE(a, b) EXPECT_UINT_NE_M(a, b, 0)
+#define EXPECT_UINT_LT(a, b) EXPECT_UINT_LT_M(a, b, 0)
+#define EXPECT_UINT_LE(a, b) EXPECT_UINT_LE_M(a, b, 0)
+#define EXPECT_UINT_GT(a, b) EXPECT_UINT_GT_M(a, b, 0)
+#define EXPECT_UINT_GE(a, b) EXPECT_UINT_GE_M(a, b, 0)
+#define ea__expect_ptr(a, b, op, msg, ...) ((void)ea__assert_ptr_check(ea__current_test_info, a, b, op, #a, #b, __FILE__, __LINE__, msg, ##__VA_ARGS__))
+#define EXPECT_PTR_EQ_M(a, b, msg, ...) ea__expect_ptr(a, b, ea__op_eq, msg, ##__VA_ARGS__)
+#define EXPECT_PTR_NE_M(a, b, msg, ...) ea__expect_ptr(a, b, ea__op_ne, msg, ##__VA_ARGS__)
+#define EXPECT_PTR_EQ(a, b) EXPECT_PTR_EQ_M(a, b, 0)
+#define EXPECT_PTR_NE(a, b) EXPECT_PTR_NE_M(a, b, 0)
+#define ea__expect_ptr_null(a, is_null, msg, ...) ((void)ea__assert_ptr_null_check(ea__current_test_info, a, is_null, #a, __FILE__, __LINE__, msg, ##__VA_ARGS__))
+#define EXPECT_PTR_NULL_M(a, msg, ...) ea__expect_ptr_null(a, 1, msg, ##__VA_ARGS__)
+#define EXPECT_PTR_NOTNULL_M(a, msg, ...) ea__expect_ptr_null(a, 0, msg, ##__VA_ARGS__)
+#define EXPECT_PTR_NULL(a) EXPECT_PTR_NULL_M(a, 0)
+#define EXPECT_PTR_NOTNULL(a) EXPECT_PTR_NOTNULL_M(a, 0)
+#define ea__expect_strz(a, b, op, msg, ...) ((void)ea__assert_str_check(ea__current_test_info, a, b, -1, op, #a, #b, __FILE__, __LINE__, msg, ##__VA_ARGS__))
+#define EXPECT_STRZ_EQ_M(a, b, msg, ...) ea__expect_strz(a, b, ea__op_eq, msg, ##__VA_ARGS__)
+#define EXPECT_STRZ_NE_M(a, b, msg, ...) ea__expect_strz(a, b, ea__op_ne, msg, ##__VA_ARGS__)
+#define EXPECT_STRZ_EQ(a, b) EXPECT_STRZ_EQ_M(a, b, 0)
+#define EXPECT_STRZ_NE(a, b) EXPECT_STRZ_NE_M(a, b, 0)
+#define ea__expect_strn(a, b, size, op, msg, ...) ((void)ea__assert_str_check(ea__current_test_info, a, b, size, op, #a, #b, __FILE__, __LINE__, msg, ##__VA_ARGS__))
+#define EXPECT_STRN_EQ_M(a, b, size, msg, ...) ea__expect_strn(a, b, size, ea__op_eq, msg, ##__VA_ARGS__)
+#define EXPECT_STRN_NE_M(a, b, size, msg, ...) ea__expect_strn(a, b, size, ea__op_ne, msg, ##__VA_ARGS__)
+#define EXPECT_STRN_EQ(a, b, size) EXPECT_STRN_EQ_M(a, b, size, 0)
+#define EXPECT_STRN_NE(a, b, size) EXPECT_STRN_NE_M(a, b, size, 0)
+#ifndef EA_NO_DOUBLE
+#define ea__expect_double(a, b, relative_tolerance, absolute_tolerance, op, msg, ...) ((void)ea__assert_double_check(ea__current_test_info, a, b, relative_tolerance, absolute_tolerance, op, #a, #b, __FILE__, __LINE__, msg, ##__VA_ARGS__))
+#define EXPECT_DOUBLE_EQ_M(a, b, msg, ...) ea__expect_double(a, b, ea_default_double_tolerance_rel, ea_default_double_tolerance_abs, ea__op_eq, msg, ##__VA_ARGS__)
+#define EXPECT_DOUBLE_NE_M(a, b, msg, ...) ea__expect_double(a, b, ea_default_double_tolerance_rel, ea_default_double_tolerance_abs, ea__op_ne, msg, ##__VA_ARGS__)
+#define EXPECT_DOUBLE_LT_M(a, b, msg, ...) ea__expect_double(a, b, ea_default_double_tolerance_rel, ea_default_double_tolerance_abs, ea__op_lt, msg, ##__VA_ARGS__)
+#define EXPECT_DOUBLE_LE_M(a, b, msg, ...) ea__expect_double(a, b, ea_default_double_tolerance_rel, ea_default_double_tolerance_abs, ea__op_le, msg, ##__VA_ARGS__)
+#define EXPECT_DOUBLE_GT_M(a, b, msg, ...) ea__expect_double(a, b, ea_default_double_tolerance_rel, ea_default_double_tolerance_abs, ea__op_gt, msg, ##__VA_ARGS__)
+#define EXPECT_DOUBLE_GE_M(a, b, msg, ...) ea__expect_double(a, b, ea_default_double_tolerance_rel, ea_default_double_tolerance_abs, ea__op_ge, msg, ##__VA_ARGS__)
+#define EXPECT_DOUBLE_EQ(a, b) EXPECT_DOUBLE_EQ_M(a, b, 0)
+#define EXPECT_DOUBLE_NE(a, b) EXPECT_DOUBLE_NE_M(a, b, 0)
+#define EXPECT_DOUBLE_LT(a, b) EXPECT_DOUBLE_LT_M(a, b, 0)
+#define EXPECT_DOUBLE_LE(a, b) EXPECT_DOUBLE_LE_M(a, b, 0)
+#define EXPECT_DOUBLE_GT(a, b) EXPECT_DOUBLE_GT_M(a, b, 0)
+#define EXPECT_DOUBLE_GE(a, b) EXPECT_DOUBLE_GE_M(a, b, 0)
+#endif // EA_NO_DOUBLE
+
+// comparison of values formatted by the caller (e.g. the C++ assertions of
+// expectoassertum.hpp), va and vb are only used if ok is zero
+int ea__assert_values_check(ea__test_info_t* test_info, int ok, const char* sa, const char* va, int op, const char* sb, const char* vb, const char* file, int line, const char* msg, ...);
+
+// link-time mocks: with the linker option --wrap=func (see ea_add_mocks() in
+// CMakeLists.txt) the calls of func from other object files go to the
+// wrapper defined by EA_MOCK(). The wrapper records the call in a fixed ring
+// buffer and returns a scripted value, or calls the real function if there
+// is none. Arguments are recorded as unsigned long long, so they have to be
+// of integer or pointer type (at most 8 of them). Calls and scripts are
+// reset before every test; mocks are not thread-safe.
+#ifndef EA_MOCK_RETURNS
+#define EA_MOCK_RETURNS 16 // scripted return values per mock and test
+#endif
+
+typedef struct ea__mock_s {
+	const char* name;
+	struct ea__mock_s* next; // mocks used so far, they are reset before each test
+	int used;
+	int calls; // calls in the current test
+	int returns; // scripted return values
+	int returned; // scripted return values used
+	int repeat; // the last scripted value is returned again when the script is used up
+	int stub; // without a scripted value, return zero instead of calling the real function
+} ea__mock_t;
+
+enum {
+	ea__mock_real = -1, // call the real function
+	ea__mock_zero = -2, // return a zero value
+};
+
+int ea__mock_call(ea__mock_t* mock, int argc, const unsigned long long* argv); // record a call, returns the scripted slot or ea__mock_real/zero
+int ea__mock_script(ea__mock_t* mock, int repeat); // slot of the next scripted return value
+void ea__mock_stub(ea__mock_t* mock);
+unsigned long long ea__mock_arg(const ea__mock_t* mock, int call, int index);
+int ea__mock_called_with_check(ea__test_info_t* test_info, const ea__mock_t* mock, int argc, const unsigned long long* argv, const char* sargs, const char* file, int line);
+
+#define ea__mock_cat(a, b) ea__mock_cat_(a, b)
+#define ea__mock_cat_(a, b) a##b
+#define ea__mock_argc(...) ea__mock_argc_(_, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define ea__mock_argc_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define ea__mock_value(x) ((unsigned long long)(x))
+#define ea__mock_values(...) ea__mock_cat(ea__mock_values_, ea__mock_argc(__VA_ARGS__))(__VA_ARGS__)
+#define ea__mock_values_0()
+#define ea__mock_values_1(a) ea__mock_value(a)
+#define ea__mock_values_2(a, b) ea__mock_value(a), ea__mock_value(b)
+#define ea__mock_values_3(a, b, c) ea__mock_values_2(a, b), ea__mock_value(c)
+#define ea__mock_values_4(a, b, c, d) ea__mock_values_3(a, b, c), ea__mock_value(d)
+#define ea__mock_values_5(a, b, c, d, e) ea__mock_values_4(a, b, c, d), ea__mock_value(e)
+#define ea__mock_values_6(a, b, c, d, e, f) ea__mock_values_5(a, b, c, d, e), ea__mock_value(f)
+#define ea__mock_values_7(a, b, c, d, e, f, g) ea__mock_values_6(a, b, c, d, e, f), ea__mock_value(g)
+#define ea__mock_values_8(a, b, c, d, e, f, g, h) ea__mock_values_7(a, b, c, d, e, f, g), ea__mock_value(h)
+#define ea__mock_record(func, args) \
+	const unsigned long long ea__mock_argv[] = { 0, ea__mock_values args }; \
+	int ea__mock_slot = ea__mock_call(&ea__mock_##func, ea__mock_argc args, ea__mock_argv + 1);
+
+/**
+ * @brief Macro to define the mock of a function returning a value, e.g.
+ * EA_MOCK(int, open_file, (const char* path, int flags), (path, flags)).
+ * params is the parameter list of the function, args the same names in
+ * parentheses. The function has to be wrapped at link time.
+ */
+#define EA_MOCK(ret, func, params, args) \
+	ret __real_##func params; \
+	ret __wrap_##func params; \
+	ea__mock_t ea__mock_##func = { #func, 0, 0, 0, 0, 0, 0, 0 }; \
+	ret ea__mock_returns_##func[EA_MOCK_RETURNS]; \
+	ret __wrap_##func params { \
+		ea__mock_record(func, args) \
+		if (ea__mock_slot >= 0) { \
+			return ea__mock_returns_##func[ea__mock_slot]; \
+		} \
+		if (ea__mock_slot == ea__mock_zero) { \
+			static ret ea__mock_zero_value; \
+			return ea__mock_zero_value; \
+		} \
+		return __real_##func args; \
+	}
+
+/**
+ * @brief Macro to define the mock of a function returning void, e.g.
+ * EA_MOCK_VOID(log_line, (const char* text), (text)).
+ */
+#define EA_MOCK_VOID(func, params, args) \
+	void __real_##func params; \
+	void __wrap_##func params; \
+	ea__mock_t ea__mock_##func = { #func, 0, 0, 0, 0, 0, 0, 0 }; \
+	void __wrap_##func params { \
+		ea__mock_record(func, args) \
+		if (ea__mock_slot == ea__mock_real) { \
+			__real_##func args; \
+		} \
+	}
+
+/**
+ * @brief Macros to use a mock defined in another source file.
+ */
+#define EA_MOCK_DECLARE(ret, func) extern ea__mock_t ea__mock_##func; extern ret ea__mock_returns_##func[EA_MOCK_RETURNS]
+#define EA_MOCK_DECLARE_VOID(func) extern ea__mock_t ea__mock_##func
+
+/**
+ * @brief Script the return values of a mock: the calls of the test return
+ * them in order, then the real function is called again. With
+ * EA_MOCK_RETURN_ALWAYS the value is returned by every later call. Scripting
+ * more than EA_MOCK_RETURNS values replaces the last one.
+ */
+#define EA_MOCK_RETURN(func, value) ((void)(ea__mock_returns_##func[ea__mock_script(&ea__mock_##func, 0)] = (value)))
+#define EA_MOCK_RETURN_ALWAYS(func, value) ((void)(ea__mock_returns_##func[ea__mock_script(&ea__mock_##func, 1)] = (value)))
+
+/**
+ * @brief Never call the real function in this test: calls without a scripted
+ * value return zero (or do nothing for a void function).
+ */
+#define EA_MOCK_STUB(func) ea__mock_stub(&ea__mock_##func)
+
+/**
+ * @brief Number of calls of a mock in the current test.
+ */
+#define EA_MOCK_CALLS(func) (ea__mock_##func.calls)
+
+/**
+ * @brief Argument (0-based index) of a call (0-based, negative counts from
+ * the last call) of a mock, as unsigned long long. 0 if the call was
+ * overwritten in the ring buffer or does not exist.
+ */
+#define EA_MOCK_ARG(func, call, index) ea__mock_arg(&ea__mock_##func, call, index)
+
+#define ASSERT_CALLED_TIMES(func, n) if (!ea__assert_int_check(ea__current_test_info, ea__mock_##func.calls, n, ea__op_eq, "calls of " #func, #n, __FILE__, __LINE__, 0)) return;
+#define ASSERT_NOT_CALLED(func) ASSERT_CALLED_TIMES(func, 0)
+// passes if a recorded call of the test had exactly these arguments; the
+// arguments are in a local array, C++ has no compound literals
+#define ASSERT_CALLED_WITH(func, ...) do { \
+	const unsigned long long ea__mock_expected[] = { 0, ea__mock_values(__VA_ARGS__) }; \
+	if (!ea__mock_called_with_check(ea__current_test_info, &ea__mock_##func, ea__mock_argc(__VA_ARGS__), ea__mock_expected + 1, #__VA_ARGS__, __FILE__, __LINE__)) return; \
+} while (0)
+
+// stack measurement (not available in a freestanding build)
+#ifndef EA_FREESTANDING
+
+/**
+ * @brief Macro to add a test with a stack budget to a group. The test runs on
+ * a dedicated stack, its stack usage is reported and it fails if it touches
+ * more than budget_bytes (see also the stack options of ea_set_option()).
+ */
+#define ea_test_add_stack(group, test, budget_bytes) ea__test_add_stack(group, ea__test_func_name(test), #test, __FILE__, ea__test_line_name(test), budget_bytes)
+
+void ea__test_add_stack(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line, int budget_bytes);
+
+#endif // EA_FREESTANDING
+
+// async tests (not available in a freestanding build)
+#ifndef EA_FREESTANDING
+
+/**
+ * @brief Macro to define an async test. Its body runs as a coroutine and can
+ * suspend with EA_AWAIT_READABLE(), EA_AWAIT_WRITABLE() and EA_SLEEP(), so the
+ * async tests of a group wait for I/O at the same time on one thread.
+ */
+#define ASYNC_TEST(name) TEST(name)
+
+/**
+ * @brief Macro to add an async test to a group. The async tests of a group are
+ * run together after its other tests, each reported when it finishes.
+ */
+#define ea_test_add_async(group, test) ea__test_add_async(group, ea__test_func_name(test), #test, __FILE__, ea__test_line_name(test))
+
+void ea__test_add_async(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line);
+
+/**
+ * @brief Suspend the test until the file descriptor is readable (writable).
+ * Outside of async tests (e.g. in worker processes) this blocks.
+ * @param timeout_ms Maximum time to wait, negative for no limit.
+ * @return 1 if the descriptor is ready, 0 on timeout, -1 on error.
+ */
+int ea_await_readable(ea__test_info_t* test_info, int fd, int timeout_ms);
+int ea_await_writable(ea__test_info_t* test_info, int fd, int timeout_ms);
+
+/**
+ * @brief Suspend the test for the given time.
+ */
+void ea_sleep_ms(ea__test_info_t* test_info, int ms);
+
+#define EA_AWAIT_READABLE(fd) ea_await_readable(ea__current_test_info, fd, -1)
+#define EA_AWAIT_WRITABLE(fd) ea_await_writable(ea__current_test_info, fd, -1)
+#define EA_SLEEP(ms) ea_sleep_ms(ea__current_test_info, ms)
+
+#endif // EA_FREESTANDING
+
+// property testing (not available in a freestanding build)
+#ifndef EA_FREESTANDING
+
+/**
+ * @brief Opaque type representing the generator state of a property case.
+ */
+typedef struct ea_prop_s ea_prop_t;
+
+#define ea__prop_func_name(name) ea__propfunc_ ## name
+
+/**
+ * @brief Macro to define a property. The body is run once per generated case
+ * and draws its inputs with the GEN_* macros. A failing case is shrunk to a
+ * minimal counterexample, which is printed together with the seed to replay it.
+ */
+#define PROPERTY(name) enum { ea__test_line_name(name) = __LINE__ }; \
+	static void ea__prop_func_name(name)(ea__test_info_t* ea__current_test_info, ea_prop_t* ea__current_prop)
+
+/**
+ * @brief Macro to add a property to a group with the default case count,
+ * time budget and thread count (see ea_set_option()).
+ */
+#define ea_property_add(group, prop) ea__property_add(group, ea__prop_func_name(prop), #prop, __FILE__, ea__test_line_name(prop), 0, 0, 0)
+
+/**
+ * @brief Macro to add a property to a group.
+ * @param cases Maximum number of cases to run, 0 for the default.
+ * @param time_budget_ms Stop generating cases after this time, 0 for the default.
+ * @param threads Number of threads running cases, 0 for the default. The
+ * property body must be thread safe if this is more than 1.
+ */
+#define ea_property_add_ex(group, prop, cases, time_budget_ms, threads) ea__property_add(group, ea__prop_func_name(prop), #prop, __FILE__, ea__test_line_name(prop), cases, time_budget_ms, threads)
+
+typedef void(*ea__prop_func_t)(ea__test_info_t*, ea_prop_t*);
+void ea__property_add(ea_group_t* group, ea__prop_func_t prop_func, const char* prop_name, const char* file, int line, int cases, int time_budget_ms, int threads);
+
+/**
+ * @brief Generate an integer in [min, max]. Shrinks towards the value closest to 0.
+ */
+long long ea_gen_int(ea_prop_t* prop, long long min, long long max);
+
+/**
+ * @brief Generate an unsigned integer in [min, max]. Shrinks towards min.
+ */
+unsigned long long ea_gen_uint(ea_prop_t* prop, unsigned long long min, unsigned long long max);
+
+#ifndef EA_NO_DOUBLE
+/**
+ * @brief Generate a finite double in [min, max]. Shrinks towards the value closest to 0.
+ */
+double ea_gen_double(ea_prop_t* prop, double min, double max);
+#endif
+
+/**
+ * @brief Fill buf with min_len to max_len random bytes. Shrinks towards
+ * shorter buffers with smaller bytes.
+ * @return Number of bytes generated.
+ */
+int ea_gen_bytes(ea_prop_t* prop, unsigned char* buf, int min_len, int max_len);
+
+/**
+ * @brief Fill buf (at least max_len+1 bytes) with a null-terminated string of
+ * at most max_len characters taken from alphabet (printable ASCII if NULL).
+ * Shrinks towards shorter strings made of the first characters of the alphabet.
+ * @return Length of the generated string.
+ */
+int ea_gen_str(ea_prop_t* prop, char* buf, int max_len, const char* alphabet);
+
+#define GEN_INT(min, max) ea_gen_int(ea__current_prop, min, max)
+#define GEN_UINT(min, max) ea_gen_uint(ea__current_prop, min, max)
+#ifndef EA_NO_DOUBLE
+#define GEN_DOUBLE(min, max) ea_gen_double(ea__current_prop, min, max)
+#endif
+#define GEN_BYTES(buf, min_len, max_len) ea_gen_bytes(ea__current_prop, buf, min_len, max_len)
+#define GEN_STR(buf, max_len, alphabet) ea_gen_str(ea__current_prop, buf, max_len, alphabet)
+
+#endif // EA_FREESTANDING
+
+// benchmarks (not available in a freestanding build)
+#ifndef EA_FREESTANDING
+
+/**
+ * @brief Opaque type representing the state of a running benchmark.
+ */
+typedef struct ea_bench_s ea_bench_t;
+
+/**
+ * @brief Complexity models fitted to the per-operation times of a benchmark
+ * run over a range of sizes, in increasing order.
+ */
+typedef enum {
+	EA_O_1 = 0,
+	EA_O_LOG_N,
+	EA_O_N,
+	EA_O_N_LOG_N,
+	EA_O_N_SQUARED,
+} ea_complexity_t;
+
+#define ea__bench_func_name(name) ea__benchfunc_ ## name
+
+/**
+ * @brief Macro to define a benchmark. The body is run for each size (see
+ * BENCH_N()) with an increasing iteration count until the timed loop takes
+ * long enough. Only the BENCH_LOOP() is timed, the rest of the body is setup.
+ * A body without BENCH_LOOP() is timed as a whole, as one operation.
+ */
+#define BENCHMARK(name) enum { ea__test_line_name(name) = __LINE__ }; \
+	static void ea__bench_func_name(name)(ea__test_info_t* ea__current_test_info, ea_bench_t* ea__current_bench)
+
+/**
+ * @brief Macro to add a benchmark run once, with BENCH_N() being 1.
+ */
+#define ea_benchmark_add(group, bench) ea__benchmark_add(group, ea__bench_func_name(bench), #bench, __FILE__, ea__test_line_name(bench), 1, 1)
+
+/**
+ * @brief Macro to add a benchmark run for the sizes min_n, 2*min_n, ... up to
+ * max_n. The ns/op (and bytes/op if set) of each size is reported together
+ * with the best fitting complexity model.
+ */
+#define ea_benchmark_add_range(group, bench, min_n, max_n) ea__benchmark_add(group, ea__bench_func_name(bench), #bench, __FILE__, ea__test_line_name(bench), min_n, max_n)
+
+typedef void(*ea__bench_func_t)(ea__test_info_t*, ea_bench_t*);
+void ea__benchmark_add(ea_group_t* group, ea__bench_func_t bench_func, const char* bench_name, const char* file, int line, long long min_n, long long max_n);
+
+/**
+ * @brief Current size of the benchmark.
+ */
+long long ea_bench_n(const ea_bench_t* bench);
+
+/**
+ * @brief Report bytes per operation at the current size, e.g. the memory a
+ * structure uses per element or the data an operation processes.
+ */
+void ea_bench_set_bytes(ea_bench_t* bench, long long bytes_per_op);
+
+/**
+ * @brief Fail the benchmark if its time per operation grows faster with the
+ * size than the given model. A slower growing fit, or a faster growing one
+ * that fits only slightly better (timing noise), passes.
+ */
+void ea_bench_expect_complexity(ea_bench_t* bench, ea_complexity_t complexity);
+
+/**
+ * @brief Prevent the compiler from optimizing away the computation of the
+ * value the pointer points to.
+ */
+void ea_bench_keep(const void* value);
+
+long long ea__bench_start(ea_bench_t* bench); // start the timer, returns the iteration count
+int ea__bench_stop(ea_bench_t* bench); // stop the timer, returns 0
+
+#define BENCH_N() ea_bench_n(ea__current_bench)
+#define BENCH_BYTES(bytes_per_op) ea_bench_set_bytes(ea__current_bench, bytes_per_op)
+#define BENCH_KEEP(value) ea_bench_keep(&(value))
+
+/**
+ * @brief Macro running the following statement the timed number of times,
+ * do not leave it with break or return.
+ */
+#define BENCH_LOOP() for (long long ea__bench_iter = ea__bench_start(ea__current_bench); \
+	(ea__bench_iter > 0) || ea__bench_stop(ea__current_bench); --ea__bench_iter)
+
+/**
+ * @brief Expect a complexity, e.g. EA_EXPECT_COMPLEXITY(O_N_LOG_N), see
+ * ea_bench_expect_complexity().
+ */
+#define EA_EXPECT_COMPLEXITY(complexity) ea_bench_expect_complexity(ea__current_bench, EA_ ## complexity)
+
+#endif // EA_FREESTANDING
+
+// concurrent tests (not available in a freestanding build)
+#ifndef EA_FREESTANDING
+
+/**
+ * @brief Opaque type representing a thread of a running concurrent test.
+ */
+typedef struct ea_concurrent_s ea_concurrent_t;
+
+#define ea__concurrent_func_name(name) ea__concurrentfunc_ ## name
+#define ea__concurrent_threads_name(name) ea__concurrentthreads_ ## name
+
+/**
+ * @brief Macro to define a concurrent test. The body is run on nthreads
+ * threads, started together from a spin barrier for maximum contention, each
+ * with its index (see THREAD_INDEX()). The assertion failures of every thread
+ * fail the test and are printed after the threads finished (the first of each
+ * thread). A failed assertion returns from the body of its thread only.
+ */
+#define TEST_CONCURRENT(name, nthreads) enum { ea__test_line_name(name) = __LINE__, ea__concurrent_threads_name(name) = (nthreads) }; \
+	static void ea__concurrent_func_name(name)(ea__test_info_t* ea__current_test_info, ea_concurrent_t* ea__current_concurrent)
+
+/**
+ * @brief Macro to add a concurrent test run once.
+ */
+#define ea_concurrent_add(group, test) ea__concurrent_add(group, ea__concurrent_func_name(test), #test, __FILE__, ea__test_line_name(test), ea__concurrent_threads_name(test), 1, 0)
+
+/**
+ * @brief Macro to add a concurrent test run for the given number of rounds.
+ * From the second round on, each thread waits a random short time after the
+ * barrier, so the threads meet in different interleavings. The throughput of
+ * each round is reported. The rounds stop at the first failure.
+ */
+#define ea_concurrent_add_rounds(group, test, rounds) ea__concurrent_add(group, ea__concurrent_func_name(test), #test, __FILE__, ea__test_line_name(test), ea__concurrent_threads_name(test), rounds, 0)
+
+/**
+ * @brief Like ea_concurrent_add_rounds(), with a test (defined with TEST())
+ * run on the calling thread after each round, e.g. to check and reset the
+ * shared structure.
+ */
+#define ea_concurrent_add_ex(group, test, rounds, after_round) ea__concurrent_add(group, ea__concurrent_func_name(test), #test, __FILE__, ea__test_line_name(test), ea__concurrent_threads_name(test), rounds, ea__test_func_name(after_round))
+
+typedef void(*ea__concurrent_func_t)(ea__test_info_t*, ea_concurrent_t*);
+void ea__concurrent_add(ea_group_t* group, ea__concurrent_func_t func, const char* test_name, const char* file, int line, int threads, int rounds, ea__test_func_t after_round);
+
+/**
+ * @brief Index of the thread, 0 to the thread count - 1.
+ */
+int ea_concurrent_thread(const ea_concurrent_t* concurrent);
+
+/**
+ * @brief Number of threads running the body.
+ */
+int ea_concurrent_thread_count(const ea_concurrent_t* concurrent);
+
+/**
+ * @brief Index of the round, from 0.
+ */
+int ea_concurrent_round(const ea_concurrent_t* concurrent);
+
+/**
+ * @brief Count operations done by the thread for the throughput of the round
+ * (operations per second across all threads). Without it, each body counts
+ * as one operation.
+ */
+void ea_concurrent_add_ops(ea_concurrent_t* concurrent, long long ops);
+
+#define THREAD_INDEX() ea_concurrent_thread(ea__current_concurrent)
+#define THREAD_COUNT() ea_concurrent_thread_count(ea__current_concurrent)
+#define CONCURRENT_ROUND() ea_concurrent_round(ea__current_concurrent)
+#define CONCURRENT_OPS(ops) ea_concurrent_add_ops(ea__current_concurrent, ops)
+
+#endif // EA_FREESTANDING
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif // EXPECTOASSERTUM_H_INCLUDED
@@ -0,0 +1,318 @@
+#ifndef EXPECTOASSERTUM_HPP_INCLUDED
+#define EXPECTOASSERTUM_HPP_INCLUDED
+
+/*
+ * C++ (14 or later) additions, on top of everything in expectoassertum.h:
+ *
+ * - ASSERT_EQ, ASSERT_NE, ASSERT_LT, ASSERT_LE, ASSERT_GT, ASSERT_GE (and the
+ *   _M forms with a message) compare the values with their own types and
+ *   operators (integers of different signedness are compared by value), a
+ *   failure prints them with ea::printer<T>. EXPECT_EQ ... EXPECT_GE are the
+ *   soft forms, the test goes on after a failure.
+ * - CONSTEXPR_TEST(name) defines a test whose body is evaluated at compile
+ *   time, a failing assertion is a compile error.
+ */
+
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "expectoassertum.h"
+
+namespace ea {
+
+/**
+ * @brief Prints values in assertion failures. The default uses operator<< if
+ * the type has one, specialize it for types that should print differently.
+ */
+template<class T, class Enable = void>
+struct printer;
+
+namespace detail {
+
+// printing
+
+template<class T, class = void>
+struct is_streamable : std::false_type {};
+template<class T>
+struct is_streamable<T, decltype(void(std::declval<std::ostream&>() << std::declval<const T&>()))> : std::true_type {};
+
+template<class T>
+void print_value(std::ostream& os, const T& value, std::true_type /*streamable*/) {
+	os << value;
+}
+
+template<class T>
+void print_value(std::ostream& os, const T& value, std::false_type /*streamable*/) {
+	// no printer, show the bytes
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+	static const char digits[] = "0123456789abcdef";
+	os << "<" << sizeof(T) << "-byte object";
+	for (std::size_t i = 0; i < sizeof(T); ++i) {
+		os << ((i == 0) ? ": " : " ") << digits[bytes[i] >> 4] << digits[bytes[i] & 15];
+	}
+	os << ">";
+}
+
+inline void print_string(std::ostream& os, const char* s) {
+	if (!s) {
+		os << "NULL";
+	}
+	else {
+		os << '"' << s << '"';
+	}
+}
+
+template<class T>
+std::string format(const T& value) {
+	std::ostringstream os;
+	printer<T>::print(os, value);
+	return os.str();
+}
+
+// comparison, integers of different signedness are compared by value
+
+template<class A, class B>
+struct both_integers : std::integral_constant<bool,
+	std::is_integral<A>::value && std::is_integral<B>::value
+	&& !std::is_same<A, bool>::value && !std::is_same<B, bool>::value> {};
+
+template<class T>
+constexpr bool is_negative(T value, std::true_type /*signed*/) { return value < 0; }
+template<class T>
+constexpr bool is_negative(T, std::false_type /*signed*/) { return false; }
+template<class T>
+constexpr bool is_negative(T value) { return is_negative(value, std::is_signed<T>()); }
+
+template<class A, class B>
+constexpr bool values_equal(const A& a, const B& b, std::true_type /*integers*/) {
+	return (is_negative(a) == is_negative(b)) && ((unsigned long long)a == (unsigned long long)b);
+}
+template<class A, class B>
+constexpr bool values_equal(const A& a, const B& b, std::false_type /*integers*/) { return a == b; }
+
+template<class A, class B>
+constexpr bool values_less(const A& a, const B& b, std::true_type /*integers*/) {
+	return (is_negative(a) != is_negative(b)) ? is_negative(a) : ((unsigned long long)a < (unsigned long long)b);
+}
+template<class A, class B>
+constexpr bool values_less(const A& a, const B& b, std::false_type /*integers*/) { return a < b; }
+
+template<class A, class B>
+constexpr bool values_less_equal(const A& a, const B& b, std::true_type integers) { return !detail::values_less(b, a, integers); }
+template<class A, class B>
+constexpr bool values_less_equal(const A& a, const B& b, std::false_type /*integers*/) { return a <= b; }
+
+template<class A, class B>
+constexpr bool values_not_equal(const A& a, const B& b, std::true_type integers) { return !detail::values_equal(a, b, integers); }
+template<class A, class B>
+constexpr bool values_not_equal(const A& a, const B& b, std::false_type /*integers*/) { return a != b; }
+
+// one type per operator, so only the operator being asserted has to exist
+struct op_eq {
+	static constexpr int op = ea__op_eq;
+	template<class A, class B> constexpr bool operator()(const A& a, const B& b) const { return detail::values_equal(a, b, both_integers<A, B>()); }
+};
+struct op_ne {
+	static constexpr int op = ea__op_ne;
+	template<class A, class B> constexpr bool operator()(const A& a, const B& b) const { return detail::values_not_equal(a, b, both_integers<A, B>()); }
+};
+struct op_lt {
+	static constexpr int op = ea__op_lt;
+	template<class A, class B> constexpr bool operator()(const A& a, const B& b) const { return detail::values_less(a, b, both_integers<A, B>()); }
+};
+struct op_le {
+	static constexpr int op = ea__op_le;
+	template<class A, class B> constexpr bool operator()(const A& a, const B& b) const { return detail::values_less_equal(a, b, both_integers<A, B>()); }
+};
+struct op_gt {
+	static constexpr int op = ea__op_gt;
+	template<class A, class B> constexpr bool operator()(const A& a, const B& b) const { return detail::values_less(b, a, both_integers<A, B>()); }
+};
+struct op_ge {
+	static constexpr int op = ea__op_ge;
+	template<class A, class B> constexpr bool operator()(const A& a, const B& b) const { return detail::values_less_equal(b, a, both_integers<A, B>()); }
+};
+
+// runtime assertion
+template<class Op, class A, class B, class... Args>
+bool check(ea__test_info_t* test_info, Op compare, const A& a, const B& b, const char* sa, const char* sb, const char* file, int line, const char* msg, Args... args) {
+	if (compare(a, b)) {
+		return ea__assert_values_check(test_info, 1, sa, nullptr, Op::op, sb, nullptr, file, line, nullptr) != 0;
+	}
+	std::string va = format(a), vb = format(b);
+	return ea__assert_values_check(test_info, 0, sa, va.c_str(), Op::op, sb, vb.c_str(), file, line, msg, args...) != 0;
+}
+
+/**
+ * @brief Runs the body of a CONSTEXPR_TEST, at compile time it only counts
+ * the assertions.
+ */
+class constexpr_checker {
+public:
+	constexpr constexpr_checker() : test_info(nullptr), count(0) {}
+	explicit constexpr_checker(ea__test_info_t* runtime_test_info) : test_info(runtime_test_info), count(0) {}
+
+	constexpr void passed() { count++; }
+	constexpr int assertion_count() const { return count; }
+
+	// not constexpr: reaching it during constant evaluation is the compile error
+	template<class Op, class A, class B, class... Args>
+	bool failed(const A& a, const B& b, const char* sa, const char* sb, const char* file, int line, const char* msg, Args... args) {
+		std::string va = format(a), vb = format(b);
+		ea__assert_values_check(test_info, 0, sa, va.c_str(), Op::op, sb, vb.c_str(), file, line, msg, args...);
+		return false;
+	}
+
+private:
+	ea__test_info_t* test_info;
+	int count;
+};
+
+template<class Op, class A, class B, class... Args>
+constexpr bool check(constexpr_checker& checker, Op compare, const A& a, const B& b, const char* sa, const char* sb, const char* file, int line, const char* msg, Args... args) {
+	return compare(a, b) ? (checker.passed(), true) : checker.failed<Op>(a, b, sa, sb, file, line, msg, args...);
+}
+
+typedef void (*constexpr_body_t)(constexpr_checker&);
+
+// number of assertions of a body, constant evaluation fails on a failed assertion
+constexpr int constexpr_evaluate(constexpr_body_t body) {
+	constexpr_checker checker;
+	body(checker);
+	return checker.assertion_count();
+}
+
+inline void constexpr_report(ea__test_info_t* test_info, constexpr_body_t body, int count) {
+#ifdef EA_CONSTEXPR_TESTS_AT_RUNTIME
+	// evaluate the body again, e.g. for coverage tools
+	(void)count;
+	constexpr_checker checker(test_info);
+	body(checker);
+	count = checker.assertion_count();
+#else
+	(void)body;
+#endif
+	for (int i = 0; i < count; ++i) {
+		ea__assert_values_check(test_info, 1, nullptr, nullptr, ea__op_eq, nullptr, nullptr, nullptr, 0, nullptr);
+	}
+}
+
+} // namespace detail
+
+template<class T, class Enable>
+struct printer {
+	static void print(std::ostream& os, const T& value) {
+		detail::print_value(os, value, detail::is_streamable<T>());
+	}
+};
+
+template<>
+struct printer<bool> {
+	static void print(std::ostream& os, bool value) { os << (value ? "true" : "false"); }
+};
+
+template<>
+struct printer<char> {
+	static void print(std::ostream& os, char value) { os << '\'' << value << "' (" << (int)value << ")"; }
+};
+
+// small integers are numbers, not characters
+template<>
+struct printer<signed char> {
+	static void print(std::ostream& os, signed char value) { os << (int)value; }
+};
+template<>
+struct printer<unsigned char> {
+	static void print(std::ostream& os, unsigned char value) { os << (unsigned)value; }
+};
+
+template<>
+struct printer<std::nullptr_t> {
+	static void print(std::ostream& os, std::nullptr_t) { os << "nullptr"; }
+};
+
+template<>
+struct printer<const char*> {
+	static void print(std::ostream& os, const char* value) { detail::print_string(os, value); }
+};
+template<>
+struct printer<char*> {
+	static void print(std::ostream& os, const char* value) { detail::print_string(os, value); }
+};
+template<std::size_t N>
+struct printer<char[N]> {
+	static void print(std::ostream& os, const char* value) { detail::print_string(os, value); }
+};
+
+template<>
+struct printer<std::string> {
+	static void print(std::ostream& os, const std::string& value) { os << '"' << value << '"'; }
+};
+
+// enums without operator<< print their value
+template<class T>
+struct printer<T, typename std::enable_if<std::is_enum<T>::value && !detail::is_streamable<T>::value>::type> {
+	static void print(std::ostream& os, T value) {
+		os << +static_cast<typename std::underlying_type<T>::type>(value);
+	}
+};
+
+} // namespace ea
+
+// assertions, also usable in CONSTEXPR_TEST bodies
+
+#define ea__assert_cmp(a, b, op, msg, ...) if (!::ea::detail::check(ea__current_test_info, ::ea::detail::op(), a, b, #a, #b, __FILE__, __LINE__, msg, ##__VA_ARGS__)) return;
+#define ASSERT_EQ_M(a, b, msg, ...) ea__assert_cmp(a, b, op_eq, msg, ##__VA_ARGS__)
+#define ASSERT_NE_M(a, b, msg, ...) ea__assert_cmp(a, b, op_ne, msg, ##__VA_ARGS__)
+#define ASSERT_LT_M(a, b, msg, ...) ea__assert_cmp(a, b, op_lt, msg, ##__VA_ARGS__)
+#define ASSERT_LE_M(a, b, msg, ...) ea__assert_cmp(a, b, op_le, msg, ##__VA_ARGS__)
+#define ASSERT_GT_M(a, b, msg, ...) ea__assert_cmp(a, b, op_gt, msg, ##__VA_ARGS__)
+#define ASSERT_GE_M(a, b, msg, ...) ea__assert_cmp(a, b, op_ge, msg, ##__VA_ARGS__)
+#define ASSERT_EQ(a, b) ASSERT_EQ_M(a, b, nullptr)
+#define ASSERT_NE(a, b) ASSERT_NE_M(a, b, nullptr)
+#define ASSERT_LT(a, b) ASSERT_LT_M(a, b, nullptr)
+#define ASSERT_LE(a, b) ASSERT_LE_M(a, b, nullptr)
+#define ASSERT_GT(a, b) ASSERT_GT_M(a, b, nullptr)
+#define ASSERT_GE(a, b) ASSERT_GE_M(a, b, nullptr)
+
+// soft assertions, the test goes on after a failure
+#define ea__expect_cmp(a, b, op, msg, ...) ((void)::ea::detail::check(ea__current_test_info, ::ea::detail::op(), a, b, #a, #b, __FILE__, __LINE__, msg, ##__VA_ARGS__))
+#define EXPECT_EQ_M(a, b, msg, ...) ea__expect_cmp(a, b, op_eq, msg, ##__VA_ARGS__)
+#define EXPECT_NE_M(a, b, msg, ...) ea__expect_cmp(a, b, op_ne, msg, ##__VA_ARGS__)
+#define EXPECT_LT_M(a, b, msg, ...) ea__expect_cmp(a, b, op_lt, msg, ##__VA_ARGS__)
+#define EXPECT_LE_M(a, b, msg, ...) ea__expect_cmp(a, b, op_le, msg, ##__VA_ARGS__)
+#define EXPECT_GT_M(a, b, msg, ...) ea__expect_cmp(a, b, op_gt, msg, ##__VA_ARGS__)
+#define EXPECT_GE_M(a, b, msg, ...) ea__expect_cmp(a, b, op_ge, msg, ##__VA_ARGS__)
+#define EXPECT_EQ(a, b) EXPECT_EQ_M(a, b, nullptr)
+#define EXPECT_NE(a, b) EXPECT_NE_M(a, b, nullptr)
+#define EXPECT_LT(a, b) EXPECT_LT_M(a, b, nullptr)
+#define EXPECT_LE(a, b) EXPECT_LE_M(a, b, nullptr)
+#define EXPECT_GT(a, b) EXPECT_GT_M(a, b, nullptr)
+#define EXPECT_GE(a, b) EXPECT_GE_M(a, b, nullptr)
+
+// compile-time tests
+
+#define ea__constexpr_body_name(name) ea__constexprbody_ ## name
+
+/**
+ * @brief Macro to define a test whose body is evaluated at compile time (it
+ * must be valid in a constexpr function), only the assertions above can be
+ * used in it. A failing assertion is a compile error at the assertion. The
+ * test is added with ea_test_add() like any other, at run time it reports
+ * the assertions checked at compile time without running the body again
+ * (define EA_CONSTEXPR_TESTS_AT_RUNTIME to run it, e.g. for coverage).
+ */
+#define CONSTEXPR_TEST(name) enum { ea__test_line_name(name) = __LINE__ }; \
+	static constexpr void ea__constexpr_body_name(name)(::ea::detail::constexpr_checker& ea__current_test_info); \
+	template<int ea__unused = 0> \
+	static void ea__test_func_name(name)(ea__test_info_t* ea__current_test_info) { \
+		constexpr int ea__count = ::ea::detail::constexpr_evaluate(ea__constexpr_body_name(name)); \
+		::ea::detail::constexpr_report(ea__current_test_info, ea__constexpr_body_name(name), ea__count); \
+	} \
+	static constexpr void ea__constexpr_body_name(name)(::ea::detail::constexpr_checker& ea__current_test_info)
+
+#endif // EXPECTOASSERTUM_HPP_INCLUDED
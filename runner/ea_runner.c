@@ -0,0 +1,659 @@
+/*
+ * ea_runner: runs the tests of many expectoassertum executables in parallel.
+ *
+ *   ea_runner [--jobs=<n>] [--pattern=<glob>] [--batch=<n>] [--report=<file>]
+ *             <executable or directory>... [-- <options for the executables>]
+ *
+ * Directories are searched recursively for executables whose name matches the
+ * pattern (default "*test*", CMakeFiles directories are skipped). Each
+ * executable is asked for its tests with --list=json, then the tests of all
+ * executables are run from one queue on <jobs> processes, <batch> tests of an
+ * executable per process (default 1, the async tests of a group together)
+ * selected with --filter and run with --capture. The output of
+ * each test is printed when its process finishes, followed by one summary;
+ * --report writes a JUnit XML report. The exit code is nonzero if a test
+ * failed or an executable could not be listed.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef RUNNER_MAX_JOBS
+#define RUNNER_MAX_JOBS 256
+#endif
+
+#ifndef RUNNER_PATH_MAX
+#define RUNNER_PATH_MAX 4096
+#endif
+
+enum {
+	status_pending = 0,
+	status_passed,
+	status_failed,
+	status_crashed,
+};
+
+typedef struct {
+	char* path;
+	int first_test; // index into tests
+	int test_count;
+} binary_t;
+
+typedef struct {
+	int binary;
+	char* name;
+	int async; // runs together with the other async tests of its group
+	int status;
+	unsigned long long ns;
+	char* output; // output of the test, not null-terminated
+	int output_len;
+} test_t;
+
+typedef struct {
+	char* data;
+	int len, cap;
+} buf_t;
+
+typedef struct {
+	pid_t pid; // 0 if free
+	int fd;
+	int first_test, count; // batch of tests of one binary
+	unsigned long long start_ns;
+	buf_t out;
+} proc_t;
+
+typedef struct {
+	// options
+	int jobs;
+	int batch;
+	const char* pattern;
+	const char* report;
+	char** passthrough;
+	int passthrough_count;
+
+	binary_t* binaries;
+	int binary_count, binary_cap;
+	test_t* tests;
+	int test_count, test_cap;
+	int list_errors;
+} runner_t;
+
+static void* xrealloc(void* p, size_t size) {
+	p = realloc(p, size);
+	if (!p) {
+		fprintf(stderr, "ea_runner: out of memory\n");
+		exit(2);
+	}
+	return p;
+}
+
+static char* xstrndup(const char* s, int len) {
+	char* copy = (char*)xrealloc(NULL, (size_t)len + 1);
+	memcpy(copy, s, (size_t)len);
+	copy[len] = '\0';
+	return copy;
+}
+
+static void buf_append(buf_t* buf, const char* data, int len) {
+	if (buf->len + len + 1 > buf->cap) {
+		int cap = buf->cap ? buf->cap * 2 : 4096;
+		while (cap < buf->len + len + 1) {
+			cap *= 2;
+		}
+		buf->data = (char*)xrealloc(buf->data, (size_t)cap);
+		buf->cap = cap;
+	}
+	memcpy(buf->data + buf->len, data, (size_t)len);
+	buf->len += len;
+	buf->data[buf->len] = '\0';
+}
+
+static unsigned long long now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+static const char* base_name(const char* path) {
+	const char* slash = strrchr(path, '/');
+	return slash ? slash + 1 : path;
+}
+
+// finding executables
+
+static void add_binary(runner_t* r, const char* path) {
+	if (r->binary_count == r->binary_cap) {
+		r->binary_cap = r->binary_cap ? r->binary_cap * 2 : 16;
+		r->binaries = (binary_t*)xrealloc(r->binaries, sizeof(binary_t) * (size_t)r->binary_cap);
+	}
+	binary_t* b = &r->binaries[r->binary_count++];
+	b->path = xstrndup(path, (int)strlen(path));
+	b->first_test = 0;
+	b->test_count = 0;
+}
+
+static int compare_names(const void* a, const void* b) {
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static void find_binaries(runner_t* r, const char* dir) {
+	DIR* d = opendir(dir);
+	if (!d) {
+		fprintf(stderr, "ea_runner: cannot open %s\n", dir);
+		r->list_errors++;
+		return;
+	}
+	// sorted, so the run order does not depend on the file system
+	char** names = NULL;
+	int count = 0, cap = 0;
+	struct dirent* e;
+	while ((e = readdir(d)) != NULL) {
+		if ((e->d_name[0] == '.') || (strcmp(e->d_name, "CMakeFiles") == 0)) {
+			continue;
+		}
+		if (count == cap) {
+			cap = cap ? cap * 2 : 32;
+			names = (char**)xrealloc(names, sizeof(char*) * (size_t)cap);
+		}
+		names[count++] = xstrndup(e->d_name, (int)strlen(e->d_name));
+	}
+	closedir(d);
+	qsort(names, (size_t)count, sizeof(char*), compare_names);
+
+	char path[RUNNER_PATH_MAX];
+	for (int i = 0; i < count; ++i) {
+		struct stat st;
+		if ((snprintf(path, sizeof(path), "%s/%s", dir, names[i]) < (int)sizeof(path)) && (stat(path, &st) == 0)) {
+			if (S_ISDIR(st.st_mode)) {
+				find_binaries(r, path);
+			}
+			else if (S_ISREG(st.st_mode) && (access(path, X_OK) == 0) && (fnmatch(r->pattern, names[i], 0) == 0)) {
+				add_binary(r, path);
+			}
+		}
+		free(names[i]);
+	}
+	free(names);
+}
+
+// processes
+
+// runs the executable with the NULL-terminated extra_args and the passed on options
+static pid_t spawn(runner_t* r, const char* path, const char* const* extra_args, int* fd) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return -1;
+	}
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return -1;
+	}
+	if (pid == 0) {
+		int devnull = open("/dev/null", O_RDONLY);
+		if (devnull >= 0) {
+			dup2(devnull, 0);
+			close(devnull);
+		}
+		dup2(fds[1], 1);
+		dup2(fds[1], 2);
+		close(fds[0]);
+		close(fds[1]);
+		int extra_count = 0;
+		while (extra_args[extra_count]) {
+			extra_count++;
+		}
+		char** argv = (char**)xrealloc(NULL, sizeof(char*) * (size_t)(r->passthrough_count + extra_count + 2));
+		int argc = 0;
+		argv[argc++] = (char*)path;
+		for (int i = 0; i < extra_count; ++i) {
+			argv[argc++] = (char*)extra_args[i];
+		}
+		for (int i = 0; i < r->passthrough_count; ++i) {
+			argv[argc++] = r->passthrough[i];
+		}
+		argv[argc] = NULL;
+		execv(path, argv);
+		fprintf(stderr, "ea_runner: cannot execute %s: %s\n", path, strerror(errno));
+		_exit(127);
+	}
+	close(fds[1]);
+	*fd = fds[0];
+	return pid;
+}
+
+static int read_all(int fd, buf_t* out) {
+	char chunk[4096];
+	ssize_t n;
+	while (((n = read(fd, chunk, sizeof(chunk))) < 0) && (errno == EINTR)) {
+	}
+	if (n > 0) {
+		buf_append(out, chunk, (int)n);
+	}
+	return n > 0;
+}
+
+// listing
+
+static void add_test(runner_t* r, int binary, char* name) {
+	if (r->test_count == r->test_cap) {
+		r->test_cap = r->test_cap ? r->test_cap * 2 : 256;
+		r->tests = (test_t*)xrealloc(r->tests, sizeof(test_t) * (size_t)r->test_cap);
+	}
+	test_t* t = &r->tests[r->test_count++];
+	memset(t, 0, sizeof(test_t));
+	t->binary = binary;
+	t->name = name;
+}
+
+// parse a JSON string starting after the opening quote, returns a copy
+static char* parse_json_string(const char* p, const char** end) {
+	buf_t s = { 0 };
+	while (*p && (*p != '"')) {
+		char c = *p++;
+		if ((c == '\\') && *p) {
+			c = *p++;
+			if (c == 'u') {
+				c = (char)strtol(p, NULL, 16); // the list only escapes control characters
+				p += (strlen(p) >= 4) ? 4 : strlen(p);
+			}
+			else if (c == 'n') {
+				c = '\n';
+			}
+		}
+		buf_append(&s, &c, 1);
+	}
+	*end = *p ? p + 1 : p;
+	return s.data ? s.data : xstrndup("", 0);
+}
+
+static void list_binary(runner_t* r, int index) {
+	binary_t* b = &r->binaries[index];
+	b->first_test = r->test_count;
+	int fd;
+	const char* args[] = { "--list=json", NULL };
+	pid_t pid = spawn(r, b->path, args, &fd);
+	if (pid < 0) {
+		fprintf(stderr, "ea_runner: cannot run %s\n", b->path);
+		r->list_errors++;
+		return;
+	}
+	buf_t out = { 0 };
+	while (read_all(fd, &out)) {
+	}
+	close(fd);
+	int status = 0;
+	waitpid(pid, &status, 0);
+	const char* p = out.data ? strstr(out.data, "{\"tests\":") : NULL;
+	if (!WIFEXITED(status) || !p) {
+		fprintf(stderr, "ea_runner: cannot list the tests of %s\n", b->path);
+		r->list_errors++;
+	}
+	while (p && ((p = strstr(p, "{\"name\": \"")) != NULL)) {
+		add_test(r, index, parse_json_string(p + 10, &p));
+		const char* eol = strchr(p, '\n');
+		const char* async = strstr(p, "\"async\": true");
+		r->tests[r->test_count - 1].async = async && (!eol || (async < eol));
+	}
+	b->test_count = r->test_count - b->first_test;
+	free(out.data);
+}
+
+// running
+
+// length of the group part of a test name
+static int group_len(const char* name) {
+	const char* slash = strrchr(name, '/');
+	return slash ? (int)(slash - name) : 0;
+}
+
+static int same_group(const test_t* a, const test_t* b) {
+	int len = group_len(a->name);
+	return (a->binary == b->binary) && (len == group_len(b->name)) && (strncmp(a->name, b->name, (size_t)len) == 0);
+}
+
+static void start_batch(runner_t* r, proc_t* proc, int first_test) {
+	test_t* first = &r->tests[first_test];
+	int count = 1;
+	while ((count < r->batch) && (first_test + count < r->test_count) && (first[count].binary == first->binary)) {
+		count++;
+	}
+
+	// the async tests of a group may depend on each other (e.g. a reader and
+	// a writer), so the rest of a group with an async test joins the batch;
+	// the list has the tests of a group next to each other
+	int async = 0;
+	for (int i = 0; i < count; ++i) {
+		async |= first[i].async && same_group(&first[i], &first[count - 1]);
+	}
+	for (int i = count; !async && (first_test + i < r->test_count) && same_group(&first[i], &first[count - 1]); ++i) {
+		async = first[i].async;
+	}
+	while (async && (first_test + count < r->test_count) && same_group(&first[count], &first[count - 1])) {
+		count++;
+	}
+	buf_t filter = { 0 };
+	buf_append(&filter, "--filter=", 9);
+	for (int i = 0; i < count; ++i) {
+		if (i) {
+			buf_append(&filter, ",", 1);
+		}
+		buf_append(&filter, first[i].name, (int)strlen(first[i].name));
+	}
+	proc->first_test = first_test;
+	proc->count = count;
+	proc->out.len = 0;
+	proc->start_ns = now_ns();
+	// with captured output the result line directly follows the test name
+	const char* args[] = { filter.data, "--capture", NULL };
+	proc->pid = spawn(r, r->binaries[first->binary].path, args, &proc->fd);
+	free(filter.data);
+	if (proc->pid < 0) {
+		proc->pid = 0;
+		for (int i = 0; i < count; ++i) {
+			first[i].status = status_crashed;
+		}
+	}
+}
+
+// find the result line of a test: its name at the start of a line followed by " => "
+static char* find_result_line(char* out, const char* name) {
+	int len = (int)strlen(name);
+	for (char* line = out; line && *line; ) {
+		if ((strncmp(line, name, (size_t)len) == 0) && (line[len] == ' ')) {
+			char* arrow = strstr(line + len, " => ");
+			char* eol = strchr(line, '\n');
+			if (arrow && (!eol || (arrow < eol))) {
+				return line;
+			}
+		}
+		line = strchr(line, '\n');
+		line = line ? line + 1 : NULL;
+	}
+	return NULL;
+}
+
+// the summary printed by ea_run() ends the output of the last test
+static char* find_summary(char* from) {
+	for (char* line = from; line && *line; ) {
+		int n = 0;
+		if ((strncmp(line, "All ", 4) == 0) || ((sscanf(line, "%*d test(s)%n", &n) == 0) && (n > 0))) {
+			return line;
+		}
+		line = strchr(line, '\n');
+		line = line ? line + 1 : NULL;
+	}
+	return NULL;
+}
+
+static void finish_batch(runner_t* r, proc_t* proc) {
+	int status = 0;
+	waitpid(proc->pid, &status, 0);
+	close(proc->fd);
+	proc->pid = 0;
+	unsigned long long ns = now_ns() - proc->start_ns;
+	char* out = proc->out.data ? proc->out.data : (char*)"";
+	for (int i = 0; i < proc->count; ++i) {
+		test_t* t = &r->tests[proc->first_test + i];
+		t->ns = ns / (unsigned long long)proc->count;
+		char* line = find_result_line(out, t->name);
+		if (!line) {
+			// no result: the process died before or while running the test
+			t->status = status_crashed;
+			if (WIFSIGNALED(status)) {
+				printf("%s => CRASHED (signal %d)\n", t->name, WTERMSIG(status));
+			}
+			else {
+				printf("%s => CRASHED (no result, exit code %d)\n", t->name, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+			}
+			continue;
+		}
+		char* arrow = strstr(line, " => ");
+		t->status = (strncmp(arrow + 4, "OK", 2) == 0) ? status_passed : status_failed;
+
+		// the output of the test runs until the next result line or the summary
+		char* end = NULL;
+		for (char* next = strchr(line, '\n'); next && *++next; next = strchr(next, '\n')) {
+			int is_result = 0;
+			for (int j = 0; j < proc->count; ++j) {
+				is_result |= (next == find_result_line(next, r->tests[proc->first_test + j].name));
+			}
+			if (is_result || (next == find_summary(next))) {
+				end = next;
+				break;
+			}
+		}
+		if (!end) {
+			end = line + strlen(line);
+		}
+		t->output = xstrndup(line, (int)(end - line));
+		t->output_len = (int)(end - line);
+		fwrite(t->output, 1, (size_t)t->output_len, stdout);
+	}
+	fflush(stdout);
+}
+
+static void run_tests(runner_t* r) {
+	proc_t procs[RUNNER_MAX_JOBS];
+	memset(procs, 0, sizeof(procs));
+	int next = 0, running = 0;
+	while ((next < r->test_count) || running) {
+		// fill the free slots
+		for (int i = 0; (i < r->jobs) && (next < r->test_count); ++i) {
+			if (!procs[i].pid) {
+				start_batch(r, &procs[i], next);
+				next += procs[i].count;
+				running += (procs[i].pid != 0);
+			}
+		}
+
+		// read output, finish processes at end of file
+		struct pollfd fds[RUNNER_MAX_JOBS];
+		int slots[RUNNER_MAX_JOBS];
+		int n = 0;
+		for (int i = 0; i < r->jobs; ++i) {
+			if (procs[i].pid) {
+				fds[n].fd = procs[i].fd;
+				fds[n].events = POLLIN;
+				fds[n].revents = 0;
+				slots[n++] = i;
+			}
+		}
+		if (!n) {
+			continue;
+		}
+		if (poll(fds, (nfds_t)n, -1) < 0) {
+			continue;
+		}
+		for (int i = 0; i < n; ++i) {
+			if (fds[i].revents && !read_all(fds[i].fd, &procs[slots[i]].out)) {
+				finish_batch(r, &procs[slots[i]]);
+				running--;
+			}
+		}
+	}
+	for (int i = 0; i < RUNNER_MAX_JOBS; ++i) {
+		free(procs[i].out.data);
+	}
+}
+
+// report
+
+static void write_xml_escaped(FILE* f, const char* s, int len) {
+	for (int i = 0; i < len; ++i) {
+		unsigned char c = (unsigned char)s[i];
+		switch (c) {
+		case '<': fputs("&lt;", f); break;
+		case '>': fputs("&gt;", f); break;
+		case '&': fputs("&amp;", f); break;
+		case '"': fputs("&quot;", f); break;
+		default:
+			if ((c < 0x20) && (c != '\n') && (c != '\t')) {
+				fputc('?', f);
+			}
+			else {
+				fputc(c, f);
+			}
+			break;
+		}
+	}
+}
+
+static void write_report(runner_t* r, int failed, unsigned long long ns) {
+	FILE* f = fopen(r->report, "wb");
+	if (!f) {
+		fprintf(stderr, "ea_runner: cannot write %s\n", r->report);
+		return;
+	}
+	fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	fprintf(f, "<testsuites tests=\"%d\" failures=\"%d\" time=\"%.3f\">\n", r->test_count, failed, (double)ns / 1e9);
+	for (int b = 0; b < r->binary_count; ++b) {
+		const binary_t* binary = &r->binaries[b];
+		int binary_failed = 0;
+		for (int i = 0; i < binary->test_count; ++i) {
+			binary_failed += (r->tests[binary->first_test + i].status != status_passed);
+		}
+		fprintf(f, "  <testsuite name=\"");
+		write_xml_escaped(f, binary->path, (int)strlen(binary->path));
+		fprintf(f, "\" tests=\"%d\" failures=\"%d\">\n", binary->test_count, binary_failed);
+		for (int i = 0; i < binary->test_count; ++i) {
+			const test_t* t = &r->tests[binary->first_test + i];
+			fprintf(f, "    <testcase classname=\"");
+			write_xml_escaped(f, base_name(binary->path), (int)strlen(base_name(binary->path)));
+			fprintf(f, "\" name=\"");
+			write_xml_escaped(f, t->name, (int)strlen(t->name));
+			fprintf(f, "\" time=\"%.6f\"", (double)t->ns / 1e9);
+			if (t->status == status_passed) {
+				fprintf(f, "/>\n");
+				continue;
+			}
+			fprintf(f, ">\n      <failure message=\"%s\">", (t->status == status_crashed) ? "crashed" : "failed");
+			write_xml_escaped(f, t->output ? t->output : "", t->output_len);
+			fprintf(f, "</failure>\n    </testcase>\n");
+		}
+		fprintf(f, "  </testsuite>\n");
+	}
+	fprintf(f, "</testsuites>\n");
+	fclose(f);
+}
+
+// main
+
+static void usage(void) {
+	fprintf(stderr, "usage: ea_runner [--jobs=<n>] [--pattern=<glob>] [--batch=<n>] [--report=<file>]\n"
+		"                 <executable or directory>... [-- <options for the executables>]\n");
+}
+
+int main(int argc, char** argv) {
+	runner_t r;
+	memset(&r, 0, sizeof(r));
+	r.pattern = "*test*";
+	r.batch = 1;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	r.jobs = (cpus > 0) ? (int)cpus : 1;
+
+	int paths = 0;
+	for (int i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+		if (strcmp(arg, "--") == 0) {
+			r.passthrough = argv + i + 1;
+			r.passthrough_count = argc - i - 1;
+			break;
+		}
+		if (strncmp(arg, "--jobs=", 7) == 0) {
+			r.jobs = atoi(arg + 7);
+		}
+		else if (strncmp(arg, "--batch=", 8) == 0) {
+			r.batch = atoi(arg + 8);
+		}
+		else if (strncmp(arg, "--pattern=", 10) == 0) {
+			r.pattern = arg + 10;
+		}
+		else if (strncmp(arg, "--report=", 9) == 0) {
+			r.report = arg + 9;
+		}
+		else if ((arg[0] == '-') && (arg[1] == '-')) {
+			usage();
+			return 2;
+		}
+		else {
+			struct stat st;
+			if (stat(arg, &st) != 0) {
+				fprintf(stderr, "ea_runner: cannot find %s\n", arg);
+				r.list_errors++;
+			}
+			else if (S_ISDIR(st.st_mode)) {
+				find_binaries(&r, arg);
+			}
+			else {
+				add_binary(&r, arg);
+			}
+			paths++;
+		}
+	}
+	if (!paths) {
+		usage();
+		return 2;
+	}
+	if (r.jobs < 1) r.jobs = 1;
+	if (r.jobs > RUNNER_MAX_JOBS) r.jobs = RUNNER_MAX_JOBS;
+	if (r.batch < 1) r.batch = 1;
+	signal(SIGPIPE, SIG_IGN);
+
+	unsigned long long start_ns = now_ns();
+	for (int i = 0; i < r.binary_count; ++i) {
+		list_binary(&r, i);
+	}
+	printf("Running %d test(s) from %d executable(s) on %d job(s)\n", r.test_count, r.binary_count, r.jobs);
+	fflush(stdout);
+	run_tests(&r);
+	unsigned long long ns = now_ns() - start_ns;
+
+	// summary
+	int failed = 0;
+	for (int i = 0; i < r.test_count; ++i) {
+		failed += (r.tests[i].status != status_passed);
+	}
+	if (failed == 0) {
+		printf("All %d tests passed.\n", r.test_count);
+	}
+	else {
+		printf("%d test(s) out of %d failed:\n", failed, r.test_count);
+		for (int i = 0; i < r.test_count; ++i) {
+			const test_t* t = &r.tests[i];
+			if (t->status != status_passed) {
+				printf("  %s: %s%s\n", base_name(r.binaries[t->binary].path), t->name, (t->status == status_crashed) ? " (crashed)" : "");
+			}
+		}
+	}
+	if (r.list_errors) {
+		printf("%d executable(s) could not be listed.\n", r.list_errors);
+	}
+	printf("Finished in %llu.%llu s.\n", ns / 1000000000ull, ns / 100000000ull % 10);
+	if (r.report) {
+		write_report(&r, failed, ns);
+	}
+
+	for (int i = 0; i < r.test_count; ++i) {
+		free(r.tests[i].name);
+		free(r.tests[i].output);
+	}
+	for (int i = 0; i < r.binary_count; ++i) {
+		free(r.binaries[i].path);
+	}
+	free(r.tests);
+	free(r.binaries);
+	return (failed || r.list_errors) ? 1 : 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * ea_selfbench: measures the overhead of expectoassertum itself.
+ *
+ *   ea_selfbench [--max=<tests>] [--count=<n>] [--bench=<substring>]
+ *
+ * Synthetic suites of 10^3 up to <max> (default 10^6) empty tests are built in
+ * a wide tree (groups of 10 tests under the root) and a deep one (a binary
+ * tree of groups with one test each). For each suite the registration, the
+ * selection (every test filtered out), the run and the release are timed per
+ * test; matching against long filter lists and the passing assertions of each
+ * kind are timed on their own. The framework output goes to a discarding
+ * sink, so formatting counts but terminal I/O does not.
+ *
+ * The results are printed in the Go benchmark format, one line per
+ * measurement, e.g. "BenchmarkRun/wide/tests=1000  1000  85.31 ns/op", so two
+ * builds can be compared with benchstat. --count repeats every measurement,
+ * --bench runs the ones whose name contains the substring.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "expectoassertum.h"
+
+#ifndef SELFBENCH_DEFAULT_MAX
+#define SELFBENCH_DEFAULT_MAX 1000000
+#endif
+
+// tests per group of the wide tree, and of the suite the filter lists run on
+#define WIDE_GROUP_SIZE 10
+#define FILTER_SUITE_TESTS 10000
+
+// room for a group name of the wide tree
+#define NAME_LEN 24
+
+// passing assertions per kind
+#define ASSERT_ITERATIONS 1000000
+
+static const char* bench_filter = NULL;
+
+static unsigned long long now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+static void discard_output(const char* data, int len, void* opaque) {
+	(void)data;
+	(void)len;
+	(void)opaque;
+}
+
+static int wanted(const char* name) {
+	return !bench_filter || strstr(name, bench_filter);
+}
+
+static void report(const char* name, long long ops, unsigned long long ns) {
+	printf("Benchmark%s\t%lld\t%.2f ns/op\n", name, ops, (double)ns / (double)ops);
+	fflush(stdout);
+}
+
+TEST(empty) {
+	(void)ea__current_test_info;
+}
+
+// suites
+
+typedef enum {
+	shape_wide,
+	shape_deep,
+} shape_t;
+
+static const char* const shape_names[] = { "wide", "deep" };
+
+typedef struct {
+	ea_group_t* root;
+	char* names; // pool of the group names of the wide tree
+} suite_t;
+
+static void add_test(ea_group_t* group, const char* name) {
+	ea__test_add(group, ea__test_func_name(empty), name, __FILE__, ea__test_line_name(empty));
+}
+
+// binary tree of groups "a" and "b" with one test each, in breadth-first order
+static void build_deep(ea_group_t* root, long long tests) {
+	ea_group_t** groups = (ea_group_t**)malloc(sizeof(ea_group_t*) * (size_t)tests);
+	groups[0] = root;
+	add_test(root, "t");
+	for (long long i = 1; i < tests; ++i) {
+		groups[i] = ea_group_create(groups[(i - 1) / 2], (i % 2) ? "a" : "b");
+		add_test(groups[i], "t");
+	}
+	free(groups);
+}
+
+static void build_wide(ea_group_t* root, long long tests, char* names) {
+	static const char* const test_names[WIDE_GROUP_SIZE] = { "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7", "t8", "t9" };
+	for (long long g = 0; g < tests / WIDE_GROUP_SIZE; ++g) {
+		ea_group_t* group = ea_group_create(root, names + g * NAME_LEN);
+		for (int t = 0; t < WIDE_GROUP_SIZE; ++t) {
+			add_test(group, test_names[t]);
+		}
+	}
+}
+
+// the group names, not timed
+static void suite_prepare(suite_t* suite, shape_t shape, long long tests) {
+	suite->root = NULL;
+	suite->names = NULL;
+	if (shape == shape_wide) {
+		suite->names = (char*)malloc((size_t)(tests / WIDE_GROUP_SIZE) * NAME_LEN);
+		for (long long g = 0; g < tests / WIDE_GROUP_SIZE; ++g) {
+			snprintf(suite->names + g * NAME_LEN, NAME_LEN, "g%lld", g);
+		}
+	}
+}
+
+static void suite_build(suite_t* suite, shape_t shape, long long tests) {
+	suite->root = ea_create_root();
+	if (shape == shape_wide) {
+		build_wide(suite->root, tests, suite->names);
+	}
+	else {
+		build_deep(suite->root, tests);
+	}
+}
+
+// registration, selection, run and release of a suite
+static void bench_suite(shape_t shape, long long tests) {
+	char name[128];
+	suite_t suite;
+	suite_prepare(&suite, shape, tests);
+
+	unsigned long long start = now_ns();
+	suite_build(&suite, shape, tests);
+	unsigned long long ns = now_ns() - start;
+	snprintf(name, sizeof(name), "Register/%s/tests=%lld", shape_names[shape], tests);
+	if (wanted(name)) {
+		report(name, tests, ns);
+	}
+
+	snprintf(name, sizeof(name), "Select/%s/tests=%lld", shape_names[shape], tests);
+	if (wanted(name)) {
+		start = now_ns();
+		ea_run(suite.root, "nomatch/*");
+		report(name, tests, now_ns() - start);
+	}
+
+	snprintf(name, sizeof(name), "Run/%s/tests=%lld", shape_names[shape], tests);
+	if (wanted(name)) {
+		start = now_ns();
+		ea_run(suite.root, NULL);
+		report(name, tests, now_ns() - start);
+	}
+
+	start = now_ns();
+	ea_release_group(suite.root);
+	ns = now_ns() - start;
+	snprintf(name, sizeof(name), "Release/%s/tests=%lld", shape_names[shape], tests);
+	if (wanted(name)) {
+		report(name, tests, ns);
+	}
+	free(suite.names);
+}
+
+// selection with lists of filters that match no test, per test
+static void bench_filters(long long tests) {
+	static const int filter_counts[] = { 1, 10, 100, 1000 };
+	suite_t suite;
+	suite_prepare(&suite, shape_wide, tests);
+	suite_build(&suite, shape_wide, tests);
+	for (int i = 0; i < (int)(sizeof(filter_counts) / sizeof(filter_counts[0])); ++i) {
+		int count = filter_counts[i];
+		char name[128];
+		snprintf(name, sizeof(name), "Filter/filters=%d/tests=%lld", count, tests);
+		if (!wanted(name)) {
+			continue;
+		}
+		// exact, prefix, suffix and negated prefix filters in turn
+		char* filters = (char*)malloc((size_t)count * 24);
+		int len = 0;
+		for (int f = 0; f < count; ++f) {
+			switch (f % 4) {
+			case 0: len += sprintf(filters + len, "%sx%d/t0", f ? "," : "", f); break;
+			case 1: len += sprintf(filters + len, ",x%d/*", f); break;
+			case 2: len += sprintf(filters + len, ",*/x%d", f); break;
+			default: len += sprintf(filters + len, ",~x%d/*", f); break;
+			}
+		}
+		unsigned long long start = now_ns();
+		ea_run(suite.root, filters);
+		report(name, tests, now_ns() - start);
+		free(filters);
+	}
+	ea_release_group(suite.root);
+	free(suite.names);
+}
+
+// passing assertions
+
+static volatile long long assert_iterations = ASSERT_ITERATIONS;
+
+TEST(assert_bool) {
+	for (long long i = 0; i < assert_iterations; ++i) {
+		ASSERT_TRUE(assert_iterations);
+	}
+}
+
+TEST(assert_int) {
+	for (long long i = 0; i < assert_iterations; ++i) {
+		ASSERT_INT_EQ(i, i);
+	}
+}
+
+TEST(assert_uint) {
+	for (unsigned long long i = 0; i < (unsigned long long)assert_iterations; ++i) {
+		ASSERT_UINT_LE(i, i);
+	}
+}
+
+TEST(assert_ptr) {
+	for (long long i = 0; i < assert_iterations; ++i) {
+		ASSERT_PTR_NOTNULL(&i);
+	}
+}
+
+TEST(assert_strz) {
+	for (long long i = 0; i < assert_iterations; ++i) {
+		ASSERT_STRZ_EQ("expectoassertum", "expectoassertum");
+	}
+}
+
+TEST(assert_strn) {
+	for (long long i = 0; i < assert_iterations; ++i) {
+		ASSERT_STRN_EQ("expecto", "expectoassertum", 7);
+	}
+}
+
+#ifndef EA_NO_DOUBLE
+TEST(assert_double) {
+	for (long long i = 0; i < assert_iterations; ++i) {
+		ASSERT_DOUBLE_EQ((double)i, (double)i + 1e-12);
+	}
+}
+#endif
+
+static void bench_assertions(void) {
+	ea_group_t* root = ea_create_root();
+	ea_group_t* group = ea_group_create(root, "Assert");
+	ea_test_add(group, assert_bool);
+	ea_test_add(group, assert_int);
+	ea_test_add(group, assert_uint);
+	ea_test_add(group, assert_ptr);
+	ea_test_add(group, assert_strz);
+	ea_test_add(group, assert_strn);
+#ifndef EA_NO_DOUBLE
+	ea_test_add(group, assert_double);
+#endif
+	static const char* const kinds[] = { "bool", "int", "uint", "ptr", "strz", "strn", "double" };
+	for (int i = 0; i < (int)(sizeof(kinds) / sizeof(kinds[0])); ++i) {
+		char name[64], filter[64];
+		snprintf(name, sizeof(name), "Assert/%s", kinds[i]);
+		snprintf(filter, sizeof(filter), "Assert/assert_%s", kinds[i]);
+#ifdef EA_NO_DOUBLE
+		if (strcmp(kinds[i], "double") == 0) {
+			continue;
+		}
+#endif
+		if (!wanted(name)) {
+			continue;
+		}
+		unsigned long long start = now_ns();
+		ea_run(root, filter);
+		report(name, assert_iterations, now_ns() - start);
+	}
+	ea_release_group(root);
+}
+
+int main(int argc, char** argv) {
+	long long max_tests = SELFBENCH_DEFAULT_MAX;
+	int count = 1;
+	for (int i = 1; i < argc; ++i) {
+		if (strncmp(argv[i], "--max=", 6) == 0) {
+			max_tests = atoll(argv[i] + 6);
+		}
+		else if (strncmp(argv[i], "--count=", 8) == 0) {
+			count = atoi(argv[i] + 8);
+		}
+		else if (strncmp(argv[i], "--bench=", 8) == 0) {
+			bench_filter = argv[i] + 8;
+		}
+		else {
+			fprintf(stderr, "usage: %s [--max=<tests>] [--count=<n>] [--bench=<substring>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	ea_set_output(discard_output, NULL);
+	for (int c = 0; c < count; ++c) {
+		for (int shape = shape_wide; shape <= shape_deep; ++shape) {
+			for (long long tests = 1000; tests <= max_tests; tests *= 10) {
+				bench_suite((shape_t)shape, tests);
+			}
+		}
+		bench_filters((max_tests < FILTER_SUITE_TESTS) ? max_tests : FILTER_SUITE_TESTS);
+		bench_assertions();
+	}
+	return 0;
+}
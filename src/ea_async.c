@@ -0,0 +1,407 @@
+#include <string.h>
+
+#include "ea_internal.h"
+
+#if defined(__linux__) && defined(EA_HAVE_POSIX)
+#define ASYNC_HAVE_LOOP 1
+#endif
+
+#ifdef EA_HAVE_POSIX
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#endif
+
+#ifdef ASYNC_HAVE_LOOP
+#include <sys/epoll.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+#ifndef ASYNC_STACK_SIZE
+#define ASYNC_STACK_SIZE (64 * 1024)
+#endif
+
+// number of async tests running at the same time
+#ifndef ASYNC_MAX_TASKS
+#define ASYNC_MAX_TASKS 256
+#endif
+
+#ifndef ASYNC_DEFAULT_TIMEOUT_MS
+#define ASYNC_DEFAULT_TIMEOUT_MS 10000
+#endif
+
+void ea__test_add_async(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line) {
+	ea__test_add_ex(group, test_func, test_name, file, line, NULL)->async = 1;
+}
+
+// blocking waits, used outside of the event loop
+
+static int wait_blocking(int fd, int write, int timeout_ms) {
+#ifdef EA_HAVE_POSIX
+	struct pollfd p;
+	p.fd = fd;
+	p.events = write ? POLLOUT : POLLIN;
+	p.revents = 0;
+	int n;
+	do {
+		n = poll(&p, 1, timeout_ms);
+	} while ((n < 0) && (errno == EINTR));
+	if ((n < 0) || (p.revents & POLLNVAL)) {
+		return -1;
+	}
+	return n > 0;
+#else
+	(void)fd;
+	(void)write;
+	(void)timeout_ms;
+	return -1;
+#endif
+}
+
+static void sleep_blocking(int ms) {
+#ifdef EA_HAVE_POSIX
+	struct timespec ts;
+	ts.tv_sec = ms / 1000;
+	ts.tv_nsec = (long)(ms % 1000) * 1000000;
+	while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR)) {
+	}
+#else
+	(void)ms;
+#endif
+}
+
+#ifndef ASYNC_HAVE_LOOP
+
+int ea_await_readable(ea__test_info_t* test_info, int fd, int timeout_ms) {
+	(void)test_info;
+	return wait_blocking(fd, 0, timeout_ms);
+}
+
+int ea_await_writable(ea__test_info_t* test_info, int fd, int timeout_ms) {
+	(void)test_info;
+	return wait_blocking(fd, 1, timeout_ms);
+}
+
+void ea_sleep_ms(ea__test_info_t* test_info, int ms) {
+	(void)test_info;
+	sleep_blocking(ms);
+}
+
+void ea__async_run(ea__run_t* run, ea_group_t* group, int namepos) {
+	// no event loop on this platform, run the tests one by one
+	for (ea_test_t* test = group->tests_head; test; test = test->next) {
+		if (test->async && (test->selected == ea__selected_yes)) {
+			ea__run_test(run, test, ea__append_name(run->namebuf, namepos, test->name));
+		}
+	}
+}
+
+#else
+
+/*
+ * Async tests are stackful coroutines (ucontext) driven by an epoll loop. A
+ * test suspends by registering a wait (a descriptor and/or a wake-up time)
+ * and switching back to the loop, which resumes it when the wait is over.
+ * The output of a test is captured while it runs and printed in one piece
+ * when it finishes, so interleaved tests are still reported separately.
+ */
+
+typedef struct {
+	int used;
+	ea_test_t* test;
+	ea__test_info_t info;
+	char name[TESTNAME_BUF_LEN + 1];
+	char failure_message[EA_RESULT_MESSAGE_LEN];
+	ucontext_t ctx;
+	char* stack;
+	int done;
+
+	// current wait
+	int wait_fd; // duplicate registered with epoll, -1 if none
+	unsigned long long wake_ns; // 0 if no wake-up time
+	int ready; // the descriptor became ready
+
+	unsigned long long start_ns, deadline_ns;
+
+	// captured output
+	char* out;
+	int out_len, out_cap;
+} task_t;
+
+typedef struct {
+	ea__run_t* run;
+	ea_group_t* root;
+	int epfd;
+	ucontext_t loop_ctx;
+	task_t* current;
+	ea_output_func_t output_func; // output of the runner
+	void* output_opaque;
+} loop_t;
+
+// the running loop, the runner is single-threaded
+static loop_t* loop = NULL;
+
+static void capture(const char* data, int len, void* opaque) {
+	task_t* task = (task_t*)opaque;
+	if (task->out_len + len > task->out_cap) {
+		int cap = task->out_cap ? task->out_cap * 2 : 256;
+		while (cap < task->out_len + len) {
+			cap *= 2;
+		}
+		char* out = (char*)loop->root->mem_alloc(NULL, cap, loop->root->mem_alloc_opaque);
+		if (task->out) {
+			memcpy(out, task->out, task->out_len);
+			loop->root->mem_alloc(task->out, 0, loop->root->mem_alloc_opaque);
+		}
+		task->out = out;
+		task->out_cap = cap;
+	}
+	memcpy(task->out + task->out_len, data, len);
+	task->out_len += len;
+}
+
+static void task_entry(void) {
+	task_t* task = loop->current;
+	task->test->test_func(&task->info);
+	task->done = 1;
+	// returns to the loop through uc_link
+}
+
+static void resume(task_t* task) {
+	loop->current = task;
+	ea_set_output(capture, task);
+	swapcontext(&loop->loop_ctx, &task->ctx);
+	ea_set_output(loop->output_func, loop->output_opaque);
+	loop->current = NULL;
+}
+
+static void suspend(task_t* task) {
+	swapcontext(&task->ctx, &loop->loop_ctx);
+}
+
+static task_t* current_task(const ea__test_info_t* test_info) {
+	return (loop && test_info) ? (task_t*)test_info->async : NULL;
+}
+
+static int await_fd(ea__test_info_t* test_info, int fd, int write, int timeout_ms) {
+	task_t* task = current_task(test_info);
+	if (!task) {
+		return wait_blocking(fd, write, timeout_ms);
+	}
+
+	// a duplicate is registered, so several tests can wait for the same descriptor
+	int wait_fd = dup(fd);
+	if (wait_fd < 0) {
+		return -1;
+	}
+	struct epoll_event ev;
+	ev.events = write ? EPOLLOUT : EPOLLIN;
+	ev.data.ptr = task;
+	if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, wait_fd, &ev) != 0) {
+		int err = errno;
+		close(wait_fd);
+		return (err == EPERM) ? 1 : -1; // regular files are always ready
+	}
+	task->wait_fd = wait_fd;
+	task->ready = 0;
+	task->wake_ns = (timeout_ms >= 0) ? ea__now_ns() + (unsigned long long)timeout_ms * 1000000ull : 0;
+	suspend(task);
+	epoll_ctl(loop->epfd, EPOLL_CTL_DEL, wait_fd, NULL);
+	close(wait_fd);
+	task->wait_fd = -1;
+	task->wake_ns = 0;
+	return task->ready ? 1 : 0;
+}
+
+int ea_await_readable(ea__test_info_t* test_info, int fd, int timeout_ms) {
+	return await_fd(test_info, fd, 0, timeout_ms);
+}
+
+int ea_await_writable(ea__test_info_t* test_info, int fd, int timeout_ms) {
+	return await_fd(test_info, fd, 1, timeout_ms);
+}
+
+void ea_sleep_ms(ea__test_info_t* test_info, int ms) {
+	task_t* task = current_task(test_info);
+	if (!task) {
+		sleep_blocking(ms);
+		return;
+	}
+	task->ready = 0; // left set by an earlier await, it would end the sleep early
+	task->wake_ns = ea__now_ns() + (unsigned long long)(ms > 0 ? ms : 0) * 1000000ull;
+	suspend(task);
+	task->wake_ns = 0;
+}
+
+static ea_test_t* next_async(ea_test_t* test) {
+	while (test && !(test->async && (test->selected == ea__selected_yes))) {
+		test = test->next;
+	}
+	return test;
+}
+
+static void start(task_t* task, ea_test_t* test, int namepos, int timeout_ms) {
+	ea__run_t* run = loop->run;
+	int namelen = ea__append_name(run->namebuf, namepos, test->name);
+	memcpy(task->name, run->namebuf, namelen);
+	ea__fixtures_acquire(test);
+
+	task->used = 1;
+	task->test = test;
+	memset(&task->info, 0, sizeof(task->info));
+	task->info.test = test;
+	task->info.name = task->name;
+	task->info.name_len = namelen;
+	task->info.async = task;
+	task->info.sites = run->sites;
+	if (run->results) {
+		task->failure_message[0] = '\0';
+		task->info.failure_message = task->failure_message;
+	}
+	task->done = 0;
+	task->ready = 0;
+	task->wait_fd = -1;
+	task->wake_ns = 0;
+	task->out_len = 0;
+	task->start_ns = ea__now_ns();
+	task->deadline_ns = task->start_ns + (unsigned long long)timeout_ms * 1000000ull;
+
+	getcontext(&task->ctx);
+	task->ctx.uc_stack.ss_sp = task->stack;
+	task->ctx.uc_stack.ss_size = ASYNC_STACK_SIZE;
+	task->ctx.uc_link = &loop->loop_ctx;
+	makecontext(&task->ctx, task_entry, 0);
+}
+
+static void finish(task_t* task, int namepos, int timeout_ms) {
+	ea__run_t* run = loop->run;
+	int failed = task->info.current_failed;
+	run->test_ns = ea__now_ns() - task->start_ns;
+	int namelen = ea__append_name(run->namebuf, namepos, task->test->name);
+	ea__print_test_name(run->namebuf, namelen);
+	ea__write(task->out, task->out_len);
+	if (!task->done) {
+		// abandoned while waiting, its stack is reused
+		if (task->wait_fd >= 0) {
+			epoll_ctl(loop->epfd, EPOLL_CTL_DEL, task->wait_fd, NULL);
+			close(task->wait_fd);
+		}
+		if (ea__fail_test(&task->info)) {
+			ea__fail_printf(&task->info, "  Timed out after %d ms\n", timeout_ms);
+		}
+		failed = 1;
+	}
+	ea__test_finish(run, task->test, namelen, &task->info, failed);
+	task->used = 0;
+}
+
+void ea__async_run(ea__run_t* run, ea_group_t* group, int namepos) {
+	ea_group_t* root = ea__get_root(group);
+	int timeout_ms = run->config->async_timeout_ms ? run->config->async_timeout_ms : ASYNC_DEFAULT_TIMEOUT_MS;
+
+	// count the tests to size the task pool
+	int count = 0;
+	for (ea_test_t* test = next_async(group->tests_head); test; test = next_async(test->next)) {
+		count++;
+	}
+	if (count > ASYNC_MAX_TASKS) {
+		count = ASYNC_MAX_TASKS;
+	}
+
+	loop_t l;
+	memset(&l, 0, sizeof(l));
+	l.run = run;
+	l.root = root;
+	l.epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (l.epfd < 0) {
+		for (ea_test_t* test = next_async(group->tests_head); test; test = next_async(test->next)) {
+			ea__run_test(run, test, ea__append_name(run->namebuf, namepos, test->name));
+		}
+		return;
+	}
+	ea__get_output(&l.output_func, &l.output_opaque);
+	loop = &l;
+
+	task_t* tasks = (task_t*)root->mem_alloc(NULL, (int)sizeof(task_t) * count, root->mem_alloc_opaque);
+	memset(tasks, 0, sizeof(task_t) * count);
+	for (int i = 0; i < count; ++i) {
+		tasks[i].stack = (char*)root->mem_alloc(NULL, ASYNC_STACK_SIZE, root->mem_alloc_opaque);
+	}
+
+	ea_test_t* next = next_async(group->tests_head);
+	int active = 0;
+	while (next || active) {
+		// start tests in the free slots, each runs until it first suspends
+		for (int i = 0; (i < count) && next; ++i) {
+			task_t* task = &tasks[i];
+			if (task->used) {
+				continue;
+			}
+			start(task, next, namepos, timeout_ms);
+			next = next_async(next->next);
+			active++;
+			resume(task);
+			if (task->done) {
+				finish(task, namepos, timeout_ms);
+				active--;
+			}
+		}
+		if (!active) {
+			continue;
+		}
+
+		// wait for the first descriptor, wake-up time or deadline
+		unsigned long long now = ea__now_ns();
+		unsigned long long first = ~0ull;
+		for (int i = 0; i < count; ++i) {
+			if (tasks[i].used) {
+				if (tasks[i].wake_ns && (tasks[i].wake_ns < first)) {
+					first = tasks[i].wake_ns;
+				}
+				if (tasks[i].deadline_ns < first) {
+					first = tasks[i].deadline_ns;
+				}
+			}
+		}
+		int wait_ms = (first <= now) ? 0 : (int)((first - now + 999999) / 1000000);
+		struct epoll_event events[64];
+		int n = epoll_wait(l.epfd, events, 64, wait_ms);
+		for (int i = 0; i < n; ++i) {
+			((task_t*)events[i].data.ptr)->ready = 1;
+		}
+
+		// resume the tests whose wait is over, fail the ones out of time
+		now = ea__now_ns();
+		for (int i = 0; i < count; ++i) {
+			task_t* task = &tasks[i];
+			if (!task->used) {
+				continue;
+			}
+			if (task->ready || (task->wake_ns && (now >= task->wake_ns))) {
+				resume(task);
+			}
+			else if (now >= task->deadline_ns) {
+				finish(task, namepos, timeout_ms);
+				active--;
+				continue;
+			}
+			if (task->done) {
+				finish(task, namepos, timeout_ms);
+				active--;
+			}
+		}
+	}
+
+	loop = NULL;
+	for (int i = 0; i < count; ++i) {
+		root->mem_alloc(tasks[i].stack, 0, root->mem_alloc_opaque);
+		if (tasks[i].out) {
+			root->mem_alloc(tasks[i].out, 0, root->mem_alloc_opaque);
+		}
+	}
+	root->mem_alloc(tasks, 0, root->mem_alloc_opaque);
+	close(l.epfd);
+}
+
+#endif // ASYNC_HAVE_LOOP
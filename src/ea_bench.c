@@ -0,0 +1,655 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // sched_setaffinity(), getloadavg()
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ea_internal.h"
+
+#ifdef EA_HAVE_POSIX
+#include <errno.h>
+#include <sys/resource.h>
+#endif
+
+#if defined(__linux__) && defined(EA_HAVE_POSIX)
+#include <sched.h>
+#define BENCH_HAVE_AFFINITY 1
+#endif
+
+/*
+ * A benchmark is run for each size of its range. At a size the body is
+ * called with 1, then more iterations (predicted from the last call) until
+ * the timed loop takes bench-time. After the last size, the complexity models
+ * are fitted to the ns/op by least squares (t = c * f(n)), the one with the
+ * smallest RMS relative error is the best fit.
+ *
+ * With noise control (bench-trials > 1 or bench-cpu) the calibrated body is
+ * run again until the last few times per operation agree (steady state), then
+ * for the trials. Trials further than a few median absolute deviations from
+ * the median are rejected, the rest give the mean and its confidence interval.
+ */
+
+#ifndef BENCH_DEFAULT_TIME_MS
+#define BENCH_DEFAULT_TIME_MS 20
+#endif
+
+#ifndef BENCH_MAX_ITERATIONS
+#define BENCH_MAX_ITERATIONS 1000000000ll
+#endif
+
+// a model growing faster than the expected one must fit better by this much
+// (RMS relative error) to fail the expectation
+#ifndef BENCH_FIT_SLACK
+#define BENCH_FIT_SLACK 0.1
+#endif
+
+// least squares needs a few points to tell the models apart
+#define BENCH_MIN_FIT_SIZES 3
+
+// warmup runs before the time per operation counts as not steady
+#ifndef BENCH_MAX_WARMUP
+#define BENCH_MAX_WARMUP 10
+#endif
+
+// steady state: the last BENCH_STEADY_WINDOW warmup runs are within this
+// relative spread
+#ifndef BENCH_STEADY_TOLERANCE
+#define BENCH_STEADY_TOLERANCE 0.03
+#endif
+#define BENCH_STEADY_WINDOW 3
+
+// trials further from the median than this many (normal-scaled) median
+// absolute deviations are outliers
+#ifndef BENCH_OUTLIER_MADS
+#define BENCH_OUTLIER_MADS 3.0
+#endif
+
+#ifndef BENCH_MAX_TRIALS
+#define BENCH_MAX_TRIALS 1000
+#endif
+
+// results are flagged noisy with a relative 95% confidence interval above
+// this, or a load average (besides the benchmark) above this per CPU
+#ifndef BENCH_NOISY_CI
+#define BENCH_NOISY_CI 0.05
+#endif
+#ifndef BENCH_NOISY_LOAD
+#define BENCH_NOISY_LOAD 0.5
+#endif
+
+// nice value asked for while benchmarking, lowered as far as allowed
+#ifndef BENCH_NICE
+#define BENCH_NICE -20
+#endif
+
+#define BENCH_MODEL_COUNT (EA_O_N_SQUARED + 1)
+
+static const char* const model_names[BENCH_MODEL_COUNT] = {
+	"O(1)", "O(log n)", "O(n)", "O(n log n)", "O(n^2)",
+};
+
+typedef struct {
+	ea__bench_func_t bench_func;
+	long long min_n, max_n;
+} ea_benchmark_t;
+
+typedef struct {
+	long long n;
+	long long iterations;
+	unsigned long long ns; // of all iterations
+	long long bytes_per_op; // 0 if not set
+
+	// noise control
+	int trials; // trials kept, iterations and ns are of one (average) trial
+	int outliers; // trials rejected
+	double ci; // relative half width of the 95% confidence interval, < 0 if none
+	int steady; // steady state reached in the warmup, -1 without noise control
+} result_t;
+
+// facts about the machine that make benchmark results noisy
+typedef struct {
+	int enabled; // noise control is on
+	char cpu_model[64];
+	char governor[32]; // empty if unknown
+	int load_hundredths; // 1 minute load average * 100, -1 if unknown
+	int cpus;
+	int pinned_cpu; // -1 if not pinned
+	int priority_raised;
+} environment_t;
+
+// scheduling state to restore after the benchmark
+typedef struct {
+#ifdef BENCH_HAVE_AFFINITY
+	cpu_set_t affinity;
+	int affinity_saved;
+#endif
+	int nice;
+	int nice_saved;
+} scheduling_t;
+
+typedef struct {
+	ea_group_t* root; // for mem_alloc
+	environment_t environment;
+	result_t* results;
+	int count; // measured sizes
+	int best; // best fitting model, -1 if not fitted
+	double best_error;
+} report_t;
+
+struct ea_bench_s {
+	long long n;
+	long long iterations;
+	int timed; // BENCH_LOOP() was entered
+	unsigned long long start_ns, elapsed_ns;
+	long long bytes_per_op;
+	int expected; // expected model, -1 if none
+};
+
+long long ea_bench_n(const ea_bench_t* bench) {
+	return bench->n;
+}
+
+void ea_bench_set_bytes(ea_bench_t* bench, long long bytes_per_op) {
+	bench->bytes_per_op = bytes_per_op;
+}
+
+void ea_bench_expect_complexity(ea_bench_t* bench, ea_complexity_t complexity) {
+	bench->expected = (int)complexity;
+}
+
+static const void* volatile bench_sink;
+
+void ea_bench_keep(const void* value) {
+	bench_sink = value;
+}
+
+long long ea__bench_start(ea_bench_t* bench) {
+	bench->timed = 1;
+	bench->start_ns = ea__now_ns();
+	return bench->iterations;
+}
+
+int ea__bench_stop(ea_bench_t* bench) {
+	bench->elapsed_ns += ea__now_ns() - bench->start_ns;
+	return 0;
+}
+
+// fitting, without libm
+
+static double log2_of(double x) {
+	double r = 0.0;
+	while (x >= 2.0) {
+		x /= 2.0;
+		r += 1.0;
+	}
+	// ln(x) = 2 atanh((x - 1) / (x + 1)), converges fast for x in [1, 2)
+	double y = (x - 1.0) / (x + 1.0);
+	double y2 = y * y, term = y, sum = 0.0;
+	for (int k = 1; k < 24; k += 2) {
+		sum += term / k;
+		term *= y2;
+	}
+	return r + 2.0 * sum / 0.69314718055994531;
+}
+
+static double sqrt_of(double x) {
+	if (x <= 0.0) {
+		return 0.0;
+	}
+	double r = (x > 1.0) ? x : 1.0;
+	for (int i = 0; i < 64; ++i) {
+		r = (r + x / r) / 2.0;
+	}
+	return r;
+}
+
+static double model_value(int model, double n) {
+	switch (model) {
+	case EA_O_1: return 1.0;
+	case EA_O_LOG_N: return log2_of(n);
+	case EA_O_N: return n;
+	case EA_O_N_LOG_N: return n * log2_of(n);
+	default: return n * n;
+	}
+}
+
+static double op_ns(const result_t* r) {
+	double t = (double)r->ns / (double)r->iterations;
+	return (t > 0.0) ? t : 1e-3; // below the clock resolution
+}
+
+// RMS of the relative errors of the least squares fit of the model, relative
+// errors weigh all sizes the same (absolute ones only see the largest sizes)
+static double fit_error(const result_t* results, int count, int model) {
+	double ft = 0.0, ff = 0.0;
+	for (int i = 0; i < count; ++i) {
+		double t = op_ns(&results[i]);
+		double f = model_value(model, (double)results[i].n) / t;
+		ft += f;
+		ff += f * f;
+	}
+	double c = (ff > 0.0) ? ft / ff : 0.0;
+	double sq = 0.0;
+	for (int i = 0; i < count; ++i) {
+		double t = op_ns(&results[i]);
+		double d = 1.0 - c * model_value(model, (double)results[i].n) / t;
+		sq += d * d;
+	}
+	return sqrt_of(sq / count);
+}
+
+// statistics of the trials
+
+static double abs_of(double x) {
+	return (x < 0.0) ? -x : x;
+}
+
+// sorts the values
+static double median_of(double* values, int count) {
+	for (int i = 1; i < count; ++i) {
+		double v = values[i];
+		int j = i;
+		for (; (j > 0) && (values[j - 1] > v); --j) {
+			values[j] = values[j - 1];
+		}
+		values[j] = v;
+	}
+	return (count % 2) ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+static double spread_of(const double* values, int count) {
+	double lo = values[0], hi = values[0];
+	for (int i = 1; i < count; ++i) {
+		lo = (values[i] < lo) ? values[i] : lo;
+		hi = (values[i] > hi) ? values[i] : hi;
+	}
+	return (lo > 0.0) ? (hi - lo) / lo : 0.0;
+}
+
+// two-sided 95% quantile of Student's t distribution
+static double t_quantile(int df) {
+	static const double table[30] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+	};
+	return (df <= 30) ? table[df - 1] : 1.96;
+}
+
+// environment and scheduling
+
+#ifdef EA_HAVE_POSIX
+// value of the first line starting with key (after the colon), or the first
+// line if key is NULL
+static void read_line(const char* path, const char* key, char* buf, int size) {
+	FILE* f = fopen(path, "r");
+	if (!f) {
+		return;
+	}
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		const char* value = line;
+		if (key) {
+			if (strncmp(line, key, strlen(key)) != 0) {
+				continue;
+			}
+			value = strchr(line, ':');
+			if (!value) {
+				continue;
+			}
+			value++;
+			while (*value == ' ' || *value == '\t') {
+				value++;
+			}
+		}
+		int len = (int)strcspn(value, "\n");
+		if (len >= size) {
+			len = size - 1;
+		}
+		memcpy(buf, value, len);
+		buf[len] = '\0';
+		break;
+	}
+	fclose(f);
+}
+#endif
+
+static void begin_quiet(const ea_config_t* config, environment_t* environment, scheduling_t* scheduling) {
+	memset(environment, 0, sizeof(environment_t));
+	memset(scheduling, 0, sizeof(scheduling_t));
+	environment->enabled = 1;
+	environment->pinned_cpu = -1;
+	environment->load_hundredths = -1;
+	environment->cpus = ea__cpu_count();
+	strcpy(environment->cpu_model, "unknown CPU");
+#ifdef EA_HAVE_POSIX
+	if (config->bench_cpu_set) {
+#ifdef BENCH_HAVE_AFFINITY
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(config->bench_cpu, &set);
+		if ((config->bench_cpu < CPU_SETSIZE) && (sched_getaffinity(0, sizeof(cpu_set_t), &scheduling->affinity) == 0)
+			&& (sched_setaffinity(0, sizeof(cpu_set_t), &set) == 0)) {
+			scheduling->affinity_saved = 1;
+			environment->pinned_cpu = config->bench_cpu;
+		}
+#endif
+		errno = 0;
+		scheduling->nice = getpriority(PRIO_PROCESS, 0);
+		if (errno == 0) {
+			// the lowest nice value allowed (e.g. by RLIMIT_NICE)
+			for (int nice = BENCH_NICE; nice < scheduling->nice; ++nice) {
+				if (setpriority(PRIO_PROCESS, 0, nice) == 0) {
+					scheduling->nice_saved = 1;
+					environment->priority_raised = 1;
+					break;
+				}
+			}
+		}
+	}
+
+	read_line("/proc/cpuinfo", "model name", environment->cpu_model, sizeof(environment->cpu_model));
+	char path[96];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor",
+		(environment->pinned_cpu >= 0) ? environment->pinned_cpu : 0);
+	read_line(path, NULL, environment->governor, sizeof(environment->governor));
+	double load;
+	if (getloadavg(&load, 1) == 1) {
+		environment->load_hundredths = (int)(load * 100.0 + 0.5);
+	}
+#else
+	(void)config;
+#endif
+}
+
+static void end_quiet(scheduling_t* scheduling) {
+#ifdef BENCH_HAVE_AFFINITY
+	if (scheduling->affinity_saved) {
+		sched_setaffinity(0, sizeof(cpu_set_t), &scheduling->affinity);
+	}
+#endif
+#ifdef EA_HAVE_POSIX
+	if (scheduling->nice_saved) {
+		setpriority(PRIO_PROCESS, 0, scheduling->nice);
+	}
+#else
+	(void)scheduling;
+#endif
+}
+
+// benchmark test function
+
+// reasons not to trust the results, comma separated, returns nonzero if any
+static int print_noise(const report_t* report) {
+	const environment_t* environment = &report->environment;
+	const char* sep = "  Noisy: ";
+	if (environment->governor[0] && (strcmp(environment->governor, "performance") != 0)) {
+		ea__printf("%sgovernor %s", sep, environment->governor);
+		sep = ", ";
+	}
+	// the benchmark itself adds 1 to the load
+	int other_load = environment->load_hundredths - 100;
+	if (other_load > (int)(BENCH_NOISY_LOAD * 100.0) * environment->cpus) {
+		ea__printf("%sload average %d.%02d on %d CPU(s)", sep,
+			environment->load_hundredths / 100, environment->load_hundredths % 100, environment->cpus);
+		sep = ", ";
+	}
+	int wide = 0, unsteady = 0;
+	for (int i = 0; i < report->count; ++i) {
+		wide += (report->results[i].ci > BENCH_NOISY_CI);
+		unsteady += (report->results[i].steady == 0);
+	}
+	if (wide) {
+		ea__printf("%s%d size(s) with a confidence interval above %d%%", sep, wide, (int)(BENCH_NOISY_CI * 100.0 + 0.5));
+		sep = ", ";
+	}
+	if (unsteady) {
+		ea__printf("%s%d size(s) without a steady state", sep, unsteady);
+		sep = ", ";
+	}
+	if (sep[0] == ',') {
+		ea__printf("\n");
+	}
+	return sep[0] == ',';
+}
+
+// the environment for the results, the highest load counts
+static void record_environment(ea_bench_environment_t* recorded, const environment_t* environment, int noisy) {
+	if (!recorded->measured || (environment->load_hundredths > recorded->load_hundredths)) {
+		recorded->load_hundredths = environment->load_hundredths;
+	}
+	recorded->measured = 1;
+	memcpy(recorded->cpu_model, environment->cpu_model, sizeof(recorded->cpu_model));
+	memcpy(recorded->governor, environment->governor, sizeof(recorded->governor));
+	recorded->cpus = environment->cpus;
+	recorded->noisy_count += noisy;
+}
+
+static void print_report(ea__test_info_t* test_info) {
+	report_t* report = (report_t*)test_info->report_opaque;
+	int single = (report->count == 1) && (report->results[0].n == 1);
+	const environment_t* environment = &report->environment;
+	if (environment->enabled) {
+		ea__printf("  Environment: %s", environment->cpu_model);
+		if (environment->governor[0]) {
+			ea__printf(", governor %s", environment->governor);
+		}
+		if (environment->load_hundredths >= 0) {
+			ea__printf(", load %d.%02d", environment->load_hundredths / 100, environment->load_hundredths % 100);
+		}
+		ea__printf(" on %d CPU(s)", environment->cpus);
+		if (environment->pinned_cpu >= 0) {
+			ea__printf(", pinned to CPU %d", environment->pinned_cpu);
+		}
+		if (environment->priority_raised) {
+			ea__printf(", priority raised");
+		}
+		ea__printf("\n");
+	}
+	for (int i = 0; i < report->count; ++i) {
+		const result_t* r = &report->results[i];
+		unsigned long long tenths = r->ns * 10 / (unsigned long long)r->iterations;
+		if (single) {
+			ea__printf("  %llu.%llu ns/op", tenths / 10, tenths % 10);
+		}
+		else {
+			ea__printf("  n=%-12lld %12llu.%llu ns/op", r->n, tenths / 10, tenths % 10);
+		}
+		if (r->ci >= 0.0) {
+			int ci = (int)(r->ci * 1000.0 + 0.5);
+			ea__printf(" +/- %d.%d%%", ci / 10, ci % 10);
+		}
+		if (r->bytes_per_op) {
+			ea__printf(" %12lld bytes/op", r->bytes_per_op);
+		}
+		ea__printf(" (%lld iterations", r->iterations);
+		if (environment->enabled) {
+			ea__printf(" x %d trial(s)", r->trials);
+			if (r->outliers) {
+				ea__printf(", %d outlier(s)", r->outliers);
+			}
+			if (!r->steady) {
+				ea__printf(", not steady");
+			}
+		}
+		ea__printf(")\n");
+	}
+	if (environment->enabled) {
+		int noisy = print_noise(report);
+		if (test_info->bench_environment) {
+			record_environment(test_info->bench_environment, environment, noisy);
+		}
+	}
+	if (report->best >= 0) {
+		ea__printf("  Complexity: %s (fit error %d%%)\n", model_names[report->best], (int)(report->best_error * 100.0 + 0.5));
+	}
+	report->root->mem_alloc(report->results, 0, report->root->mem_alloc_opaque);
+	report->root->mem_alloc(report, 0, report->root->mem_alloc_opaque);
+}
+
+// one call of the body, returns the time of its timed loop (or of the whole
+// body without one, as one iteration)
+static unsigned long long run_once(ea__test_info_t* test_info, const ea_benchmark_t* benchmark, ea_bench_t* bench, long long iterations) {
+	bench->iterations = iterations;
+	bench->timed = 0;
+	bench->elapsed_ns = 0;
+	unsigned long long start_ns = ea__now_ns();
+	benchmark->bench_func(test_info, bench);
+	if (!bench->timed) {
+		bench->iterations = 1;
+		bench->elapsed_ns = ea__now_ns() - start_ns;
+	}
+	return bench->elapsed_ns;
+}
+
+// warm up from the calibration run in r until steady, then run the trials
+// (values has room for trials * 2)
+static void measure_trials(ea__test_info_t* test_info, const ea_benchmark_t* benchmark, ea_bench_t* bench, result_t* r, int trials, double* values) {
+	long long iterations = r->iterations;
+	double warmup[BENCH_MAX_WARMUP];
+	warmup[0] = op_ns(r);
+	int warmups = 1;
+	r->steady = 0;
+	while (!test_info->current_failed && (warmups < BENCH_MAX_WARMUP)) {
+		warmup[warmups++] = (double)run_once(test_info, benchmark, bench, iterations) / (double)iterations;
+		if ((warmups >= BENCH_STEADY_WINDOW) && (spread_of(warmup + warmups - BENCH_STEADY_WINDOW, BENCH_STEADY_WINDOW) <= BENCH_STEADY_TOLERANCE)) {
+			r->steady = 1;
+			break;
+		}
+	}
+	for (int i = 0; (i < trials) && !test_info->current_failed; ++i) {
+		values[i] = (double)run_once(test_info, benchmark, bench, iterations) / (double)iterations;
+	}
+	if (test_info->current_failed) {
+		return;
+	}
+
+	// reject the outliers by the median absolute deviation (robust to them, unlike the standard deviation)
+	double* deviations = values + trials;
+	memcpy(deviations, values, sizeof(double) * trials);
+	double median = median_of(deviations, trials);
+	for (int i = 0; i < trials; ++i) {
+		deviations[i] = abs_of(values[i] - median);
+	}
+	double limit = BENCH_OUTLIER_MADS * 1.4826 * median_of(deviations, trials);
+	double sum = 0.0;
+	int kept = 0;
+	for (int i = 0; i < trials; ++i) {
+		if ((limit == 0.0) || (abs_of(values[i] - median) <= limit)) {
+			values[kept++] = values[i];
+			sum += values[i];
+		}
+	}
+	double mean = sum / kept;
+	double sq = 0.0;
+	for (int i = 0; i < kept; ++i) {
+		sq += (values[i] - mean) * (values[i] - mean);
+	}
+	r->trials = kept;
+	r->outliers = trials - kept;
+	r->ns = (unsigned long long)(mean * (double)iterations + 0.5);
+	r->ci = ((kept > 1) && (mean > 0.0)) ? t_quantile(kept - 1) * sqrt_of(sq / (kept - 1) / kept) / mean : -1.0;
+}
+
+static void run_benchmark(ea__test_info_t* test_info) {
+	const ea_benchmark_t* benchmark = (const ea_benchmark_t*)test_info->test->opaque;
+	ea_group_t* root = ea__get_root(test_info->test->parent);
+	const ea_config_t* config = ea__get_config(root);
+	unsigned long long target_ns = (unsigned long long)(config->bench_time_ms ? config->bench_time_ms : BENCH_DEFAULT_TIME_MS) * 1000000ull;
+
+	// the results are printed after the result line of the test
+	int sizes = 0;
+	for (long long n = benchmark->min_n; n <= benchmark->max_n; n *= 2) {
+		sizes++;
+	}
+	report_t* report = (report_t*)root->mem_alloc(NULL, sizeof(report_t), root->mem_alloc_opaque);
+	report->root = root;
+	report->results = (result_t*)root->mem_alloc(NULL, (int)sizeof(result_t) * sizes, root->mem_alloc_opaque);
+	report->count = 0;
+	report->best = -1;
+	report->best_error = 0.0;
+	test_info->report = print_report;
+	test_info->report_opaque = report;
+
+	// noise control
+	int trials = (config->bench_trials > 1) ? config->bench_trials : 1;
+	if (trials > BENCH_MAX_TRIALS) {
+		trials = BENCH_MAX_TRIALS;
+	}
+	memset(&report->environment, 0, sizeof(environment_t));
+	scheduling_t scheduling;
+	double* values = NULL;
+	if ((trials > 1) || config->bench_cpu_set) {
+		begin_quiet(config, &report->environment, &scheduling);
+		values = (double*)root->mem_alloc(NULL, (int)sizeof(double) * trials * 2, root->mem_alloc_opaque);
+	}
+
+	ea_bench_t bench;
+	memset(&bench, 0, sizeof(bench));
+	bench.expected = -1;
+	for (long long n = benchmark->min_n; (n <= benchmark->max_n) && !test_info->current_failed; n *= 2) {
+		bench.n = n;
+		long long iterations = 1;
+		for (;;) {
+			run_once(test_info, benchmark, &bench, iterations);
+			if (!bench.timed || test_info->current_failed || (bench.elapsed_ns >= target_ns) || (iterations >= BENCH_MAX_ITERATIONS)) {
+				break;
+			}
+			// aim a bit above the target, growing at least 2x and at most 100x
+			long long next = bench.elapsed_ns ? (long long)((double)iterations * 1.2 * (double)target_ns / (double)bench.elapsed_ns) : iterations * 100;
+			if (next < iterations * 2) next = iterations * 2;
+			if (next > iterations * 100) next = iterations * 100;
+			if (next > BENCH_MAX_ITERATIONS) next = BENCH_MAX_ITERATIONS;
+			iterations = next;
+		}
+		result_t* r = &report->results[report->count++];
+		r->n = n;
+		r->iterations = bench.iterations;
+		r->ns = bench.elapsed_ns;
+		r->bytes_per_op = bench.bytes_per_op;
+		r->trials = 1;
+		r->outliers = 0;
+		r->ci = -1.0;
+		r->steady = -1;
+		if (values && !test_info->current_failed) {
+			measure_trials(test_info, benchmark, &bench, r, trials, values);
+		}
+	}
+	if (values) {
+		root->mem_alloc(values, 0, root->mem_alloc_opaque);
+		end_quiet(&scheduling);
+	}
+	if (test_info->current_failed || (report->count < BENCH_MIN_FIT_SIZES)) {
+		return;
+	}
+
+	// fit the models
+	double errors[BENCH_MODEL_COUNT];
+	for (int model = 0; model < BENCH_MODEL_COUNT; ++model) {
+		errors[model] = fit_error(report->results, report->count, model);
+		if ((report->best < 0) || (errors[model] < errors[report->best])) {
+			report->best = model;
+		}
+	}
+	report->best_error = errors[report->best];
+
+	// check the expectation
+	int expected = bench.expected;
+	if ((expected >= 0) && (report->best > expected) && (errors[expected] > report->best_error + BENCH_FIT_SLACK)) {
+		if (ea__fail_test(test_info)) {
+			ea__fail_printf(test_info, "  Complexity %s is worse than the expected %s (fit error %d%% vs %d%%)\n",
+				model_names[report->best], model_names[expected],
+				(int)(report->best_error * 100.0 + 0.5), (int)(errors[expected] * 100.0 + 0.5));
+		}
+	}
+}
+
+void ea__benchmark_add(ea_group_t* group, ea__bench_func_t bench_func, const char* bench_name, const char* file, int line, long long min_n, long long max_n) {
+	ea_benchmark_t* benchmark = (ea_benchmark_t*)group->mem_alloc(NULL, sizeof(ea_benchmark_t), group->mem_alloc_opaque);
+	benchmark->bench_func = bench_func;
+	benchmark->min_n = (min_n > 0) ? min_n : 1;
+	benchmark->max_n = (max_n > benchmark->min_n) ? max_n : benchmark->min_n;
+	ea__test_add_ex(group, run_benchmark, bench_name, file, line, benchmark);
+}
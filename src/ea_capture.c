@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "ea_internal.h"
+
+#if defined(EA_HAVE_POSIX) && defined(EA_HAVE_PTHREADS)
+#define CAPTURE_SUPPORTED 1
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <stdio_ext.h>
+#endif
+
+/*
+ * While a test runs, file descriptors 1 and 2 point to a pipe, so everything
+ * the code under test writes, with stdio or write(), lands there. A reader
+ * thread keeps the last bytes of the test (up to the size cap) in a ring
+ * buffer, so a test writing without end still uses only the cap in memory.
+ * The framework's own output goes to a duplicate of the real stdout through
+ * an output sink. At the end of a test the reader is woken through a second
+ * pipe, empties the first one and acknowledges, so the ring holds all of the
+ * test's output; after a failed test it is printed below the failure and
+ * kept for the results. stdout is made line buffered once, before the first
+ * test, so its lines keep their order with stderr and write(); the buffering
+ * is not changed per test, as setvbuf() is only allowed before a stream is
+ * used. The pipes and the thread are set up by the first test, so worker
+ * processes each get their own.
+ */
+
+#ifndef CAPTURE_DEFAULT_LEN
+#define CAPTURE_DEFAULT_LEN (64 * 1024)
+#endif
+
+struct ea_capture_s {
+	ea_group_t* root; // for mem_alloc
+	int cap; // bytes kept per test
+	char* ring; // last cap bytes written by the test
+	char* buf; // output of the failed test in order, cap + 1
+	long long total; // bytes written by the test
+#ifdef CAPTURE_SUPPORTED
+	int out[2]; // the test's stdout and stderr, out[0] is -1 until the first test
+	int wake[2]; // the end of a test, to the reader
+	int real_out, real_err; // the original descriptors 1 and 2
+	pthread_t reader;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned drained; // ends of tests the reader caught up with
+#endif
+	ea_output_func_t output_func; // sink replaced during the test
+	void* output_opaque;
+};
+
+#ifndef CAPTURE_SUPPORTED
+
+ea_capture_t* ea__capture_create(ea_group_t* root, int cap) {
+	(void)root;
+	(void)cap;
+	ea__printf("Output capture is not supported on this platform.\n");
+	return NULL;
+}
+
+void ea__capture_start(ea_capture_t* capture) {
+	(void)capture;
+}
+
+void ea__capture_stop(ea_capture_t* capture, ea__test_info_t* test_info) {
+	(void)capture;
+	(void)test_info;
+}
+
+void ea__capture_finish(ea_capture_t* capture) {
+	(void)capture;
+}
+
+#else
+
+ea_capture_t* ea__capture_create(ea_group_t* root, int cap) {
+	ea_capture_t* capture = (ea_capture_t*)root->mem_alloc(NULL, sizeof(ea_capture_t), root->mem_alloc_opaque);
+	memset(capture, 0, sizeof(ea_capture_t));
+	capture->root = root;
+	capture->cap = (cap > 0) ? cap : CAPTURE_DEFAULT_LEN;
+	capture->ring = (char*)root->mem_alloc(NULL, capture->cap, root->mem_alloc_opaque);
+	capture->buf = (char*)root->mem_alloc(NULL, capture->cap + 1, root->mem_alloc_opaque);
+	capture->out[0] = -1;
+
+	// an unbuffered or line buffered stdout (e.g. chosen by the program) is kept
+#ifdef __GLIBC__
+	int keep_buffering = __flbf(stdout) || (__fbufsize(stdout) == 1);
+#else
+	int keep_buffering = 0;
+#endif
+	if (!keep_buffering) {
+		fflush(stdout);
+		setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+	}
+	return capture;
+}
+
+// append to the ring, overwriting the oldest bytes
+static void keep(ea_capture_t* capture, const char* data, int len) {
+	if (len > capture->cap) {
+		capture->total += len - capture->cap;
+		data += len - capture->cap;
+		len = capture->cap;
+	}
+	int pos = (int)(capture->total % capture->cap);
+	int first = (len < capture->cap - pos) ? len : capture->cap - pos;
+	memcpy(capture->ring + pos, data, (size_t)first);
+	memcpy(capture->ring, data + first, (size_t)(len - first));
+	capture->total += len;
+}
+
+// read what is in the output pipe, returns 0 at its end
+static int drain(ea_capture_t* capture) {
+	char chunk[4096];
+	for (;;) {
+		ssize_t n = read(capture->out[0], chunk, sizeof(chunk));
+		if (n > 0) {
+			pthread_mutex_lock(&capture->lock);
+			keep(capture, chunk, (int)n);
+			pthread_mutex_unlock(&capture->lock);
+		}
+		else if ((n < 0) && (errno == EINTR)) {
+			continue;
+		}
+		else {
+			return (n < 0) && (errno == EAGAIN);
+		}
+	}
+}
+
+static void* reader_main(void* opaque) {
+	ea_capture_t* capture = (ea_capture_t*)opaque;
+	for (;;) {
+		struct pollfd fds[2];
+		fds[0].fd = capture->out[0];
+		fds[0].events = POLLIN;
+		fds[1].fd = capture->wake[0];
+		fds[1].events = POLLIN;
+		fds[0].revents = fds[1].revents = 0;
+		if ((poll(fds, 2, -1) < 0) && (errno != EINTR)) {
+			return NULL;
+		}
+		if (fds[1].revents) {
+			// the test ended: nothing writes to the pipe any more, empty it
+			char c;
+			if (read(capture->wake[0], &c, 1) <= 0) {
+				return NULL; // the capture is finished
+			}
+			drain(capture);
+			pthread_mutex_lock(&capture->lock);
+			capture->drained++;
+			pthread_cond_signal(&capture->cond);
+			pthread_mutex_unlock(&capture->lock);
+		}
+		else if (fds[0].revents && !drain(capture)) {
+			return NULL;
+		}
+	}
+}
+
+static int open_pipes(ea_capture_t* capture) {
+	if (pipe(capture->out) != 0) {
+		capture->out[0] = -1;
+		return 0;
+	}
+	if (pipe(capture->wake) != 0) {
+		close(capture->out[0]);
+		close(capture->out[1]);
+		capture->out[0] = -1;
+		return 0;
+	}
+	fcntl(capture->out[0], F_SETFL, fcntl(capture->out[0], F_GETFL) | O_NONBLOCK);
+	for (int i = 0; i < 2; ++i) {
+		fcntl(capture->out[i], F_SETFD, FD_CLOEXEC);
+		fcntl(capture->wake[i], F_SETFD, FD_CLOEXEC);
+	}
+	pthread_mutex_init(&capture->lock, NULL);
+	pthread_cond_init(&capture->cond, NULL);
+	if (pthread_create(&capture->reader, NULL, reader_main, capture) != 0) {
+		for (int i = 0; i < 2; ++i) {
+			close(capture->out[i]);
+			close(capture->wake[i]);
+		}
+		pthread_mutex_destroy(&capture->lock);
+		pthread_cond_destroy(&capture->cond);
+		capture->out[0] = -1;
+		return 0;
+	}
+	capture->real_out = dup(STDOUT_FILENO);
+	capture->real_err = dup(STDERR_FILENO);
+	return 1;
+}
+
+// the framework's output during a test, to the real stdout
+static void write_real(const char* data, int len, void* opaque) {
+	ea_capture_t* capture = (ea_capture_t*)opaque;
+	while (len > 0) {
+		ssize_t n = write(capture->real_out, data, (size_t)len);
+		if ((n < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (n <= 0) {
+			return;
+		}
+		data += n;
+		len -= (int)n;
+	}
+}
+
+void ea__capture_start(ea_capture_t* capture) {
+	if ((capture->out[0] < 0) && !open_pipes(capture)) {
+		return; // the test runs uncaptured
+	}
+	fflush(stdout);
+	fflush(stderr);
+	pthread_mutex_lock(&capture->lock);
+	capture->total = 0;
+	pthread_mutex_unlock(&capture->lock);
+	dup2(capture->out[1], STDOUT_FILENO);
+	dup2(capture->out[1], STDERR_FILENO);
+
+	// a sink set by the user (or a server) does not write to the descriptors
+	ea__get_output(&capture->output_func, &capture->output_opaque);
+	if (!capture->output_func) {
+		ea_set_output(write_real, capture);
+	}
+}
+
+// print the captured text with the lines indented, ending with a newline
+static void print_indented(const char* text, int len) {
+	int start = 0;
+	for (int i = 0; i <= len; ++i) {
+		if ((i == len) || (text[i] == '\n')) {
+			if ((i > start) || (i < len)) {
+				ea__printf("    %.*s\n", i - start, text + start);
+			}
+			start = i + 1;
+		}
+	}
+}
+
+void ea__capture_stop(ea_capture_t* capture, ea__test_info_t* test_info) {
+	if (capture->out[0] < 0) {
+		return;
+	}
+	fflush(stdout);
+	fflush(stderr);
+	dup2(capture->real_out, STDOUT_FILENO);
+	dup2(capture->real_err, STDERR_FILENO);
+	ea_set_output(capture->output_func, capture->output_opaque);
+
+	// wait until the reader has everything the test wrote
+	pthread_mutex_lock(&capture->lock);
+	unsigned drained = capture->drained;
+	pthread_mutex_unlock(&capture->lock);
+	char c = 0;
+	while ((write(capture->wake[1], &c, 1) < 0) && (errno == EINTR)) {
+	}
+	pthread_mutex_lock(&capture->lock);
+	while (capture->drained == drained) {
+		pthread_cond_wait(&capture->cond, &capture->lock);
+	}
+	long long total = capture->total;
+	pthread_mutex_unlock(&capture->lock);
+
+	// the output of a passed test is dropped
+	if (!test_info->current_failed || (total <= 0)) {
+		return;
+	}
+	int len = (total > capture->cap) ? capture->cap : (int)total;
+	int pos = (int)((total - len) % capture->cap);
+	int first = (len < capture->cap - pos) ? len : capture->cap - pos;
+	memcpy(capture->buf, capture->ring + pos, (size_t)first);
+	memcpy(capture->buf + first, capture->ring, (size_t)(len - first));
+	capture->buf[len] = '\0';
+	if (total > len) {
+		ea__printf("  Captured output (last %d of %lld bytes):\n", len, total);
+	}
+	else {
+		ea__printf("  Captured output (%d bytes):\n", len);
+	}
+	print_indented(capture->buf, len);
+	test_info->output = capture->buf;
+	test_info->output_len = len;
+}
+
+void ea__capture_finish(ea_capture_t* capture) {
+	if (capture->out[0] >= 0) {
+		close(capture->wake[1]); // ends the reader
+		pthread_join(capture->reader, NULL);
+		close(capture->wake[0]);
+		close(capture->out[0]);
+		close(capture->out[1]);
+		close(capture->real_out);
+		close(capture->real_err);
+		pthread_mutex_destroy(&capture->lock);
+		pthread_cond_destroy(&capture->cond);
+	}
+	ea_group_t* root = capture->root;
+	root->mem_alloc(capture->ring, 0, root->mem_alloc_opaque);
+	root->mem_alloc(capture->buf, 0, root->mem_alloc_opaque);
+	root->mem_alloc(capture, 0, root->mem_alloc_opaque);
+}
+
+#endif // CAPTURE_SUPPORTED
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ea_internal.h"
+
+/*
+ * Change cache format, one entry per line:
+ *   F <hash> <path>   fingerprint of a source file
+ *   X <test name>     test failed in the previous run
+ */
+
+typedef struct {
+	ea__table_key_t key; // file path or test name
+	unsigned long long old_hash, new_hash;
+	char has_old, has_new;
+	char considered; // used by a test that was checked for changes
+	char blocked; // used by a test that was not checked, keep the old hash
+} entry_t;
+
+typedef struct failed_s {
+	struct failed_s* next;
+	char name[1];
+} failed_t;
+
+struct ea_changes_s {
+	ea_group_t* root; // for mem_alloc
+	const char* cache_path;
+	char* cache_buf;
+	ea__table_t files;
+	ea__table_t failed_before; // key: name, has_new: ran in this run
+	failed_t* failed_now;
+};
+
+static void* alloc(ea_changes_t* c, int size) {
+	return c->root->mem_alloc(NULL, size, c->root->mem_alloc_opaque);
+}
+
+static void release(ea_changes_t* c, void* block) {
+	if (block) {
+		c->root->mem_alloc(block, 0, c->root->mem_alloc_opaque);
+	}
+}
+
+static entry_t* lookup(ea_changes_t* c, ea__table_t* table, const char* key, int key_len, int insert) {
+	return (entry_t*)ea__table_lookup(c->root, table, key, key_len, insert);
+}
+
+static void parse_cache(ea_changes_t* c) {
+	for (char* line = c->cache_buf; line && *line; ) {
+		char* end = strchr(line, '\n');
+		char* next = end ? end + 1 : NULL;
+		if (!end) {
+			end = line + strlen(line);
+		}
+		if ((line[0] == 'F') && (line[1] == ' ')) {
+			char* path;
+			unsigned long long hash = strtoull(line + 2, &path, 16);
+			if (*path == ' ') {
+				path++;
+				entry_t* e = lookup(c, &c->files, path, (int)(end - path), 1);
+				e->old_hash = hash;
+				e->has_old = 1;
+			}
+		}
+		else if ((line[0] == 'X') && (line[1] == ' ')) {
+			lookup(c, &c->failed_before, line + 2, (int)(end - line - 2), 1);
+		}
+		line = next;
+	}
+}
+
+ea_changes_t* ea__changes_load(ea_group_t* root, const char* cache_path) {
+	ea_changes_t* c = (ea_changes_t*)root->mem_alloc(NULL, sizeof(ea_changes_t), root->mem_alloc_opaque);
+	memset(c, 0, sizeof(ea_changes_t));
+	c->root = root;
+	c->cache_path = cache_path;
+	c->files.entry_size = sizeof(entry_t);
+	c->failed_before.entry_size = sizeof(entry_t);
+	c->cache_buf = ea__file_read(root, cache_path);
+	parse_cache(c);
+	return c;
+}
+
+static int hash_file(const char* path, unsigned long long* out) {
+	FILE* f = fopen(path, "rb");
+	if (!f) {
+		return 0;
+	}
+	unsigned long long h = EA__FNV_OFFSET;
+	char buf[4096];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		h = ea__fnv1a(h, buf, (int)n);
+	}
+	fclose(f);
+	*out = h;
+	return 1;
+}
+
+// returns nonzero if the file changed since the cached run
+static int check_file(ea_changes_t* c, const char* path) {
+	entry_t* e = lookup(c, &c->files, path, (int)strlen(path), 1);
+	if (!e->considered) {
+		e->considered = 1;
+		e->has_new = (char)hash_file(path, &e->new_hash);
+	}
+	return !e->has_old || !e->has_new || (e->old_hash != e->new_hash);
+}
+
+int ea__changes_select(ea_changes_t* c, const ea_test_t* test, const char* name, int name_len) {
+	int changed = 0;
+	if (lookup(c, &c->failed_before, name, name_len, 0)) {
+		changed = 1;
+	}
+	if (test->file && check_file(c, test->file)) {
+		changed = 1;
+	}
+	for (const ea_group_t* group = test->parent; group; group = group->parent) {
+		for (const ea_dependency_t* dep = group->dependencies; dep; dep = dep->next) {
+			if (check_file(c, dep->path)) {
+				changed = 1;
+			}
+		}
+	}
+	return changed;
+}
+
+void ea__changes_skip(ea_changes_t* c, const ea_test_t* test) {
+	// files of tests that are not checked keep their old fingerprint, so the
+	// change is still detected when those tests are selected next time
+	if (test->file) {
+		lookup(c, &c->files, test->file, (int)strlen(test->file), 1)->blocked = 1;
+	}
+	for (const ea_group_t* group = test->parent; group; group = group->parent) {
+		for (const ea_dependency_t* dep = group->dependencies; dep; dep = dep->next) {
+			lookup(c, &c->files, dep->path, (int)strlen(dep->path), 1)->blocked = 1;
+		}
+	}
+}
+
+void ea__changes_result(ea_changes_t* c, const char* name, int name_len, int failed) {
+	entry_t* e = lookup(c, &c->failed_before, name, name_len, 0);
+	if (e) {
+		e->has_new = 1; // ran, its result replaces the old one
+	}
+	if (failed) {
+		failed_t* f = (failed_t*)alloc(c, (int)sizeof(failed_t) + name_len);
+		memcpy(f->name, name, name_len);
+		f->name[name_len] = '\0';
+		f->next = c->failed_now;
+		c->failed_now = f;
+	}
+}
+
+static void write_cache(ea_changes_t* c) {
+	FILE* f = ea__file_replace_begin(c->cache_path);
+	if (!f) {
+		ea__printf("Cannot write change cache: %s\n", c->cache_path);
+		return;
+	}
+	for (int i = 0; i < c->files.capacity; ++i) {
+		entry_t* e = (entry_t*)ea__table_at(&c->files, i);
+		if (!e) continue;
+		if (e->has_new && !e->blocked) {
+			fprintf(f, "F %016llx %.*s\n", e->new_hash, e->key.len, e->key.name);
+		}
+		else if (e->has_old) {
+			fprintf(f, "F %016llx %.*s\n", e->old_hash, e->key.len, e->key.name);
+		}
+	}
+	for (int i = 0; i < c->failed_before.capacity; ++i) {
+		entry_t* e = (entry_t*)ea__table_at(&c->failed_before, i);
+		if (e && !e->has_new) {
+			fprintf(f, "X %.*s\n", e->key.len, e->key.name);
+		}
+	}
+	for (failed_t* failed = c->failed_now; failed; failed = failed->next) {
+		fprintf(f, "X %s\n", failed->name);
+	}
+	if (!ea__file_replace_end(f, c->cache_path)) {
+		ea__printf("Cannot write change cache: %s\n", c->cache_path);
+	}
+}
+
+void ea__changes_finish(ea_changes_t* c, int write) {
+	if (write) {
+		write_cache(c);
+	}
+	while (c->failed_now) {
+		failed_t* next = c->failed_now->next;
+		release(c, c->failed_now);
+		c->failed_now = next;
+	}
+	ea__table_free(c->root, &c->files);
+	ea__table_free(c->root, &c->failed_before);
+	release(c, c->cache_buf);
+	release(c, c);
+}
+
+void ea_group_add_dependency(ea_group_t* group, const char* path) {
+	ea_dependency_t* dep = (ea_dependency_t*)group->mem_alloc(NULL, sizeof(ea_dependency_t), group->mem_alloc_opaque);
+	dep->path = path;
+	dep->next = NULL;
+	ea_dependency_t** tail = &group->dependencies;
+	while (*tail) {
+		tail = &(*tail)->next;
+	}
+	*tail = dep;
+}
@@ -0,0 +1,273 @@
+#include <string.h>
+
+#ifdef EA_HAVE_PTHREADS
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "ea_internal.h"
+
+/*
+ * In each round the threads count themselves in and spin until the calling
+ * thread releases them all at once, so they hit the shared structure at the
+ * same moment. Each thread has its own test info capturing its first failure
+ * instead of printing it (the output of the threads would interleave); the
+ * calling thread prints the failures after the round. A round is timed from
+ * the release until the last thread finished. Without threads the bodies run
+ * one after another.
+ */
+
+#ifndef CONCURRENT_MAX_THREADS
+#define CONCURRENT_MAX_THREADS 256
+#endif
+
+// longest random wait of a thread after the barrier, from the second round on
+#ifndef CONCURRENT_MAX_DELAY_NS
+#define CONCURRENT_MAX_DELAY_NS 20000
+#endif
+
+// spins between yields while waiting, in case there are more threads than CPUs
+#define CONCURRENT_SPINS_PER_YIELD 1024
+
+#ifdef EA_HAVE_PTHREADS
+#define concurrent_atomic_inc(ptr) __atomic_fetch_add(ptr, 1, __ATOMIC_ACQ_REL)
+#define concurrent_atomic_load(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define concurrent_atomic_store(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#define concurrent_yield() sched_yield()
+#else
+#define concurrent_atomic_inc(ptr) ((*(ptr))++)
+#define concurrent_atomic_load(ptr) (*(ptr))
+#define concurrent_atomic_store(ptr, value) (*(ptr) = (value))
+#define concurrent_yield()
+#endif
+
+typedef struct {
+	ea__concurrent_func_t func;
+	ea__test_func_t after_round; // NULL if none
+	int threads;
+	int rounds;
+} ea_concurrent_test_t;
+
+typedef struct {
+	int ready; // threads waiting at the barrier
+	int go; // released
+} barrier_t;
+
+struct ea_concurrent_s {
+	const ea_concurrent_test_t* test;
+	barrier_t* barrier;
+	ea__test_info_t test_info;
+	char failure_message[EA_RESULT_MESSAGE_LEN];
+	int index;
+	int round;
+	long long ops;
+	unsigned long long rng;
+};
+
+typedef struct {
+	unsigned long long ns;
+	long long ops;
+} round_result_t;
+
+typedef struct {
+	ea_group_t* root; // for mem_alloc
+	int threads;
+	int count; // rounds run
+	round_result_t* rounds;
+} report_t;
+
+int ea_concurrent_thread(const ea_concurrent_t* concurrent) {
+	return concurrent->index;
+}
+
+int ea_concurrent_thread_count(const ea_concurrent_t* concurrent) {
+	return concurrent->test->threads;
+}
+
+int ea_concurrent_round(const ea_concurrent_t* concurrent) {
+	return concurrent->round;
+}
+
+void ea_concurrent_add_ops(ea_concurrent_t* concurrent, long long ops) {
+	concurrent->ops += ops;
+}
+
+static void spin_until(int* value, int expected) {
+	for (int spins = 1; concurrent_atomic_load(value) < expected; ++spins) {
+		if (spins % CONCURRENT_SPINS_PER_YIELD == 0) {
+			concurrent_yield();
+		}
+	}
+}
+
+// splitmix64
+static unsigned long long next_random(unsigned long long* state) {
+	unsigned long long z = (*state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+static void* run_thread(void* opaque) {
+	ea_concurrent_t* thread = (ea_concurrent_t*)opaque;
+	concurrent_atomic_inc(&thread->barrier->ready);
+	spin_until(&thread->barrier->go, 1);
+	if (thread->round > 0) {
+		unsigned long long until = ea__now_ns() + next_random(&thread->rng) % CONCURRENT_MAX_DELAY_NS;
+		while (ea__now_ns() < until) {
+		}
+	}
+	thread->test->func(&thread->test_info, thread);
+	return NULL;
+}
+
+static void print_report(ea__test_info_t* test_info) {
+	report_t* report = (report_t*)test_info->report_opaque;
+	for (int i = 0; i < report->count; ++i) {
+		const round_result_t* r = &report->rounds[i];
+		unsigned long long tenths = r->ns / 100000;
+		unsigned long long per_second = r->ns ? (unsigned long long)((double)r->ops * 1e9 / (double)r->ns) : 0;
+		ea__printf("  Round %d: %d thread(s), %lld op(s) in %llu.%llu ms, %llu ops/s\n",
+			i + 1, report->threads, r->ops, tenths / 10, tenths % 10, per_second);
+	}
+	report->root->mem_alloc(report->rounds, 0, report->root->mem_alloc_opaque);
+	report->root->mem_alloc(report, 0, report->root->mem_alloc_opaque);
+}
+
+// print the failures of the threads and add them to the test, returns nonzero if any
+static int collect(ea__test_info_t* test_info, ea_concurrent_t* threads, int count, int rounds) {
+	int failed = 0;
+	for (int i = 0; i < count; ++i) {
+		ea__test_info_t* thread_info = &threads[i].test_info;
+		test_info->assertion_count += thread_info->assertion_count;
+		if (!thread_info->current_failed) {
+			continue;
+		}
+		failed = 1;
+		if (!test_info->quiet && !test_info->current_failed) {
+			ea__printf("FAILED\n");
+		}
+		// the same assertion tends to fail in every thread, print the first ones of its site
+		if (!test_info->quiet && (!test_info->sites || ea__sites_note(test_info->sites, thread_info->failure_file, thread_info->failure_line))) {
+			const char* short_file = thread_info->failure_file;
+			for (const char* p = short_file; *p; ++p) {
+				if ((*p == '/') || (*p == '\\')) {
+					short_file = p + 1;
+				}
+			}
+			ea__printf("  Thread %d", i);
+			if (rounds > 1) {
+				ea__printf(" in round %d", threads[i].round + 1);
+			}
+			ea__printf(": assertion failed at %s line %d:\n%s", short_file, thread_info->failure_line, threads[i].failure_message);
+		}
+		test_info->current_failed = 1;
+
+		// the first failure is the one of the results
+		if (!test_info->failure_file) {
+			test_info->failure_file = thread_info->failure_file;
+			test_info->failure_line = thread_info->failure_line;
+			if (test_info->failure_message) {
+				memcpy(test_info->failure_message, threads[i].failure_message, EA_RESULT_MESSAGE_LEN);
+				test_info->failure_message_len = -1;
+			}
+		}
+	}
+	return failed;
+}
+
+static void run_concurrent(ea__test_info_t* test_info) {
+	const ea_concurrent_test_t* test = (const ea_concurrent_test_t*)test_info->test->opaque;
+	ea_group_t* root = ea__get_root(test_info->test->parent);
+	int count = test->threads;
+
+	report_t* report = (report_t*)root->mem_alloc(NULL, sizeof(report_t), root->mem_alloc_opaque);
+	report->root = root;
+	report->threads = count;
+	report->count = 0;
+	report->rounds = (round_result_t*)root->mem_alloc(NULL, (int)sizeof(round_result_t) * test->rounds, root->mem_alloc_opaque);
+	test_info->report = print_report;
+	test_info->report_opaque = report;
+
+	ea_concurrent_t* threads = (ea_concurrent_t*)root->mem_alloc(NULL, (int)sizeof(ea_concurrent_t) * count, root->mem_alloc_opaque);
+	barrier_t barrier;
+	unsigned long long seed = ea__now_ns();
+	for (int round = 0; round < test->rounds; ++round) {
+		barrier.ready = 0;
+		barrier.go = 0;
+		for (int i = 0; i < count; ++i) {
+			ea_concurrent_t* thread = &threads[i];
+			memset(thread, 0, sizeof(ea_concurrent_t));
+			thread->test = test;
+			thread->barrier = &barrier;
+			thread->index = i;
+			thread->round = round;
+			thread->rng = seed ^ ((unsigned long long)(round * count + i) * 0xd1b54a32d192ed03ull);
+			thread->test_info.capture = 1;
+			thread->test_info.failure_message = thread->failure_message;
+			thread->test_info.test = test_info->test;
+			thread->test_info.name = test_info->name;
+			thread->test_info.name_len = test_info->name_len;
+		}
+
+		// start the threads, release them together
+		unsigned long long start_ns;
+#ifdef EA_HAVE_PTHREADS
+		pthread_t thread_ids[CONCURRENT_MAX_THREADS];
+		int started = 0;
+		for (; started < count; ++started) {
+			if (pthread_create(&thread_ids[started], NULL, run_thread, &threads[started]) != 0) {
+				break;
+			}
+		}
+		spin_until(&barrier.ready, started);
+		start_ns = ea__now_ns();
+		concurrent_atomic_store(&barrier.go, 1);
+		for (int i = 0; i < started; ++i) {
+			pthread_join(thread_ids[i], NULL);
+		}
+		if (started < count) {
+			if (!test_info->quiet) {
+				if (!test_info->current_failed) {
+					ea__printf("FAILED\n");
+				}
+				ea__printf("  Could not start thread %d of %d\n", started + 1, count);
+			}
+			test_info->current_failed = 1;
+			count = started;
+		}
+#else
+		barrier.go = 1;
+		start_ns = ea__now_ns();
+		for (int i = 0; i < count; ++i) {
+			run_thread(&threads[i]);
+		}
+#endif
+		round_result_t* r = &report->rounds[report->count++];
+		r->ns = ea__now_ns() - start_ns;
+		r->ops = 0;
+		for (int i = 0; i < count; ++i) {
+			r->ops += threads[i].ops ? threads[i].ops : 1;
+		}
+
+		if (collect(test_info, threads, count, test->rounds) || test_info->current_failed) {
+			break;
+		}
+		if (test->after_round) {
+			test->after_round(test_info);
+			if (test_info->current_failed) {
+				break;
+			}
+		}
+	}
+	root->mem_alloc(threads, 0, root->mem_alloc_opaque);
+}
+
+void ea__concurrent_add(ea_group_t* group, ea__concurrent_func_t func, const char* test_name, const char* file, int line, int threads, int rounds, ea__test_func_t after_round) {
+	ea_concurrent_test_t* test = (ea_concurrent_test_t*)group->mem_alloc(NULL, sizeof(ea_concurrent_test_t), group->mem_alloc_opaque);
+	test->func = func;
+	test->after_round = after_round;
+	test->threads = (threads < 1) ? 1 : (threads > CONCURRENT_MAX_THREADS) ? CONCURRENT_MAX_THREADS : threads;
+	test->rounds = (rounds < 1) ? 1 : rounds;
+	ea__test_add_ex(group, run_concurrent, test_name, file, line, test);
+}
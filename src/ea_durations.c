@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ea_internal.h"
+
+/*
+ * Duration history format, one test per line:
+ *   <average ns> <test name>
+ * The average is exponentially weighted, a new sample has weight
+ * 1/DURATIONS_EWMA_DIV.
+ */
+
+#ifndef DURATIONS_EWMA_DIV
+#define DURATIONS_EWMA_DIV 4
+#endif
+
+// prediction for tests without history when nothing is known at all
+#ifndef DURATIONS_DEFAULT_NS
+#define DURATIONS_DEFAULT_NS 1000000ull
+#endif
+
+typedef struct {
+	ea__table_key_t name;
+	char owned; // name allocated (test without history)
+	unsigned long long avg_ns;
+} entry_t;
+
+struct ea_durations_s {
+	ea_group_t* root; // for mem_alloc
+	const char* path;
+	char* buf;
+	ea__table_t entries;
+	unsigned long long known_total; // sum of the loaded averages
+	int known_count;
+};
+
+static entry_t* lookup(ea_durations_t* d, const char* name, int name_len, int insert) {
+	return (entry_t*)ea__table_lookup(d->root, &d->entries, name, name_len, insert);
+}
+
+ea_durations_t* ea__durations_load(ea_group_t* root, const char* path) {
+	ea_durations_t* d = (ea_durations_t*)root->mem_alloc(NULL, sizeof(ea_durations_t), root->mem_alloc_opaque);
+	memset(d, 0, sizeof(ea_durations_t));
+	d->root = root;
+	d->path = path;
+	d->entries.entry_size = sizeof(entry_t);
+	d->buf = ea__file_read(root, path);
+	for (char* line = d->buf; line && *line; ) {
+		char* end = strchr(line, '\n');
+		char* next = end ? end + 1 : NULL;
+		if (!end) {
+			end = line + strlen(line);
+		}
+		char* name;
+		unsigned long long avg = strtoull(line, &name, 10);
+		if ((name != line) && (*name == ' ') && (name + 1 < end)) {
+			name++;
+			lookup(d, name, (int)(end - name), 1)->avg_ns = avg;
+			d->known_total += avg;
+			d->known_count++;
+		}
+		line = next;
+	}
+	return d;
+}
+
+unsigned long long ea__durations_predict(ea_durations_t* d, const char* name, int name_len, int* known) {
+	entry_t* e = lookup(d, name, name_len, 0);
+	*known = (e != NULL);
+	if (e) {
+		return e->avg_ns;
+	}
+	// unknown test: assume it is an average one
+	return d->known_count ? d->known_total / d->known_count : DURATIONS_DEFAULT_NS;
+}
+
+void ea__durations_record(ea_durations_t* d, const char* name, int name_len, unsigned long long ns) {
+	entry_t* e = lookup(d, name, name_len, 0);
+	if (e) {
+		e->avg_ns = e->avg_ns + ((long long)(ns - e->avg_ns)) / DURATIONS_EWMA_DIV;
+		return;
+	}
+	char* copy = (char*)d->root->mem_alloc(NULL, name_len, d->root->mem_alloc_opaque);
+	memcpy(copy, name, name_len);
+	e = lookup(d, copy, name_len, 1);
+	e->owned = 1;
+	e->avg_ns = ns;
+}
+
+static void write_file(ea_durations_t* d) {
+	FILE* f = ea__file_replace_begin(d->path);
+	if (!f) {
+		ea__printf("Cannot write duration history: %s\n", d->path);
+		return;
+	}
+	for (int i = 0; i < d->entries.capacity; ++i) {
+		entry_t* e = (entry_t*)ea__table_at(&d->entries, i);
+		if (e) {
+			fprintf(f, "%llu %.*s\n", e->avg_ns, e->name.len, e->name.name);
+		}
+	}
+	if (!ea__file_replace_end(f, d->path)) {
+		ea__printf("Cannot write duration history: %s\n", d->path);
+	}
+}
+
+void ea__durations_finish(ea_durations_t* d, int write) {
+	if (write) {
+		write_file(d);
+	}
+	for (int i = 0; i < d->entries.capacity; ++i) {
+		entry_t* e = (entry_t*)ea__table_at(&d->entries, i);
+		if (e && e->owned) {
+			d->root->mem_alloc((void*)e->name.name, 0, d->root->mem_alloc_opaque);
+		}
+	}
+	ea__table_free(d->root, &d->entries);
+	if (d->buf) {
+		d->root->mem_alloc(d->buf, 0, d->root->mem_alloc_opaque);
+	}
+	d->root->mem_alloc(d, 0, d->root->mem_alloc_opaque);
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "ea_internal.h"
+
+/*
+ * Helpers of the files kept between runs (change cache, duration history):
+ * tables of entries keyed by names pointing into the loaded file, the
+ * loading of the file and its replacement through a temporary file, so an
+ * interrupted run never leaves half a file behind.
+ */
+
+#ifndef FILE_PATH_MAX
+#define FILE_PATH_MAX 1024
+#endif
+
+unsigned long long ea__fnv1a(unsigned long long h, const void* data, int len) {
+	const unsigned char* p = (const unsigned char*)data;
+	for (int i = 0; i < len; ++i) {
+		h = (h ^ p[i]) * 0x100000001b3ull;
+	}
+	return h;
+}
+
+static ea__table_key_t* slot(const ea__table_t* table, unsigned idx) {
+	return (ea__table_key_t*)(table->entries + (size_t)idx * (size_t)table->entry_size);
+}
+
+void* ea__table_lookup(ea_group_t* root, ea__table_t* table, const char* name, int len, int insert) {
+	if (insert && ((table->count + 1) * 2 > table->capacity)) {
+		// grow
+		ea__table_t grown = *table;
+		grown.capacity = table->capacity ? table->capacity * 2 : 64;
+		grown.entries = (char*)root->mem_alloc(NULL, table->entry_size * grown.capacity, root->mem_alloc_opaque);
+		memset(grown.entries, 0, (size_t)table->entry_size * (size_t)grown.capacity);
+		for (int i = 0; i < table->capacity; ++i) {
+			ea__table_key_t* e = slot(table, (unsigned)i);
+			if (e->name) {
+				unsigned idx = (unsigned)ea__fnv1a(EA__FNV_OFFSET, e->name, e->len) & (grown.capacity - 1);
+				while (slot(&grown, idx)->name) {
+					idx = (idx + 1) & (grown.capacity - 1);
+				}
+				memcpy(slot(&grown, idx), e, (size_t)table->entry_size);
+			}
+		}
+		ea__table_free(root, table);
+		*table = grown;
+	}
+	if (!table->capacity) {
+		return NULL;
+	}
+	unsigned idx = (unsigned)ea__fnv1a(EA__FNV_OFFSET, name, len) & (table->capacity - 1);
+	while (slot(table, idx)->name) {
+		ea__table_key_t* e = slot(table, idx);
+		if ((e->len == len) && (memcmp(e->name, name, len) == 0)) {
+			return e;
+		}
+		idx = (idx + 1) & (table->capacity - 1);
+	}
+	if (!insert) {
+		return NULL;
+	}
+	ea__table_key_t* e = slot(table, idx);
+	e->name = name;
+	e->len = len;
+	table->count++;
+	return e;
+}
+
+void* ea__table_at(const ea__table_t* table, int index) {
+	ea__table_key_t* e = slot(table, (unsigned)index);
+	return e->name ? e : NULL;
+}
+
+void ea__table_free(ea_group_t* root, ea__table_t* table) {
+	if (table->entries) {
+		root->mem_alloc(table->entries, 0, root->mem_alloc_opaque);
+	}
+	table->entries = NULL;
+	table->capacity = 0;
+	table->count = 0;
+}
+
+char* ea__file_read(ea_group_t* root, const char* path) {
+	FILE* f = fopen(path, "rb");
+	if (!f) {
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	char* buf = NULL;
+	if (size >= 0) {
+		buf = (char*)root->mem_alloc(NULL, (int)size + 1, root->mem_alloc_opaque);
+		size = (long)fread(buf, 1, (size_t)size, f);
+		buf[size] = '\0';
+	}
+	fclose(f);
+	return buf;
+}
+
+static int tmp_path(char* buf, const char* path) {
+	return snprintf(buf, FILE_PATH_MAX, "%s.tmp", path) < FILE_PATH_MAX;
+}
+
+FILE* ea__file_replace_begin(const char* path) {
+	char tmp[FILE_PATH_MAX];
+	return tmp_path(tmp, path) ? fopen(tmp, "wb") : NULL;
+}
+
+int ea__file_replace_end(FILE* f, const char* path) {
+	char tmp[FILE_PATH_MAX];
+	int written = !ferror(f);
+	written &= (fclose(f) == 0);
+	if (!tmp_path(tmp, path)) {
+		return 0;
+	}
+	if (!written) {
+		// a short write keeps the previous file
+		remove(tmp);
+		return 0;
+	}
+#ifdef _WIN32
+	// rename() does not replace an existing file here
+	remove(path);
+#endif
+	// on POSIX the file is replaced atomically, readers see the old or the new one
+	return rename(tmp, path) == 0;
+}
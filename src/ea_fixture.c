@@ -0,0 +1,187 @@
+#include <string.h>
+
+#include "ea_internal.h"
+
+struct ea_fixture_s {
+	struct ea_fixture_s* next;
+	const char* name;
+
+	ea_group_setup_teardown_func_t setup, teardown;
+	void* opaque;
+
+	// run state
+	int users_left; // selected tests still to run that need the fixture
+	int built;
+	unsigned stamp; // last walk that visited the fixture
+};
+
+void ea_fixture_create(ea_group_t* group, const char* name,
+	ea_group_setup_teardown_func_t setup, ea_group_setup_teardown_func_t teardown, void* opaque)
+{
+	ea_group_t* root = ea__get_root(group);
+	ea_fixture_t* fixture = (ea_fixture_t*)root->mem_alloc(NULL, sizeof(ea_fixture_t), root->mem_alloc_opaque);
+	fixture->next = root->fixture_registry;
+	fixture->name = name;
+	fixture->setup = setup;
+	fixture->teardown = teardown;
+	fixture->opaque = opaque;
+	fixture->users_left = 0;
+	fixture->built = 0;
+	fixture->stamp = 0;
+	root->fixture_registry = fixture;
+}
+
+// split a comma-separated list into use nodes appended to *list
+void ea__fixtures_add_uses(ea_group_t* group, ea_fixture_use_t** list, const char* names) {
+	while (*list) {
+		list = &(*list)->next;
+	}
+	const char* start = names;
+	for (const char* p = names; ; ++p) {
+		if ((*p == ',') || (*p == '\0')) {
+			if (p > start) {
+				ea_fixture_use_t* use = (ea_fixture_use_t*)group->mem_alloc(NULL, sizeof(ea_fixture_use_t), group->mem_alloc_opaque);
+				use->next = NULL;
+				use->name = start;
+				use->name_len = (int)(p - start);
+				use->fixture = NULL;
+				*list = use;
+				list = &use->next;
+			}
+			if (*p == '\0') {
+				break;
+			}
+			start = p + 1;
+		}
+	}
+}
+
+void ea_group_use_fixtures(ea_group_t* group, const char* fixture_names) {
+	ea__fixtures_add_uses(group, &group->fixtures, fixture_names);
+}
+
+void ea__fixture_uses_free(ea_group_t* group, ea_fixture_use_t* uses) {
+	while (uses) {
+		ea_fixture_use_t* next = uses->next;
+		group->mem_alloc(uses, 0, group->mem_alloc_opaque);
+		uses = next;
+	}
+}
+
+void ea__fixtures_free(ea_group_t* root) {
+	while (root->fixture_registry) {
+		ea_fixture_t* next = root->fixture_registry->next;
+		root->mem_alloc(root->fixture_registry, 0, root->mem_alloc_opaque);
+		root->fixture_registry = next;
+	}
+}
+
+static ea_fixture_t* resolve(ea_group_t* root, ea_fixture_use_t* use) {
+	if (!use->fixture) {
+		for (ea_fixture_t* fixture = root->fixture_registry; fixture; fixture = fixture->next) {
+			if ((strncmp(fixture->name, use->name, use->name_len) == 0) && (fixture->name[use->name_len] == '\0')) {
+				use->fixture = fixture;
+				break;
+			}
+		}
+	}
+	return use->fixture;
+}
+
+typedef void(*fixture_visit_func_t)(ea_fixture_t* fixture);
+
+// visit each fixture the test needs (own and inherited) exactly once
+static void for_each_fixture(const ea_test_t* test, fixture_visit_func_t visit) {
+	ea_group_t* root = ea__get_root(test->parent);
+	if (!root->fixture_registry) {
+		return;
+	}
+	unsigned stamp = ++root->fixture_stamp;
+	ea_fixture_use_t* uses = test->fixtures;
+	ea_group_t* group = test->parent;
+	while (1) {
+		for (ea_fixture_use_t* use = uses; use; use = use->next) {
+			ea_fixture_t* fixture = resolve(root, use);
+			if (fixture && (fixture->stamp != stamp)) {
+				fixture->stamp = stamp;
+				visit(fixture);
+			}
+		}
+		if (!group) {
+			break;
+		}
+		uses = group->fixtures;
+		group = group->parent;
+	}
+}
+
+static void count_user(ea_fixture_t* fixture) {
+	fixture->users_left++;
+}
+
+static void acquire(ea_fixture_t* fixture) {
+	if (!fixture->built) {
+		fixture->built = 1;
+		if (fixture->setup) {
+			fixture->setup(fixture->opaque);
+		}
+	}
+}
+
+static void release(ea_fixture_t* fixture) {
+	if (--fixture->users_left == 0) {
+		fixture->built = 0;
+		if (fixture->teardown) {
+			fixture->teardown(fixture->opaque);
+		}
+	}
+}
+
+void ea__fixtures_count_user(const ea_test_t* test) {
+	for_each_fixture(test, count_user);
+}
+
+void ea__fixtures_acquire(const ea_test_t* test) {
+	for_each_fixture(test, acquire);
+}
+
+void ea__fixtures_release(const ea_test_t* test) {
+	for_each_fixture(test, release);
+}
+
+const void* ea__fixtures_key(const ea_test_t* test) {
+	ea_group_t* root = ea__get_root(test->parent);
+	ea_fixture_use_t* uses = test->fixtures;
+	for (ea_group_t* group = test->parent; ; group = group->parent) {
+		for (ea_fixture_use_t* use = uses; use; use = use->next) {
+			ea_fixture_t* fixture = resolve(root, use);
+			if (fixture) {
+				return fixture;
+			}
+		}
+		if (!group) {
+			return NULL;
+		}
+		uses = group->fixtures;
+	}
+}
+
+void ea__fixtures_finish(ea_group_t* group) {
+	// tear down anything left built (e.g. a run was interrupted) and reset counters
+	for (ea_fixture_t* fixture = ea__get_root(group)->fixture_registry; fixture; fixture = fixture->next) {
+		if (fixture->built && fixture->teardown) {
+			fixture->teardown(fixture->opaque);
+		}
+		fixture->built = 0;
+		fixture->users_left = 0;
+	}
+}
+
+void ea__fixtures_check(ea_group_t* group, ea_fixture_use_t* uses) {
+	ea_group_t* root = ea__get_root(group);
+	for (ea_fixture_use_t* use = uses; use; use = use->next) {
+		if (!resolve(root, use)) {
+			ea__printf("Unknown fixture: %.*s\n", use->name_len, use->name);
+		}
+	}
+}
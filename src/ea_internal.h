@@ -0,0 +1,500 @@
+#ifndef EA_INTERNAL_H_INCLUDED
+#define EA_INTERNAL_H_INCLUDED
+
+#include <stdarg.h>
+#ifndef EA_FREESTANDING
+#include <stdio.h>
+#endif
+
+#include "expectoassertum.h"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(EA_FREESTANDING)
+#define EA_HAVE_POSIX 1
+#endif
+
+#ifndef TESTNAME_BUF_LEN
+#define TESTNAME_BUF_LEN 256
+#endif
+
+#ifndef TESTNAME_WIDTH
+#define TESTNAME_WIDTH 65
+#endif
+
+// tags are bits of a mask, so the number of distinct tags in a tree is limited
+#define EA_MAX_TAGS 64
+typedef unsigned long long ea__tag_mask_t;
+typedef struct ea_tag_index_s ea_tag_index_t;
+
+typedef struct ea_fixture_s ea_fixture_t;
+typedef struct ea_sites_s ea_sites_t;
+
+// fixture requirement of a test or group, resolved by name on first use
+typedef struct ea_fixture_use_s {
+	struct ea_fixture_use_s* next;
+	const char* name; // not null-terminated
+	int name_len;
+	ea_fixture_t* fixture;
+} ea_fixture_use_t;
+
+// source file a group's tests depend on (besides the files defining them)
+typedef struct ea_dependency_s {
+	struct ea_dependency_s* next;
+	const char* path;
+} ea_dependency_t;
+
+typedef struct ea_test_s {
+	// tree
+	struct ea_test_s* next;
+	ea_group_t* parent;
+
+	// info
+	const char* name;
+	const char* file; // file that registered the test
+	int line; // line of the test definition
+
+	// test function
+	ea__test_func_t test_func;
+
+	// kind specific data (e.g. property descriptor), freed with the test
+	void* opaque;
+
+	// required fixtures
+	ea_fixture_use_t* fixtures;
+
+	// own tags (see ea_tags.c)
+	ea__tag_mask_t tags;
+
+	// run on the event loop together with the other async tests of the group
+	int async;
+
+	// stack budget in bytes, 0 for the default of the run
+	int stack_budget;
+
+	// run state
+	int selected; // one of the ea__selected_* values
+} ea_test_t;
+
+enum {
+	ea__selected_no = 0, // filtered out
+	ea__selected_yes,
+	ea__selected_unchanged, // skipped by change-based selection
+	ea__selected_resumed, // finished in a previous run, reported from the journal
+};
+
+struct ea__test_info_s {
+	int total_count; // total executed test count
+	int failed_count; // total failed test count
+	int filtered_count; // total filtered out test count
+	int unchanged_count; // total tests skipped as unchanged
+	int resumed_count; // total tests finished in a previous run (journal)
+
+	int current_failed; // current test failed flag
+	int quiet; // suppress failure output (e.g. while shrinking properties)
+	int capture; // collect the first failure in failure_message instead of printing (threads of concurrent tests)
+
+	// for the results of ea_run_ex()
+	int assertion_count;
+	const char* failure_file; // first failed assertion, NULL if none
+	int failure_line;
+	char* failure_message; // buffer of EA_RESULT_MESSAGE_LEN capturing its details, NULL if not recorded
+	int failure_message_len; // -1 once the details of the first failure are complete
+	void* async; // task of a running async test, NULL for other tests
+	ea_sites_t* sites; // failure counts of the run, NULL to print every failure
+	const char* output; // captured output of a failed test, NULL if none
+	int output_len;
+	int crashed; // the test's process died (isolated tests), current_failed is set too
+
+	ea_bench_environment_t* bench_environment; // of the results, NULL if not recorded
+
+	// printed after the result line (e.g. benchmark results), NULL if nothing
+	void (*report)(ea__test_info_t* test_info);
+	void* report_opaque;
+
+	// currently running test
+	const ea_test_t* test;
+	const char* name; // full name, not null-terminated
+	int name_len;
+};
+
+/**
+ * @brief Run configuration, set through ea_set_option() / ea_parse_cmdline().
+ * Only the root group owns one.
+ */
+typedef struct ea_config_s {
+	// property testing
+	unsigned long long seed;
+	int seed_set;
+	int prop_cases;
+	int prop_time_ms;
+	int prop_threads;
+
+	// change-based selection
+	const char* changed_since; // cache file path
+
+	// tag selection and listing
+	const char* tags; // tag selector, e.g. "slow,~flaky"
+	int list_mode; // one of the ea__list_* values
+
+	// parallel runs
+	int jobs; // number of worker processes, 0 or 1 to run in-process
+	const char* durations; // duration history file path
+
+	// results journal
+	const char* journal; // journal file path
+	int resume; // skip the tests finished in the journal
+
+	// async tests
+	int async_timeout_ms;
+
+	// stack measurement
+	int stack_size; // dedicated test stack size, 0 for the default
+	int stack_budget; // default budget, 0 for none
+
+	// benchmarks
+	int bench_time_ms;
+	int bench_trials; // trials per size, noise control if > 1
+	int bench_cpu; // CPU to pin benchmarks to
+	int bench_cpu_set;
+
+	// profiling
+	const char* profile; // folded stacks directory, NULL if not profiling
+	int profile_hz;
+
+	// server mode
+	const char* serve; // socket path, NULL to run the tests
+
+	// failures printed in full per assertion site, 0 for the default
+	int failures_per_site;
+
+	// output capture
+	int capture; // bytes kept per failed test, 0 if not capturing
+
+	// run each test in a forked child
+	int isolate;
+} ea_config_t;
+
+enum {
+	ea__list_none = 0,
+	ea__list_plain,
+	ea__list_json,
+};
+
+struct ea_group_s {
+	// tree
+	ea_group_t* parent;
+	ea_group_t* next_sibling;
+	ea_group_t* prev_sibling;
+	ea_group_t* children_head;
+	ea_group_t* children_tail;
+	ea_test_t* tests_head;
+	ea_test_t* tests_tail;
+
+	// info
+	const char* name;
+
+	// memory
+	ea_mem_alloc_func_t mem_alloc;
+	void* mem_alloc_opaque;
+
+	// setup/teardown
+	ea_group_setup_teardown_func_t setup, teardown;
+	void* setup_opaque;
+	void* teardown_opaque;
+
+	// required fixtures
+	ea_fixture_use_t* fixtures;
+
+	// extra source files the tests depend on
+	ea_dependency_t* dependencies;
+
+	// own tags, inherited by tests and subgroups
+	ea__tag_mask_t tags;
+
+	// server mode: the setup ran, the teardown is left to ea_release_group()
+	int warm;
+
+	// the setup may run on a thread while the tests before the group run
+	int prewarmable;
+	struct ea_group_s* prewarm_next; // next group with a setup in run order if prewarmable, set by the selection
+
+	// the tests of the group and its subgroups run in forked children
+	int isolated;
+
+	// content registered on demand, NULL once registered (or not lazy)
+	ea_group_register_func_t lazy_register;
+	void* lazy_opaque;
+
+	// root only: run configuration, fixture registry and tag index (allocated on first use)
+	ea_config_t* config;
+	ea_fixture_t* fixture_registry;
+	unsigned fixture_stamp;
+	ea_tag_index_t* tag_index;
+};
+
+typedef struct ea_filter_s ea_filter_t;
+typedef struct ea_changes_s ea_changes_t;
+typedef struct ea_durations_s ea_durations_t;
+typedef struct ea_stack_s ea_stack_t;
+typedef struct ea_journal_s ea_journal_t;
+typedef struct ea_profile_s ea_profile_t;
+typedef struct ea_capture_s ea_capture_t;
+typedef struct ea_prewarm_s ea_prewarm_t;
+
+// tags (ea_tags.c)
+typedef struct {
+	const struct ea_tag_index_s* index;
+	ea__tag_mask_t include, exclude;
+	int has_include;
+} ea__tag_selector_t;
+
+/**
+ * @brief State of an ea_run() call.
+ */
+typedef struct {
+	ea_group_t* group; // group being run
+	const ea_config_t* config;
+	const ea_filter_t* filters;
+	ea__tag_selector_t tags;
+	int use_tags;
+	ea_changes_t* changes;
+	ea_durations_t* durations;
+	ea_stack_t* stack; // dedicated test stack, allocated on first use
+	ea_journal_t* journal;
+	ea_profile_t* profile; // sampler of the tests, NULL if not profiling
+	int warm; // server mode: group setups run once, fixtures stay built
+	ea_sites_t* sites; // failure counts per assertion site
+	ea_capture_t* capture; // stdout/stderr of the tests, NULL if not capturing
+	ea_prewarm_t* prewarm; // setups built ahead on a thread, NULL if not supported or nothing is prewarmable
+	ea_group_t* prewarm_waiting; // selection: groups since the last one with a setup, chained through prewarm_next
+	int prewarm_wanted; // selection: a group after the first one is prewarmable
+	ea__test_info_t info; // totals
+	unsigned long long test_ns; // duration of the last test run
+	int stack_used; // stack bytes touched by the last test, 0 if not measured
+	ea_results_t* results; // recorded results (ea_run_ex()), NULL if not recording
+	int results_cap;
+	char* result_names; // name pool following the records
+	int result_names_len, result_names_cap;
+	unsigned long long makespan_predicted_ns, makespan_ns; // of parallel runs, 0 if unknown
+	int makespan_unknown, makespan_tests; // scheduled tests without a duration history, all scheduled tests
+	char namebuf[TESTNAME_BUF_LEN + 1];
+} ea__run_t;
+
+/**
+ * @brief Run a selected test whose full name is in run->namebuf, print its
+ * result and update the totals.
+ * @return Nonzero if the test failed.
+ */
+int ea__run_test(ea__run_t* run, ea_test_t* test, int namelen);
+
+/**
+ * @brief Run the function of a test (profiled or on a measured stack if
+ * wanted) after resetting the mocks, sets run->test_ns.
+ */
+void ea__run_test_body(ea__run_t* run, ea_test_t* test, ea__test_info_t* test_info);
+
+/**
+ * @brief Second half of ea__run_test(): print OK if passed, update the totals,
+ * record the result and release the fixtures of a test that ran for run->test_ns.
+ * @return The failed flag.
+ */
+int ea__test_finish(ea__run_t* run, ea_test_t* test, int namelen, const ea__test_info_t* test_info, int failed);
+
+/**
+ * @brief Add the result of a test whose full name is in run->namebuf to
+ * run->results (if recording). test_info can be NULL if nothing is known
+ * about the test, e.g. because it crashed.
+ */
+void ea__record_result(ea__run_t* run, const ea_test_t* test, int namelen, ea_test_status_t status, const ea__test_info_t* test_info);
+
+/**
+ * @brief Mark the test failed by a check outside of an assertion (e.g. a time
+ * limit), located at the test for the results. Returns nonzero if the details
+ * are to be printed with ea__fail_printf().
+ */
+int ea__fail_test(ea__test_info_t* test_info);
+
+/**
+ * @brief Print failure details after ea__print_assertion_failed() returned
+ * nonzero, they are also captured for the results.
+ */
+void ea__fail_printf(ea__test_info_t* test_info, const char* fmt, ...);
+
+/**
+ * @brief Print a test name padded to TESTNAME_WIDTH followed by " => ".
+ */
+void ea__print_test_name(const char* name, int namelen);
+
+/**
+ * @brief Write the full name of a group (as seen from the run group top) to buf.
+ * @return Length of the name.
+ */
+int ea__group_name(const ea_group_t* top, const ea_group_t* group, char* buf);
+
+/**
+ * @brief Add a test with kind specific data. The opaque block must be
+ * allocated with the group's mem_alloc, it is released together with the test.
+ */
+ea_test_t* ea__test_add_ex(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line, void* opaque);
+
+/**
+ * @brief Append a name to a test name buffer of TESTNAME_BUF_LEN, separated by '/'.
+ * @return New length of the name in the buffer.
+ */
+int ea__append_name(char* buf, int pos, const char* name);
+
+/**
+ * @brief Get the root of the tree the group belongs to.
+ */
+ea_group_t* ea__get_root(ea_group_t* group);
+
+/**
+ * @brief Get the run configuration of the tree the group belongs to. Never
+ * returns NULL, a default configuration is returned if none was set.
+ */
+const ea_config_t* ea__get_config(const ea_group_t* group);
+
+/**
+ * @brief Monotonic timestamp in nanoseconds, 0 in a freestanding build.
+ */
+unsigned long long ea__now_ns(void);
+
+// output (ea_output.c), stdout or the sink set with ea_set_output()
+void ea__printf(const char* fmt, ...);
+void ea__vprintf(const char* fmt, va_list args);
+void ea__write(const char* data, int len);
+int ea__vformat_append(char* buf, int cap, int len, const char* fmt, va_list args); // to a terminated string, truncated, returns the new length
+void ea__get_output(ea_output_func_t* func, void** opaque);
+
+// fixtures (ea_fixture.c)
+void ea__fixtures_add_uses(ea_group_t* group, ea_fixture_use_t** list, const char* fixture_names);
+void ea__fixture_uses_free(ea_group_t* group, ea_fixture_use_t* uses);
+void ea__fixtures_free(ea_group_t* root);
+void ea__fixtures_check(ea_group_t* group, ea_fixture_use_t* uses); // warn about unknown names
+void ea__fixtures_count_user(const ea_test_t* test); // count a selected test as user of its fixtures
+void ea__fixtures_acquire(const ea_test_t* test); // build the test's fixtures that are not built yet
+void ea__fixtures_release(const ea_test_t* test); // tear down fixtures that lost their last user
+void ea__fixtures_finish(ea_group_t* group); // tear down leftovers, reset counters
+const void* ea__fixtures_key(const ea_test_t* test); // first fixture the test needs, NULL if none
+
+// failure sites (ea_sites.c)
+ea_sites_t* ea__sites_create(ea_group_t* root, int full_limit); // full_limit < 0 for no limit
+int ea__sites_note(ea_sites_t* sites, const char* file, int line); // count a failure, nonzero if it is printed in full
+void ea__sites_int(ea_sites_t* sites, const char* file, int line, long long value); // actual value of the counted failure
+void ea__sites_uint(ea_sites_t* sites, const char* file, int line, unsigned long long value);
+#ifndef EA_NO_DOUBLE
+void ea__sites_double(ea_sites_t* sites, const char* file, int line, double value);
+#endif
+typedef struct {
+	const char* file;
+	int line;
+	int count; // failures since the site was last sent
+	int value_kind; // kind of the values, as in ea_sites.c
+	unsigned long long min, max; // range of the values, double as bits
+} ea__site_change_t;
+int ea__sites_changed(ea_sites_t* sites, ea__site_change_t* change); // next site with unsent failures (of a worker or isolated child), 0 if none
+void ea__sites_merge(ea_sites_t* sites, const ea__site_change_t* change); // add the failures sent by a worker or isolated child
+void ea__sites_finish(ea_sites_t* sites); // print the sites that failed and free
+
+// link-time mocks (ea_mock.c)
+void ea__mock_reset(void); // forget the calls and scripts of every mock, before each test
+
+// files kept between runs (ea_file.c)
+#define EA__FNV_OFFSET 0xcbf29ce484222325ull
+unsigned long long ea__fnv1a(unsigned long long h, const void* data, int len);
+typedef struct {
+	const char* name; // not null-terminated, NULL in a free slot
+	int len;
+} ea__table_key_t;
+typedef struct {
+	char* entries; // capacity entries of entry_size bytes, each starting with an ea__table_key_t
+	int entry_size;
+	int capacity; // power of two
+	int count;
+} ea__table_t;
+void* ea__table_lookup(ea_group_t* root, ea__table_t* table, const char* name, int len, int insert); // NULL if not found and not inserted
+void* ea__table_at(const ea__table_t* table, int index); // entry in the slot, NULL if free
+void ea__table_free(ea_group_t* root, ea__table_t* table);
+#ifndef EA_FREESTANDING
+char* ea__file_read(ea_group_t* root, const char* path); // null-terminated, NULL if it can't be read
+FILE* ea__file_replace_begin(const char* path); // writes a temporary file, NULL on error
+int ea__file_replace_end(FILE* f, const char* path); // closes it and renames it to path if it was written, 0 on error
+#endif
+
+// change-based selection (ea_changes.c)
+ea_changes_t* ea__changes_load(ea_group_t* root, const char* cache_path);
+int ea__changes_select(ea_changes_t* changes, const ea_test_t* test, const char* name, int name_len); // nonzero if the test has to run
+void ea__changes_skip(ea_changes_t* changes, const ea_test_t* test); // test is not checked in this run
+void ea__changes_result(ea_changes_t* changes, const char* name, int name_len, int failed);
+void ea__changes_finish(ea_changes_t* changes, int write); // write the cache (if requested) and free
+
+// duration history (ea_durations.c)
+ea_durations_t* ea__durations_load(ea_group_t* root, const char* path);
+unsigned long long ea__durations_predict(ea_durations_t* durations, const char* name, int name_len, int* known); // known: the test has a history
+void ea__durations_record(ea_durations_t* durations, const char* name, int name_len, unsigned long long ns);
+void ea__durations_finish(ea_durations_t* durations, int write); // write the history (if requested) and free
+
+// results journal (ea_journal.c)
+typedef struct {
+	ea_test_status_t status;
+	unsigned long long duration_ns;
+	int assertion_count;
+} ea__journal_result_t;
+ea_journal_t* ea__journal_open(ea_group_t* root, const char* path, int resume); // NULL on error (printed)
+int ea__journal_lookup(ea_journal_t* journal, const char* name, int name_len, ea__journal_result_t* result); // nonzero if finished in a previous run
+void ea__journal_start(ea_journal_t* journal, const char* name, int name_len);
+void ea__journal_finish(ea_journal_t* journal, const char* name, int name_len, ea_test_status_t status, unsigned long long ns, int assertion_count);
+void ea__journal_close(ea_journal_t* journal);
+
+// profiling (ea_profile.c)
+ea_profile_t* ea__profile_create(ea_group_t* root, const char* dir, int hz); // NULL on error (printed)
+void ea__profile_start(ea_profile_t* profile); // sample the code called after this returns
+void ea__profile_stop(ea_profile_t* profile);
+void ea__profile_report(ea_profile_t* profile, const char* name, int name_len); // write the folded stacks, print the top symbols
+void ea__profile_finish(ea_profile_t* profile);
+
+// output capture (ea_capture.c)
+ea_capture_t* ea__capture_create(ea_group_t* root, int cap); // NULL if not supported (printed)
+void ea__capture_start(ea_capture_t* capture); // redirect stdout and stderr of the test
+void ea__capture_stop(ea_capture_t* capture, ea__test_info_t* test_info); // restore them, print and keep the output of a failed test
+void ea__capture_finish(ea_capture_t* capture);
+
+// prewarmed group setups (ea_prewarm.c)
+void ea__prewarm_select(ea__run_t* run, ea_group_t* group); // link the group (visited in run order) to the next one with a setup
+void ea__prewarm_select_end(ea__run_t* run); // after the selection
+ea_prewarm_t* ea__prewarm_create(ea_group_t* root, const ea__run_t* run); // NULL without threads or if nothing is prewarmable
+void ea__prewarm_next(ea_prewarm_t* prewarm, ea_group_t* group); // start the setup of the group after this one if prewarmable
+int ea__prewarm_wait(ea_prewarm_t* prewarm, ea_group_t* group); // wait for the group's prewarmed setup, 0 if it was not prewarmed
+void ea__prewarm_finish(ea_prewarm_t* prewarm); // print the overlap and free
+
+// tags (ea_tags.c)
+ea__tag_mask_t ea__tags_mask(ea_group_t* group, const char* tags); // intern a comma-separated list
+void ea__tags_selector(ea_group_t* group, const char* tags, ea__tag_selector_t* selector);
+int ea__tags_match(const ea__tag_selector_t* selector, ea__tag_mask_t mask);
+int ea__tags_name(const ea_group_t* root, int bit, const char** name); // returns the name length, 0 if unknown
+void ea__tags_free(ea_group_t* root);
+
+// listing (ea_list.c)
+void ea__list(ea_group_t* group, int json); // print the selected tests
+void ea__print_json_string(const char* s, int len); // quoted and escaped, len < 0 for a terminated string
+
+// server mode (ea_server.c)
+int ea__serve(ea_group_t* group, const char* path); // serve warm runs until the shutdown request, 0 on error (printed)
+ea_results_t* ea__run_warm(ea_group_t* group, const char* filterstring, int record); // ea_run() / ea_run_ex() for the server
+
+// async tests (ea_async.c)
+void ea__async_run(ea__run_t* run, ea_group_t* group, int namepos); // run the selected async tests of the group
+
+// stack measurement (ea_stack.c)
+int ea__stack_wanted(const ea__run_t* run, const ea_test_t* test); // nonzero if the test runs on a dedicated stack
+void ea__stack_run(ea__run_t* run, ea_test_t* test, ea__test_info_t* test_info); // run it there, sets run->stack_used
+void ea__stack_finish(ea_stack_t* stack);
+
+// isolated tests (ea_isolate.c)
+int ea__isolate_wanted(const ea__run_t* run, const ea_test_t* test); // nonzero if the test runs in a forked child
+void ea__isolate_run(ea__run_t* run, ea_test_t* test, ea__test_info_t* test_info); // run the body there, like ea__run_test_body()
+
+// worker processes (ea_parallel.c)
+int ea__cpu_count(void);
+int ea__run_parallel(ea__run_t* run, int jobs); // returns 0 if not supported, the run is done in-process then
+
+#endif // EA_INTERNAL_H_INCLUDED
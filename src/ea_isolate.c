@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "ea_internal.h"
+
+#ifdef EA_HAVE_POSIX
+#include <errno.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/*
+ * An isolated test runs in a child forked right before its function. The
+ * group setups and shared fixtures were built by the parent, so the child
+ * sees them copy-on-write: it may change them freely, the next test gets
+ * them as the parent left them, and the teardowns run once in the parent.
+ * The child runs the test function, flushes its output and sends the
+ * outcome through a pipe, followed by the failure sites it changed, which
+ * the parent merges as it does for workers; a child exiting without an
+ * outcome is reported as crashed. Tests with kind specific data (property
+ * tests, benchmarks, concurrent tests) keep running in the parent, as their
+ * reports need the state the function built.
+ */
+
+#ifndef EA_HAVE_POSIX
+
+int ea__isolate_wanted(const ea__run_t* run, const ea_test_t* test) {
+	(void)run;
+	(void)test;
+	return 0;
+}
+
+void ea__isolate_run(ea__run_t* run, ea_test_t* test, ea__test_info_t* test_info) {
+	ea__run_test_body(run, test, test_info);
+}
+
+#else
+
+typedef struct {
+	int failed;
+	int assertion_count;
+	int stack_used;
+	const char* failure_file; // the child has the parent's image, so the pointer is valid there
+	int failure_line;
+	int failure_message_len; // followed by that many bytes
+	unsigned long long test_ns;
+} outcome_t;
+
+int ea__isolate_wanted(const ea__run_t* run, const ea_test_t* test) {
+	if (test->opaque || test->async || run->profile) {
+		return 0;
+	}
+	if (run->config->isolate) {
+		return 1;
+	}
+	for (const ea_group_t* group = test->parent; group; group = group->parent) {
+		if (group->isolated) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int read_full(int fd, void* data, int size) {
+	char* p = (char*)data;
+	while (size > 0) {
+		ssize_t n = read(fd, p, (size_t)size);
+		if ((n < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (n <= 0) {
+			return 0;
+		}
+		p += n;
+		size -= (int)n;
+	}
+	return 1;
+}
+
+static void write_full(int fd, const void* data, int size) {
+	const char* p = (const char*)data;
+	while (size > 0) {
+		ssize_t n = write(fd, p, (size_t)size);
+		if ((n < 0) && (errno == EINTR)) {
+			continue;
+		}
+		if (n <= 0) {
+			return;
+		}
+		p += n;
+		size -= (int)n;
+	}
+}
+
+static void child_main(ea__run_t* run, ea_test_t* test, ea__test_info_t* test_info, int fd) {
+	// only the test's own failures are sent, the parent keeps the ones before it
+	ea__site_change_t change;
+	while (run->sites && ea__sites_changed(run->sites, &change)) {
+	}
+	ea__run_test_body(run, test, test_info);
+
+	// the output comes before the parent prints the result
+	fflush(stdout);
+	fflush(stderr);
+	outcome_t outcome;
+	memset(&outcome, 0, sizeof(outcome));
+	outcome.failed = test_info->current_failed;
+	outcome.assertion_count = test_info->assertion_count;
+	outcome.stack_used = run->stack_used;
+	outcome.failure_file = test_info->failure_file;
+	outcome.failure_line = test_info->failure_line;
+	outcome.failure_message_len = test_info->failure_message ? (int)strlen(test_info->failure_message) : 0;
+	outcome.test_ns = run->test_ns;
+	write_full(fd, &outcome, sizeof(outcome));
+	write_full(fd, test_info->failure_message, outcome.failure_message_len);
+
+	// the failure sites of the test, ended by one without a file
+	while (run->sites && ea__sites_changed(run->sites, &change)) {
+		write_full(fd, &change, sizeof(change));
+	}
+	memset(&change, 0, sizeof(change));
+	write_full(fd, &change, sizeof(change));
+	_exit(0); // no atexit handlers, the parent owns the process state
+}
+
+void ea__isolate_run(ea__run_t* run, ea_test_t* test, ea__test_info_t* test_info) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		ea__run_test_body(run, test, test_info);
+		return;
+	}
+	fflush(stdout);
+	fflush(stderr);
+	unsigned long long start_ns = ea__now_ns();
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		ea__run_test_body(run, test, test_info);
+		return;
+	}
+	if (pid == 0) {
+		close(fds[0]);
+		child_main(run, test, test_info, fds[1]);
+	}
+	close(fds[1]);
+
+	outcome_t outcome;
+	ea__site_change_t change;
+	int received = read_full(fds[0], &outcome, sizeof(outcome));
+	if (received && (outcome.failure_message_len > 0) && test_info->failure_message) {
+		int len = (outcome.failure_message_len < EA_RESULT_MESSAGE_LEN) ? outcome.failure_message_len : EA_RESULT_MESSAGE_LEN - 1;
+		received = read_full(fds[0], test_info->failure_message, len);
+		test_info->failure_message[received ? len : 0] = '\0';
+	}
+	while (received && read_full(fds[0], &change, sizeof(change)) && change.file) {
+		if (run->sites) {
+			ea__sites_merge(run->sites, &change);
+		}
+	}
+	close(fds[0]);
+	int status = 0;
+	while ((waitpid(pid, &status, 0) < 0) && (errno == EINTR)) {
+	}
+
+	// the child died in the test function
+	if (!received) {
+		run->test_ns = ea__now_ns() - start_ns;
+		test_info->current_failed = 1;
+		test_info->crashed = 1;
+		test_info->failure_file = test->file; // what the child failed before is lost with it
+		test_info->failure_line = test->line;
+		test_info->failure_message_len = 0;
+		if (WIFSIGNALED(status)) {
+			ea__fail_printf(test_info, "CRASHED (signal %d)\n", WTERMSIG(status));
+		}
+		else {
+			ea__fail_printf(test_info, "CRASHED (exit code %d)\n", WEXITSTATUS(status));
+		}
+		return;
+	}
+	test_info->current_failed = outcome.failed;
+	test_info->assertion_count = outcome.assertion_count;
+	test_info->failure_file = outcome.failure_file;
+	test_info->failure_line = outcome.failure_line;
+	run->stack_used = outcome.stack_used;
+	run->test_ns = outcome.test_ns;
+}
+
+#endif // EA_HAVE_POSIX
@@ -0,0 +1,297 @@
+#include <string.h>
+
+#include "ea_internal.h"
+
+#ifdef EA_HAVE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * The journal is a memory-mapped file of fixed-size records after a header.
+ * A test gets a record when it starts, marked finished with its result when
+ * it ends, so after a crash (or kill) of the run the unfinished record names
+ * the test that was running. The file grows in steps, unused records are
+ * zero. The state is written last, a record is valid once it is set.
+ */
+
+#ifndef JOURNAL_INITIAL_RECORDS
+#define JOURNAL_INITIAL_RECORDS 256
+#endif
+
+// wait until each finished record is on the disk (survives power loss), 0
+// leaves it to the kernel (survives crashes of the process only)
+#ifndef JOURNAL_SYNC
+#define JOURNAL_SYNC 1
+#endif
+
+#define JOURNAL_MAGIC "EAJRNL01"
+
+enum {
+	state_unused = 0,
+	state_started = 0x53545254, // "STRT"
+	state_finished = 0x444f4e45, // "DONE"
+};
+
+typedef struct {
+	char magic[8];
+	unsigned record_size;
+	unsigned reserved;
+} header_t;
+
+typedef struct {
+	volatile unsigned state;
+	int status; // ea_test_status_t once finished
+	unsigned long long duration_ns;
+	int assertion_count;
+	int name_len;
+	char name[TESTNAME_BUF_LEN];
+} record_t;
+
+#ifndef EA_HAVE_POSIX
+
+ea_journal_t* ea__journal_open(ea_group_t* root, const char* path, int resume) {
+	(void)root;
+	(void)path;
+	(void)resume;
+	ea__printf("The results journal is not supported on this platform.\n");
+	return NULL;
+}
+
+int ea__journal_lookup(ea_journal_t* journal, const char* name, int name_len, ea__journal_result_t* result) {
+	(void)journal;
+	(void)name;
+	(void)name_len;
+	(void)result;
+	return 0;
+}
+
+void ea__journal_start(ea_journal_t* journal, const char* name, int name_len) {
+	(void)journal;
+	(void)name;
+	(void)name_len;
+}
+
+void ea__journal_finish(ea_journal_t* journal, const char* name, int name_len, ea_test_status_t status, unsigned long long ns, int assertion_count) {
+	(void)journal;
+	(void)name;
+	(void)name_len;
+	(void)status;
+	(void)ns;
+	(void)assertion_count;
+}
+
+void ea__journal_close(ea_journal_t* journal) {
+	(void)journal;
+}
+
+#else
+
+struct ea_journal_s {
+	ea_group_t* root; // for mem_alloc
+	int fd;
+	char* map;
+	long long map_size;
+	int capacity; // records in the map
+	int count; // used records
+	int resumed; // records of previous runs
+	int current; // started record of the running test, -1 if none
+
+	// index of the records of previous runs by name, power of two
+	int* index;
+	int index_capacity;
+};
+
+static record_t* get_record(ea_journal_t* journal, int i) {
+	return (record_t*)(journal->map + sizeof(header_t)) + i;
+}
+
+static unsigned hash_name(const char* name, int len) {
+	unsigned h = 2166136261u;
+	for (int i = 0; i < len; ++i) {
+		h = (h ^ (unsigned char)name[i]) * 16777619u;
+	}
+	return h;
+}
+
+// (re)map the file with room for capacity records, the old map stays if this fails
+static int map_file(ea_journal_t* journal, int capacity) {
+	long long size = (long long)sizeof(header_t) + (long long)sizeof(record_t) * capacity;
+	if (ftruncate(journal->fd, (off_t)size) != 0) {
+		return 0;
+	}
+	void* map = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, journal->fd, 0);
+	if (map == MAP_FAILED) {
+		return 0;
+	}
+	if (journal->map) {
+		munmap(journal->map, (size_t)journal->map_size);
+	}
+	journal->map = (char*)map;
+	journal->map_size = size;
+	journal->capacity = capacity;
+	return 1;
+}
+
+// write a record range back to the file
+static void sync_record(ea_journal_t* journal, int i, int flags) {
+	long page = sysconf(_SC_PAGESIZE);
+	size_t start = (size_t)((char*)get_record(journal, i) - journal->map);
+	size_t end = start + sizeof(record_t);
+	start -= start % (size_t)page;
+	msync(journal->map + start, end - start, flags);
+}
+
+static void build_index(ea_journal_t* journal) {
+	int capacity = 64;
+	while (capacity < journal->resumed * 2) {
+		capacity *= 2;
+	}
+	journal->index = (int*)journal->root->mem_alloc(NULL, (int)sizeof(int) * capacity, journal->root->mem_alloc_opaque);
+	journal->index_capacity = capacity;
+	for (int i = 0; i < capacity; ++i) {
+		journal->index[i] = -1;
+	}
+	for (int i = 0; i < journal->resumed; ++i) {
+		const record_t* r = get_record(journal, i);
+		unsigned idx = hash_name(r->name, r->name_len) & (capacity - 1);
+		while (journal->index[idx] >= 0) {
+			idx = (idx + 1) & (capacity - 1);
+		}
+		journal->index[idx] = i;
+	}
+}
+
+ea_journal_t* ea__journal_open(ea_group_t* root, const char* path, int resume) {
+	int fd = open(path, O_RDWR | O_CREAT | (resume ? 0 : O_TRUNC), 0644);
+	if (fd < 0) {
+		ea__printf("Cannot open the results journal: %s\n", path);
+		return NULL;
+	}
+	ea_journal_t* journal = (ea_journal_t*)root->mem_alloc(NULL, sizeof(ea_journal_t), root->mem_alloc_opaque);
+	memset(journal, 0, sizeof(ea_journal_t));
+	journal->root = root;
+	journal->fd = fd;
+	journal->current = -1;
+
+	// check the header of an existing journal
+	struct stat st;
+	int existing = (fstat(fd, &st) == 0) && (st.st_size > 0);
+	if (existing) {
+		header_t header;
+		int valid = (read(fd, &header, sizeof(header)) == (ssize_t)sizeof(header))
+			&& (memcmp(header.magic, JOURNAL_MAGIC, 8) == 0) && (header.record_size == sizeof(record_t));
+		if (!valid) {
+			ea__printf("Not a results journal (or of another version): %s\n", path);
+			close(fd);
+			root->mem_alloc(journal, 0, root->mem_alloc_opaque);
+			return NULL;
+		}
+	}
+	int capacity = JOURNAL_INITIAL_RECORDS;
+	long long existing_records = existing ? (st.st_size - (long long)sizeof(header_t)) / (long long)sizeof(record_t) : 0;
+	while (capacity < existing_records) {
+		capacity *= 2;
+	}
+	if (!map_file(journal, capacity)) {
+		ea__printf("Cannot map the results journal: %s\n", path);
+		close(fd);
+		root->mem_alloc(journal, 0, root->mem_alloc_opaque);
+		return NULL;
+	}
+	if (!existing) {
+		header_t* header = (header_t*)journal->map;
+		memcpy(header->magic, JOURNAL_MAGIC, 8);
+		header->record_size = sizeof(record_t);
+	}
+
+	// records of previous runs, a started one was running when the run died
+	while ((journal->count < journal->capacity) && (get_record(journal, journal->count)->state != state_unused)) {
+		record_t* r = get_record(journal, journal->count);
+		if (r->state == state_started) {
+			r->status = EA_TEST_CRASHED;
+			r->state = state_finished;
+			sync_record(journal, journal->count, MS_ASYNC);
+		}
+		journal->count++;
+	}
+	journal->resumed = journal->count;
+	if (journal->resumed) {
+		build_index(journal);
+	}
+	return journal;
+}
+
+int ea__journal_lookup(ea_journal_t* journal, const char* name, int name_len, ea__journal_result_t* result) {
+	if (!journal->index) {
+		return 0;
+	}
+	unsigned idx = hash_name(name, name_len) & (journal->index_capacity - 1);
+	while (journal->index[idx] >= 0) {
+		const record_t* r = get_record(journal, journal->index[idx]);
+		if ((r->name_len == name_len) && (memcmp(r->name, name, name_len) == 0)) {
+			result->status = (ea_test_status_t)r->status;
+			result->duration_ns = r->duration_ns;
+			result->assertion_count = r->assertion_count;
+			return 1;
+		}
+		idx = (idx + 1) & (journal->index_capacity - 1);
+	}
+	return 0;
+}
+
+// append a record with everything but the state, -1 if the journal can't grow
+static int append(ea_journal_t* journal, const char* name, int name_len) {
+	if ((journal->count == journal->capacity) && !map_file(journal, journal->capacity * 2)) {
+		return -1;
+	}
+	int i = journal->count++;
+	record_t* r = get_record(journal, i);
+	memcpy(r->name, name, name_len);
+	r->name_len = name_len;
+	return i;
+}
+
+void ea__journal_start(ea_journal_t* journal, const char* name, int name_len) {
+	int i = append(journal, name, name_len);
+	if (i >= 0) {
+		get_record(journal, i)->state = state_started;
+		sync_record(journal, i, MS_ASYNC);
+	}
+	journal->current = i;
+}
+
+void ea__journal_finish(ea_journal_t* journal, const char* name, int name_len, ea_test_status_t status, unsigned long long ns, int assertion_count) {
+	// the started record, or a new one for tests not started through the journal (async, workers)
+	int i = journal->current;
+	journal->current = -1;
+	if ((i < 0) || (get_record(journal, i)->name_len != name_len) || (memcmp(get_record(journal, i)->name, name, name_len) != 0)) {
+		i = append(journal, name, name_len);
+		if (i < 0) {
+			return;
+		}
+	}
+	record_t* r = get_record(journal, i);
+	r->status = (int)status;
+	r->duration_ns = ns;
+	r->assertion_count = assertion_count;
+	r->state = state_finished;
+	sync_record(journal, i, JOURNAL_SYNC ? MS_SYNC : MS_ASYNC);
+}
+
+void ea__journal_close(ea_journal_t* journal) {
+	ea_group_t* root = journal->root;
+	if (journal->map) {
+		msync(journal->map, (size_t)journal->map_size, MS_SYNC);
+		munmap(journal->map, (size_t)journal->map_size);
+	}
+	close(journal->fd);
+	if (journal->index) {
+		root->mem_alloc(journal->index, 0, root->mem_alloc_opaque);
+	}
+	root->mem_alloc(journal, 0, root->mem_alloc_opaque);
+}
+
+#endif // EA_HAVE_POSIX
@@ -0,0 +1,100 @@
+#include "ea_internal.h"
+
+void ea__print_json_string(const char* s, int len) {
+	ea__printf("\"");
+	for (int i = 0; (len < 0) ? (s[i] != '\0') : (i < len); ++i) {
+		unsigned char c = (unsigned char)s[i];
+		if ((c == '"') || (c == '\\')) {
+			ea__printf("\\%c", c);
+		}
+		else if (c < 0x20) {
+			ea__printf("\\u%04x", c);
+		}
+		else {
+			ea__printf("%c", c);
+		}
+	}
+	ea__printf("\"");
+}
+
+typedef struct {
+	const ea_group_t* root;
+	int json;
+	int count;
+	char namebuf[TESTNAME_BUF_LEN + 1];
+} list_t;
+
+static void print_test(list_t* list, const ea_test_t* test, int namelen, ea__tag_mask_t tags) {
+	const char* tagname;
+	if (list->json) {
+		ea__printf("%s\n    {\"name\": ", list->count ? "," : "");
+		ea__print_json_string(list->namebuf, namelen);
+		ea__printf(", \"tags\": [");
+		int first = 1;
+		for (int bit = 0; bit < EA_MAX_TAGS; ++bit) {
+			if (tags & ((ea__tag_mask_t)1 << bit)) {
+				int taglen = ea__tags_name(list->root, bit, &tagname);
+				ea__printf("%s", first ? "" : ", ");
+				ea__print_json_string(tagname, taglen);
+				first = 0;
+			}
+		}
+		ea__printf("], \"file\": ");
+		ea__print_json_string(test->file ? test->file : "", -1);
+		ea__printf(", \"line\": %d%s}", test->line, test->async ? ", \"async\": true" : "");
+	}
+	else {
+		ea__printf("%.*s", namelen, list->namebuf);
+		if (tags) {
+			int first = 1;
+			for (int bit = 0; bit < EA_MAX_TAGS; ++bit) {
+				if (tags & ((ea__tag_mask_t)1 << bit)) {
+					int taglen = ea__tags_name(list->root, bit, &tagname);
+					ea__printf("%s%.*s", first ? " [" : ",", taglen, tagname);
+					first = 0;
+				}
+			}
+			ea__printf("]");
+		}
+		if (test->file) {
+			ea__printf(" %s:%d", test->file, test->line);
+		}
+		ea__printf("\n");
+	}
+	list->count++;
+}
+
+static void list_group(list_t* list, const ea_group_t* group, int namebufpos, ea__tag_mask_t tags) {
+	namebufpos = ea__append_name(list->namebuf, namebufpos, group->name);
+	tags |= group->tags;
+	for (const ea_test_t* test = group->tests_head; test; test = test->next) {
+		if (test->selected == ea__selected_yes) {
+			int testnamepos = ea__append_name(list->namebuf, namebufpos, test->name);
+			print_test(list, test, testnamepos, tags | test->tags);
+		}
+	}
+	for (const ea_group_t* child = group->children_head; child; child = child->next_sibling) {
+		list_group(list, child, namebufpos, tags);
+	}
+}
+
+void ea__list(ea_group_t* group, int json) {
+	list_t list;
+	list.root = ea__get_root(group);
+	list.json = json;
+	list.count = 0;
+
+	// tags inherited from the ancestors of the listed group
+	ea__tag_mask_t tags = 0;
+	for (const ea_group_t* g = group->parent; g; g = g->parent) {
+		tags |= g->tags;
+	}
+
+	if (json) {
+		ea__printf("{\"tests\": [");
+	}
+	list_group(&list, group, 0, tags);
+	if (json) {
+		ea__printf("%s]}\n", list.count ? "\n" : "");
+	}
+}
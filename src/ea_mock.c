@@ -0,0 +1,162 @@
+#include <stddef.h>
+
+#include "ea_internal.h"
+
+/*
+ * The calls of all mocks go to one ring buffer of fixed size, so recording a
+ * call never allocates. The ring keeps the last MOCK_RING_LEN calls of a
+ * test, the call counts of the mocks stay exact when it wraps around. A mock
+ * joins the list of used mocks with its first call or script; the list is
+ * reset before each test.
+ */
+
+#ifndef MOCK_RING_LEN
+#define MOCK_RING_LEN 256
+#endif
+
+#define MOCK_MAX_ARGS 8 // see ea__mock_values() in expectoassertum.h
+#define MOCK_PRINTED_CALLS 8 // recorded calls listed by a failed ASSERT_CALLED_WITH
+
+typedef struct {
+	const ea__mock_t* mock;
+	int call; // index of the call of the mock
+	int argc;
+	unsigned long long argv[MOCK_MAX_ARGS];
+} mock_call_t;
+
+static mock_call_t mock_ring[MOCK_RING_LEN];
+static unsigned mock_ring_count; // calls recorded in the test, the ring holds the last ones
+static ea__mock_t* mock_used;
+
+static void mock_use(ea__mock_t* mock) {
+	if (!mock->used) {
+		mock->used = 1;
+		mock->next = mock_used;
+		mock_used = mock;
+	}
+}
+
+void ea__mock_reset(void) {
+	for (ea__mock_t* mock = mock_used; mock; mock = mock->next) {
+		mock->calls = 0;
+		mock->returns = 0;
+		mock->returned = 0;
+		mock->repeat = 0;
+		mock->stub = 0;
+	}
+	mock_ring_count = 0;
+}
+
+int ea__mock_call(ea__mock_t* mock, int argc, const unsigned long long* argv) {
+	mock_use(mock);
+	mock_call_t* entry = &mock_ring[mock_ring_count++ % MOCK_RING_LEN];
+	entry->mock = mock;
+	entry->call = mock->calls++;
+	entry->argc = argc;
+	for (int i = 0; i < argc; ++i) {
+		entry->argv[i] = argv[i];
+	}
+
+	// scripted values first, then the last one again if repeated
+	if (mock->returned < mock->returns) {
+		return mock->returned++;
+	}
+	if (mock->repeat && mock->returns) {
+		return mock->returns - 1;
+	}
+	return mock->stub ? ea__mock_zero : ea__mock_real;
+}
+
+int ea__mock_script(ea__mock_t* mock, int repeat) {
+	mock_use(mock);
+	mock->repeat = repeat;
+	if (mock->returns < EA_MOCK_RETURNS) {
+		mock->returns++;
+	}
+	return mock->returns - 1;
+}
+
+void ea__mock_stub(ea__mock_t* mock) {
+	mock_use(mock);
+	mock->stub = 1;
+}
+
+// the recorded call, NULL if it was overwritten
+static const mock_call_t* find_call(const ea__mock_t* mock, int call) {
+	unsigned kept = (mock_ring_count < MOCK_RING_LEN) ? mock_ring_count : MOCK_RING_LEN;
+	for (unsigned i = 1; i <= kept; ++i) {
+		const mock_call_t* entry = &mock_ring[(mock_ring_count - i) % MOCK_RING_LEN];
+		if ((entry->mock == mock) && (entry->call == call)) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+unsigned long long ea__mock_arg(const ea__mock_t* mock, int call, int index) {
+	if (call < 0) {
+		call += mock->calls;
+	}
+	if ((call < 0) || (call >= mock->calls)) {
+		return 0;
+	}
+	const mock_call_t* entry = find_call(mock, call);
+	return (entry && (index >= 0) && (index < entry->argc)) ? entry->argv[index] : 0;
+}
+
+// small values as signed numbers, others (e.g. pointers) in hex
+static void print_call(ea__test_info_t* test_info, const mock_call_t* entry) {
+	ea__fail_printf(test_info, "    %s(", entry->mock->name);
+	for (int i = 0; i < entry->argc; ++i) {
+		long long value = (long long)entry->argv[i];
+		const char* sep = (i + 1 < entry->argc) ? ", " : "";
+		if ((value >= -0x80000000LL) && (value <= 0xffffffffLL)) {
+			ea__fail_printf(test_info, "%lld%s", value, sep);
+		}
+		else {
+			ea__fail_printf(test_info, "0x%llx%s", entry->argv[i], sep);
+		}
+	}
+	ea__fail_printf(test_info, ")\n");
+}
+
+int ea__mock_called_with_check(ea__test_info_t* test_info, const ea__mock_t* mock, int argc, const unsigned long long* argv, const char* sargs, const char* file, int line) {
+	test_info->assertion_count++;
+	unsigned kept = (mock_ring_count < MOCK_RING_LEN) ? mock_ring_count : MOCK_RING_LEN;
+	for (unsigned k = 1; k <= kept; ++k) {
+		const mock_call_t* entry = &mock_ring[(mock_ring_count - k) % MOCK_RING_LEN];
+		if ((entry->mock != mock) || (entry->argc != argc)) {
+			continue;
+		}
+		int i = 0;
+		while ((i < argc) && (entry->argv[i] == argv[i])) {
+			++i;
+		}
+		if (i == argc) {
+			return 1;
+		}
+	}
+
+	// assertion failed, list the last calls
+	if (!ea__print_assertion_failed(test_info, file, line)) {
+		return 0;
+	}
+	ea__fail_printf(test_info, "  Expected a call of %s(%s)\n", mock->name, sargs);
+	if (!mock->calls) {
+		ea__fail_printf(test_info, "  but it was not called\n");
+		return 0;
+	}
+	ea__fail_printf(test_info, "  Recorded calls (%d, latest first):\n", mock->calls);
+	int shown = 0;
+	for (int call = mock->calls - 1; (call >= 0) && (shown < MOCK_PRINTED_CALLS); --call) {
+		const mock_call_t* entry = find_call(mock, call);
+		if (entry) {
+			print_call(test_info, entry);
+			shown++;
+		}
+	}
+	if (shown < mock->calls) {
+		ea__fail_printf(test_info, "    (%d earlier call(s) not shown)\n", mock->calls - shown);
+	}
+	return 0;
+}
@@ -0,0 +1,411 @@
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "ea_internal.h"
+
+#ifndef EA_FREESTANDING
+#include <stdio.h>
+#endif
+
+/*
+ * All output of the framework goes through ea__printf(). Without a sink it is
+ * stdout (nothing in a freestanding build), with a sink the text is formatted
+ * by the small formatter below, which knows the conversions the framework
+ * uses: %d %i %u %x %X %c %s %p %%, the h/l/ll/z length modifiers, the '-'
+ * and '0' flags, width and precision (also '*'), and %f %e %g unless
+ * EA_NO_DOUBLE is set.
+ */
+
+#ifndef OUTPUT_CHUNK_LEN
+#define OUTPUT_CHUNK_LEN 64
+#endif
+
+static ea_output_func_t output_func = 0;
+static void* output_opaque = 0;
+
+void ea_set_output(ea_output_func_t func, void* opaque) {
+	output_func = func;
+	output_opaque = opaque;
+}
+
+void ea__get_output(ea_output_func_t* func, void** opaque) {
+	*func = output_func;
+	*opaque = output_opaque;
+}
+
+typedef struct {
+	char buf[OUTPUT_CHUNK_LEN];
+	int len;
+
+	// target string instead of the sink, NULL if none
+	char* str;
+	int str_len, str_cap;
+} out_t;
+
+static void flush(out_t* out) {
+	if (out->len && out->str) {
+		// append what fits, keep the string terminated
+		for (int i = 0; (i < out->len) && (out->str_len < out->str_cap - 1); ++i) {
+			out->str[out->str_len++] = out->buf[i];
+		}
+		out->str[out->str_len] = '\0';
+		out->len = 0;
+	}
+	else if (out->len) {
+		output_func(out->buf, out->len, output_opaque);
+		out->len = 0;
+	}
+}
+
+static void put(out_t* out, const char* s, int n) {
+	for (int i = 0; i < n; ++i) {
+		if (out->len == OUTPUT_CHUNK_LEN) {
+			flush(out);
+		}
+		out->buf[out->len++] = s[i];
+	}
+}
+
+static void pad(out_t* out, char c, int n) {
+	for (int i = 0; i < n; ++i) {
+		put(out, &c, 1);
+	}
+}
+
+// put a field: sign/prefix, zeros, digits, padded to width
+static void put_field(out_t* out, const char* prefix, int prefix_len, int zeros, const char* s, int n, int width, int left) {
+	int len = prefix_len + zeros + n;
+	if (!left) {
+		pad(out, ' ', width - len);
+	}
+	put(out, prefix, prefix_len);
+	pad(out, '0', zeros);
+	put(out, s, n);
+	if (left) {
+		pad(out, ' ', width - len);
+	}
+}
+
+// digits of v, written backwards from end, returns the start
+static char* utoa(char* end, unsigned long long v, int base, int upper) {
+	const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	char* p = end;
+	do {
+		*--p = digits[v % base];
+		v /= base;
+	} while (v);
+	return p;
+}
+
+#ifndef EA_NO_DOUBLE
+
+// format a finite non-negative double in fixed (exp < 0) or exponent notation
+// into buf, returns the length
+static int ftoa(char* buf, double v, int precision, int exp_notation, int trim) {
+	if (precision > 17) {
+		precision = 17;
+	}
+	int exp10 = 0;
+	if (exp_notation && (v != 0.0)) {
+		while (v >= 10.0) {
+			v /= 10.0;
+			exp10++;
+		}
+		while (v < 1.0) {
+			v *= 10.0;
+			exp10--;
+		}
+	}
+	unsigned long long scale = 1;
+	for (int i = 0; i < precision; ++i) {
+		scale *= 10;
+	}
+	unsigned long long ipart = (unsigned long long)v;
+	unsigned long long fpart = (unsigned long long)((v - (double)ipart) * (double)scale + 0.5);
+	if (fpart >= scale) {
+		fpart -= scale;
+		ipart++;
+		if (exp_notation && (ipart == 10)) {
+			ipart = 1;
+			exp10++;
+		}
+	}
+
+	char tmp[24];
+	char* end = tmp + sizeof(tmp);
+	char* p = utoa(end, ipart, 10, 0);
+	int len = (int)(end - p);
+	for (int i = 0; i < len; ++i) {
+		buf[i] = p[i];
+	}
+	if (precision > 0) {
+		p = utoa(end, fpart, 10, 0);
+		int flen = (int)(end - p);
+		int dot = len;
+		buf[len++] = '.';
+		for (int i = flen; i < precision; ++i) {
+			buf[len++] = '0';
+		}
+		for (int i = 0; i < flen; ++i) {
+			buf[len++] = p[i];
+		}
+		if (trim) {
+			while (buf[len - 1] == '0') {
+				len--;
+			}
+			if (len == dot + 1) {
+				len = dot;
+			}
+		}
+	}
+	if (exp_notation) {
+		buf[len++] = 'e';
+		buf[len++] = (exp10 < 0) ? '-' : '+';
+		unsigned e = (exp10 < 0) ? (unsigned)-exp10 : (unsigned)exp10;
+		if (e < 10) {
+			buf[len++] = '0';
+		}
+		p = utoa(end, e, 10, 0);
+		while (p < end) {
+			buf[len++] = *p++;
+		}
+	}
+	return len;
+}
+
+static void put_double(out_t* out, double v, char conv, int precision, int width, int left, int zero) {
+	const char* sign = "";
+	if (v < 0.0) {
+		sign = "-";
+		v = -v;
+	}
+	char buf[64];
+	int len;
+	if (v != v) {
+		sign = "";
+		len = 3;
+		buf[0] = 'n'; buf[1] = 'a'; buf[2] = 'n';
+	}
+	else if (v > 1.7976931348623157e308) {
+		len = 3;
+		buf[0] = 'i'; buf[1] = 'n'; buf[2] = 'f';
+	}
+	else {
+		if (precision < 0) {
+			precision = 6;
+		}
+		int exp_notation = (conv == 'e');
+		int trim = 0;
+		if (conv == 'g') {
+			// exponent notation for very large or small values, like printf
+			if (precision == 0) {
+				precision = 1;
+			}
+			int exp10 = 0;
+			if (v != 0.0) {
+				double m = v;
+				for (; m >= 10.0; m /= 10.0) {
+					exp10++;
+				}
+				for (; m < 1.0; m *= 10.0) {
+					exp10--;
+				}
+			}
+			exp_notation = (exp10 < -4) || (exp10 >= precision);
+			precision = exp_notation ? precision - 1 : precision - 1 - exp10;
+			trim = 1;
+		}
+		else if (!exp_notation && (v >= 1e19)) {
+			exp_notation = 1; // does not fit the integer part, switch notation
+		}
+		len = ftoa(buf, v, precision, exp_notation, trim);
+	}
+	int sign_len = *sign ? 1 : 0;
+	int zeros = (zero && !left && (width > len + sign_len)) ? width - len - sign_len : 0;
+	put_field(out, sign, sign_len, zeros, buf, len, width, left);
+}
+
+#endif // EA_NO_DOUBLE
+
+static void vformat(out_t* out, const char* fmt, va_list args) {
+	for (const char* p = fmt; *p; ++p) {
+		if (*p != '%') {
+			const char* start = p;
+			while (p[1] && (p[1] != '%')) {
+				p++;
+			}
+			put(out, start, (int)(p - start + 1));
+			continue;
+		}
+		const char* spec = p++;
+
+		// flags, width, precision
+		int left = 0, zero = 0;
+		for (; (*p == '-') || (*p == '0') || (*p == '+') || (*p == ' ') || (*p == '#'); ++p) {
+			left |= (*p == '-');
+			zero |= (*p == '0');
+		}
+		int width = 0;
+		if (*p == '*') {
+			width = va_arg(args, int);
+			if (width < 0) {
+				left = 1;
+				width = -width;
+			}
+			p++;
+		}
+		for (; (*p >= '0') && (*p <= '9'); ++p) {
+			width = width * 10 + (*p - '0');
+		}
+		int precision = -1;
+		if (*p == '.') {
+			p++;
+			precision = 0;
+			if (*p == '*') {
+				precision = va_arg(args, int);
+				p++;
+			}
+			for (; (*p >= '0') && (*p <= '9'); ++p) {
+				precision = precision * 10 + (*p - '0');
+			}
+		}
+
+		// length, size_t may be narrower than long long (e.g. on 32-bit MCUs)
+		int longs = 0;
+		int size = 0;
+		for (; (*p == 'l') || (*p == 'h') || (*p == 'z'); ++p) {
+			longs += (*p == 'l');
+			size |= (*p == 'z');
+		}
+
+		char tmp[24];
+		char* end = tmp + sizeof(tmp);
+		switch (*p) {
+		case 'd':
+		case 'i': {
+			long long v = size ? (long long)(ptrdiff_t)va_arg(args, size_t) : (longs >= 2) ? va_arg(args, long long) : (longs == 1) ? va_arg(args, long) : va_arg(args, int);
+			unsigned long long u = (v < 0) ? 0ull - (unsigned long long)v : (unsigned long long)v;
+			char* s = utoa(end, u, 10, 0);
+			int n = (int)(end - s);
+			int zeros = (precision > n) ? precision - n : 0;
+			if (zero && !left && (precision < 0) && (width > n + (v < 0))) {
+				zeros = width - n - (v < 0);
+			}
+			put_field(out, "-", v < 0, zeros, s, n, width, left);
+			break;
+		}
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'p': {
+			unsigned long long v;
+			if (*p == 'p') {
+				v = (unsigned long long)(size_t)va_arg(args, void*);
+			}
+			else if (size) {
+				v = (unsigned long long)va_arg(args, size_t);
+			}
+			else {
+				v = (longs >= 2) ? va_arg(args, unsigned long long) : (longs == 1) ? va_arg(args, unsigned long) : va_arg(args, unsigned);
+			}
+			char* s = utoa(end, v, (*p == 'u') ? 10 : 16, *p == 'X');
+			int n = (int)(end - s);
+			int zeros = (precision > n) ? precision - n : 0;
+			int prefix_len = (*p == 'p') ? 2 : 0;
+			if (zero && !left && (precision < 0) && (width > n + prefix_len)) {
+				zeros = width - n - prefix_len;
+			}
+			put_field(out, "0x", prefix_len, zeros, s, n, width, left);
+			break;
+		}
+		case 'c': {
+			char c = (char)va_arg(args, int);
+			put_field(out, "", 0, 0, &c, 1, width, left);
+			break;
+		}
+		case 's': {
+			const char* s = va_arg(args, const char*);
+			if (!s) {
+				s = "(null)";
+			}
+			int n = 0;
+			while (((precision < 0) || (n < precision)) && s[n]) {
+				n++;
+			}
+			put_field(out, "", 0, 0, s, n, width, left);
+			break;
+		}
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G': {
+			double v = va_arg(args, double);
+#ifndef EA_NO_DOUBLE
+			char conv = (*p == 'F') ? 'f' : (*p == 'E') ? 'e' : (*p == 'G') ? 'g' : *p;
+			put_double(out, v, conv, precision, width, left, zero);
+#else
+			(void)v;
+			put(out, "?", 1);
+#endif
+			break;
+		}
+		case '%':
+			put(out, "%", 1);
+			break;
+		default:
+			// unknown conversion, print it as is
+			if (!*p) {
+				p--;
+			}
+			put(out, spec, (int)(p - spec + 1));
+			break;
+		}
+	}
+}
+
+void ea__vprintf(const char* fmt, va_list args) {
+	if (!output_func) {
+#ifndef EA_FREESTANDING
+		vprintf(fmt, args);
+#endif
+		return;
+	}
+	out_t out;
+	out.len = 0;
+	out.str = NULL;
+	vformat(&out, fmt, args);
+	flush(&out);
+}
+
+int ea__vformat_append(char* buf, int cap, int len, const char* fmt, va_list args) {
+	out_t out;
+	out.len = 0;
+	out.str = buf;
+	out.str_len = len;
+	out.str_cap = cap;
+	vformat(&out, fmt, args);
+	flush(&out);
+	return out.str_len;
+}
+
+void ea__printf(const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	ea__vprintf(fmt, args);
+	va_end(args);
+}
+
+void ea__write(const char* data, int len) {
+	if (len <= 0) {
+		return; // data may be NULL then, e.g. a silent async test
+	}
+	if (!output_func) {
+#ifndef EA_FREESTANDING
+		fwrite(data, 1, (size_t)len, stdout);
+#endif
+		return;
+	}
+	output_func(data, len, output_opaque);
+}
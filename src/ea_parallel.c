@@ -0,0 +1,671 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ea_internal.h"
+
+#ifdef EA_HAVE_POSIX
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+int ea__cpu_count(void) {
+#if defined(EA_HAVE_POSIX) && defined(_SC_NPROCESSORS_ONLN)
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? (int)n : 1;
+#else
+	return 1;
+#endif
+}
+
+#ifndef EA_HAVE_POSIX
+
+int ea__run_parallel(ea__run_t* run, int jobs) {
+	(void)run;
+	(void)jobs;
+	ea__printf("Worker processes are not supported on this platform, running in-process.\n");
+	return 0;
+}
+
+#else
+
+#ifndef PARALLEL_MAX_JOBS
+#define PARALLEL_MAX_JOBS 256
+#endif
+
+#ifndef PARALLEL_OUTPUT_BUF
+#define PARALLEL_OUTPUT_BUF 65536
+#endif
+
+/*
+ * The coordinator forks K workers after the tests are selected, so workers
+ * share the tree (pointers are valid in every worker). Each worker gets a Unix
+ * domain socket: the coordinator sends units of work, the worker's stdout is
+ * redirected to the socket and every finished test is followed by a marker
+ * line, so the coordinator can print the output of each test in one piece and
+ * knows which test was running when a worker crashes.
+ */
+#define MARKER '\x1e'
+#define DETAILS_NEWLINE '\x1f' // stands for a newline in the failure details of a marker
+
+typedef struct {
+	ea_group_t* group; // NULL: exit
+	ea_test_t* first; // first selected test of the unit
+	int count; // number of selected tests, 0 if already handed out
+
+	// scheduling
+	int order; // position in run order
+	unsigned long long cost; // predicted duration
+	const void* key; // first fixture needed, else the outermost group with a setup below the
+	                 // top of the run; units sharing one prefer the same worker
+} unit_t;
+
+typedef struct {
+	pid_t pid; // 0 if the slot is free
+	int sock;
+	int busy; // running a unit
+	int exiting; // exit command was sent
+	unit_t unit;
+	const void* key; // key of the last unit
+	ea_test_t* current; // test of the unit running now
+	int done; // tests of the unit finished
+	int flushed; // output of the current test was already printed
+	int len;
+	char buf[PARALLEL_OUTPUT_BUF];
+} worker_t;
+
+typedef struct {
+	ea__run_t* run;
+	unit_t* units; // queue, requeued units are put in front of head
+	int head, tail;
+	int selected; // number of selected tests
+	worker_t* workers;
+	int worker_count;
+} coordinator_t;
+
+// units
+
+static ea_test_t* next_selected(ea_test_t* test) {
+	while (test && (test->selected != ea__selected_yes)) {
+		test = test->next;
+	}
+	return test;
+}
+
+// tests of groups with setup/teardown or fixtures are kept together, so they
+// are set up once per unit instead of once per test
+static int needs_group_unit(const ea__run_t* run, const ea_group_t* group) {
+	int in_run = 1;
+	for (const ea_group_t* g = group; g; g = g->parent) {
+		if (in_run && (g->setup || g->teardown)) {
+			return 1;
+		}
+		if (g->fixtures) {
+			return 1;
+		}
+		if (g == run->group) {
+			in_run = 0;
+		}
+	}
+	for (const ea_test_t* test = group->tests_head; test; test = test->next) {
+		if ((test->selected == ea__selected_yes) && test->fixtures) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// units below the same group with a setup go to the same worker, which keeps
+// that group set up between them
+static const void* unit_key(const ea__run_t* run, const ea_test_t* test) {
+	const void* key = ea__fixtures_key(test);
+	if (key) {
+		return key;
+	}
+	for (const ea_group_t* g = test->parent; g != run->group; g = g->parent) {
+		if (g->setup || g->teardown) {
+			key = g;
+		}
+	}
+	return key;
+}
+
+// collect units in run order, count only if units is NULL
+static int collect_units(const ea__run_t* run, ea_group_t* group, unit_t* units, int count) {
+	ea_test_t* first = next_selected(group->tests_head);
+	if (first) {
+		int whole = needs_group_unit(run, group);
+		for (ea_test_t* test = first; test; test = next_selected(test->next)) {
+			if (units) {
+				if (whole && (test != first)) {
+					units[count - 1].count++;
+					continue;
+				}
+				units[count].group = group;
+				units[count].first = test;
+				units[count].count = 1;
+				units[count].order = count;
+				units[count].cost = 0;
+				units[count].key = unit_key(run, test);
+			}
+			else if (whole && (test != first)) {
+				continue;
+			}
+			count++;
+		}
+	}
+	for (ea_group_t* child = group->children_head; child; child = child->next_sibling) {
+		count = collect_units(run, child, units, count);
+	}
+	return count;
+}
+
+// worker
+
+/*
+ * As in a serial run, a group stays set up while the units below it run:
+ * *set_up is the innermost group whose setups (and those of its ancestors up
+ * to the top of the run) ran. Moving to a unit elsewhere tears down the
+ * groups that are not its ancestors, then sets up the missing ones.
+ */
+static int is_ancestor(const ea_group_t* ancestor, const ea_group_t* group) {
+	while (group && (group != ancestor)) {
+		group = group->parent;
+	}
+	return group != NULL;
+}
+
+// tear down the set up groups that are not ancestors of group (all if NULL)
+static void leave_groups(const ea__run_t* run, ea_group_t** set_up, const ea_group_t* group) {
+	while (*set_up && !(group && is_ancestor(*set_up, group))) {
+		if ((*set_up)->teardown) {
+			(*set_up)->teardown((*set_up)->teardown_opaque);
+		}
+		*set_up = (*set_up == run->group) ? NULL : (*set_up)->parent;
+	}
+}
+
+static void run_setups(const ea_group_t* top, const ea_group_t* set_up, ea_group_t* group) {
+	if (group == set_up) {
+		return;
+	}
+	if (group != top) {
+		run_setups(top, set_up, group->parent);
+	}
+	if (group->setup) {
+		group->setup(group->setup_opaque);
+	}
+}
+
+static void run_unit(ea__run_t* run, const unit_t* unit, ea_group_t** set_up, int in_worker) {
+	leave_groups(run, set_up, unit->group);
+	run_setups(run->group, *set_up, unit->group);
+	*set_up = unit->group;
+	int namepos = ea__group_name(run->group, unit->group, run->namebuf);
+	ea_test_t* test = unit->first;
+	for (int done = 0; done < unit->count; ++done) {
+		test = next_selected(test);
+		int namelen = ea__append_name(run->namebuf, namepos, test->name);
+		int failed = ea__run_test(run, test, namelen);
+		if (in_worker) {
+			// the status of the recorded result tells crashed isolated tests apart
+			const ea_test_result_t* result = (run->results && run->results->count) ? &run->results->tests[run->results->count - 1] : NULL;
+			printf("%cT%d %llu", MARKER, result ? (int)result->status : failed, run->test_ns);
+			if (result) {
+				// details of the recorded result, the file is a pointer into the shared image
+				printf(" %d %d %d %llx ", result->assertion_count, result->stack_bytes, result->failure_line,
+					(unsigned long long)(size_t)result->failure_file);
+				for (const char* p = result->failure_message; *p; ++p) {
+					putchar((*p == '\n') ? DETAILS_NEWLINE : *p);
+				}
+			}
+			printf("\n");
+
+			// failure sites of the test, merged by the coordinator
+			ea__site_change_t change;
+			while (run->sites && ea__sites_changed(run->sites, &change)) {
+				printf("%cS%llx %d %d %d %llx %llx\n", MARKER, (unsigned long long)(size_t)change.file, change.line,
+					change.count, change.value_kind, change.min, change.max);
+			}
+			fflush(stdout);
+		}
+		test = test->next;
+	}
+	if (in_worker) {
+		printf("%cU\n", MARKER);
+		fflush(stdout);
+	}
+}
+
+static int read_full(int fd, void* data, int size) {
+	char* p = (char*)data;
+	while (size > 0) {
+		ssize_t n = read(fd, p, (size_t)size);
+		if (n <= 0) {
+			return 0;
+		}
+		p += n;
+		size -= (int)n;
+	}
+	return 1;
+}
+
+static int write_full(int fd, const void* data, int size) {
+	const char* p = (const char*)data;
+	while (size > 0) {
+		ssize_t n = write(fd, p, (size_t)size);
+		if (n <= 0) {
+			return 0;
+		}
+		p += n;
+		size -= (int)n;
+	}
+	return 1;
+}
+
+static void worker_main(ea__run_t* run, int sock) {
+	dup2(sock, STDOUT_FILENO);
+	ea_set_output(NULL, NULL); // the coordinator forwards the output
+	run->changes = NULL; // results are recorded by the coordinator
+	run->durations = NULL;
+	run->journal = NULL;
+	unit_t unit;
+	const void* key = NULL;
+	ea_group_t* set_up = NULL;
+	while (read_full(sock, &unit, sizeof(unit)) && unit.group) {
+		// fixtures stay built while the worker gets units needing them, they
+		// are torn down when it moves on to other work
+		if (unit.key != key) {
+			ea__fixtures_finish(run->group);
+			key = unit.key;
+		}
+		run_unit(run, &unit, &set_up, 1);
+	}
+	leave_groups(run, &set_up, NULL);
+	ea__fixtures_finish(run->group);
+	fflush(stdout);
+	_exit(0);
+}
+
+// coordinator
+
+static int spawn(coordinator_t* c, worker_t* w) {
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+		return 0;
+	}
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return 0;
+	}
+	if (pid == 0) {
+		close(fds[0]);
+		for (int i = 0; i < c->worker_count; ++i) {
+			if (c->workers[i].pid) {
+				close(c->workers[i].sock);
+			}
+		}
+		worker_main(c->run, fds[1]);
+	}
+	close(fds[1]);
+	w->pid = pid;
+	w->sock = fds[0];
+	w->busy = 0;
+	w->exiting = 0;
+	w->len = 0;
+	w->flushed = 0;
+	return 1;
+}
+
+// next unit for the worker: the first queued one needing the same fixtures
+// as its last unit, the first queued one otherwise
+static int take_unit(coordinator_t* c, const void* key, unit_t* unit) {
+	while ((c->head < c->tail) && !c->units[c->head].count) {
+		c->head++;
+	}
+	if (c->head == c->tail) {
+		return 0;
+	}
+	int index = c->head;
+	if (key) {
+		for (int i = c->head; i < c->tail; ++i) {
+			if (c->units[i].count && (c->units[i].key == key)) {
+				index = i;
+				break;
+			}
+		}
+	}
+	*unit = c->units[index];
+	c->units[index].count = 0;
+	return 1;
+}
+
+static void dispatch(coordinator_t* c, worker_t* w) {
+	unit_t unit = { 0 };
+	if (take_unit(c, w->key, &unit)) {
+		w->busy = 1;
+		w->unit = unit;
+		w->key = unit.key;
+		w->current = next_selected(unit.first);
+		w->done = 0;
+	}
+	else {
+		w->exiting = 1;
+	}
+	write_full(w->sock, &unit, sizeof(unit));
+}
+
+// details: rest of the marker line of a worker recording results, NULL if none
+static void record_result(coordinator_t* c, worker_t* w, ea_test_status_t status, unsigned long long ns, char* details, char* eol) {
+	ea__run_t* run = c->run;
+	ea_test_t* test = w->current;
+	int failed = (status != EA_TEST_PASSED);
+	run->info.total_count++;
+	if (failed) {
+		run->info.failed_count++;
+	}
+	if (run->changes || run->durations || run->journal || run->results) {
+		int namepos = ea__group_name(run->group, w->unit.group, run->namebuf);
+		int namelen = ea__append_name(run->namebuf, namepos, test->name);
+		if (run->changes) {
+			ea__changes_result(run->changes, run->namebuf, namelen, failed);
+		}
+		if (run->durations && ns) {
+			ea__durations_record(run->durations, run->namebuf, namelen, ns);
+		}
+		if (run->journal) {
+			ea__journal_finish(run->journal, run->namebuf, namelen, status, ns, details ? (int)strtol(details, NULL, 10) : 0);
+		}
+		if (run->results) {
+			ea__test_info_t test_info = { 0 };
+			char failure_message[EA_RESULT_MESSAGE_LEN];
+			failure_message[0] = '\0';
+			run->test_ns = ns;
+			if (details) {
+				char* p = details;
+				test_info.assertion_count = (int)strtol(p, &p, 10);
+				run->stack_used = (int)strtol(p, &p, 10);
+				test_info.failure_line = (int)strtol(p, &p, 10);
+				test_info.failure_file = (const char*)(size_t)strtoull(p, &p, 16);
+				int len = 0;
+				for (p += (p < eol); (p < eol) && (len < EA_RESULT_MESSAGE_LEN - 1); ++p) {
+					failure_message[len++] = (*p == DETAILS_NEWLINE) ? '\n' : *p;
+				}
+				failure_message[len] = '\0';
+				test_info.failure_message = failure_message;
+			}
+			ea__record_result(run, test, namelen, status, details ? &test_info : NULL);
+			run->stack_used = 0;
+		}
+	}
+	w->current = next_selected(test->next);
+	w->done++;
+}
+
+// print the output of finished tests, keep the output of the running one
+static void process_output(coordinator_t* c, worker_t* w) {
+	char* start = w->buf;
+	char* end = w->buf + w->len;
+	while (1) {
+		char* marker = (char*)memchr(start, MARKER, end - start);
+		char* eol = marker ? (char*)memchr(marker, '\n', end - marker) : NULL;
+		if (!eol) {
+			break;
+		}
+		ea__write(start, (int)(marker - start));
+		if (marker[1] == 'T') {
+			char* details;
+			unsigned long long ns = strtoull(marker + 3, &details, 10);
+			record_result(c, w, (ea_test_status_t)(marker[2] - '0'), ns, (*details == ' ') ? details : NULL, eol);
+		}
+		else if ((marker[1] == 'S') && c->run->sites) {
+			ea__site_change_t change;
+			char* p = marker + 2;
+			change.file = (const char*)(size_t)strtoull(p, &p, 16);
+			change.line = (int)strtol(p, &p, 10);
+			change.count = (int)strtol(p, &p, 10);
+			change.value_kind = (int)strtol(p, &p, 10);
+			change.min = strtoull(p, &p, 16);
+			change.max = strtoull(p, &p, 16);
+			ea__sites_merge(c->run->sites, &change);
+		}
+		else if (marker[1] == 'U') {
+			w->busy = 0;
+		}
+		w->flushed = 0;
+		start = eol + 1;
+	}
+	w->len = (int)(end - start);
+	memmove(w->buf, start, w->len);
+	if (w->len == PARALLEL_OUTPUT_BUF) {
+		// chatty test, print what we have
+		char* marker = (char*)memchr(w->buf, MARKER, w->len);
+		int keep = marker ? (int)(w->buf + w->len - marker) : 0;
+		ea__write(w->buf, w->len - keep);
+		memmove(w->buf, w->buf + w->len - keep, keep);
+		w->len = keep;
+		w->flushed = 1;
+	}
+	fflush(stdout);
+}
+
+static void print_crash(int status) {
+	if (WIFSIGNALED(status)) {
+		ea__printf("CRASHED (signal %d)\n", WTERMSIG(status));
+	}
+	else {
+		ea__printf("CRASHED (exit code %d)\n", WEXITSTATUS(status));
+	}
+}
+
+static void handle_exit(coordinator_t* c, worker_t* w) {
+	ea__run_t* run = c->run;
+	int status = 0;
+	waitpid(w->pid, &status, 0);
+	close(w->sock);
+	w->pid = 0;
+	if (w->exiting && WIFEXITED(status) && (WEXITSTATUS(status) == 0)) {
+		return;
+	}
+
+	// the worker crashed, report the running test as failed
+	if (w->busy && w->current) {
+		ea_test_t* test = w->current;
+		if (!w->len && !w->flushed) {
+			int namepos = ea__group_name(run->group, w->unit.group, run->namebuf);
+			int namelen = ea__append_name(run->namebuf, namepos, test->name);
+			ea__print_test_name(run->namebuf, namelen);
+		}
+		else {
+			ea__write(w->buf, w->len);
+		}
+		print_crash(status);
+		record_result(c, w, EA_TEST_CRASHED, 0, NULL, NULL);
+
+		// requeue the rest of the unit
+		if (w->done < w->unit.count) {
+			unit_t rest = w->unit;
+			rest.first = w->current;
+			rest.count = w->unit.count - w->done;
+			c->units[--c->head] = rest;
+		}
+	}
+	else if (w->unit.group) {
+		// it crashed after the tests of its last unit, while tearing down
+		// their groups and fixtures (or building those of a next unit),
+		// which fails the run like a crashed teardown in-process
+		ea__write(w->buf, w->len);
+		int namepos = ea__group_name(run->group, w->unit.group, run->namebuf);
+		const char* teardown = " (teardown)";
+		for (int i = 0; teardown[i] && (namepos < TESTNAME_BUF_LEN); ++i) {
+			run->namebuf[namepos++] = teardown[i];
+		}
+		ea__print_test_name(run->namebuf, namepos);
+		print_crash(status);
+		run->info.failed_count++;
+	}
+
+	// replace the worker if there is work left
+	w->busy = 0;
+	w->key = NULL;
+	if ((c->head < c->tail) && spawn(c, w)) {
+		dispatch(c, w);
+	}
+}
+
+static int compare_units(const void* a, const void* b) {
+	const unit_t* ua = (const unit_t*)a;
+	const unit_t* ub = (const unit_t*)b;
+	if (ua->cost != ub->cost) {
+		return (ua->cost > ub->cost) ? -1 : 1;
+	}
+	return ua->order - ub->order;
+}
+
+// order units longest first by their duration history
+// returns the predicted makespan (greedy assignment to the least loaded worker),
+// counts the tests without a history in run->makespan_unknown
+static unsigned long long schedule(coordinator_t* c, int jobs) {
+	ea__run_t* run = c->run;
+	unit_t* units = c->units + c->head;
+	int count = c->tail - c->head;
+	for (int i = 0; i < count; ++i) {
+		int namepos = ea__group_name(run->group, units[i].group, run->namebuf);
+		ea_test_t* test = units[i].first;
+		for (int done = 0; done < units[i].count; ++done) {
+			test = next_selected(test);
+			int namelen = ea__append_name(run->namebuf, namepos, test->name);
+			int known;
+			units[i].cost += ea__durations_predict(run->durations, run->namebuf, namelen, &known);
+			run->makespan_unknown += !known;
+			run->makespan_tests++;
+			test = test->next;
+		}
+	}
+	qsort(units, count, sizeof(unit_t), compare_units);
+
+	unsigned long long load[PARALLEL_MAX_JOBS] = { 0 };
+	unsigned long long makespan = 0;
+	for (int i = 0; i < count; ++i) {
+		int least = 0;
+		for (int j = 1; j < jobs; ++j) {
+			if (load[j] < load[least]) {
+				least = j;
+			}
+		}
+		load[least] += units[i].cost;
+		if (load[least] > makespan) {
+			makespan = load[least];
+		}
+	}
+	return makespan;
+}
+
+int ea__run_parallel(ea__run_t* run, int jobs) {
+	ea_group_t* root = ea__get_root(run->group);
+	coordinator_t c = { 0 };
+	c.run = run;
+	int count = collect_units(run, run->group, NULL, 0);
+	if (count == 0) {
+		return 1;
+	}
+	if (jobs > count) {
+		jobs = count;
+	}
+	if (jobs > PARALLEL_MAX_JOBS) {
+		jobs = PARALLEL_MAX_JOBS;
+	}
+
+	// allocate the queue, with room in front for the rest of units whose
+	// worker crashed (at most one per selected test)
+	unit_t* units = (unit_t*)root->mem_alloc(NULL, (int)sizeof(unit_t) * count, root->mem_alloc_opaque);
+	collect_units(run, run->group, units, 0);
+	for (int i = 0; i < count; ++i) {
+		c.selected += units[i].count;
+	}
+	c.units = (unit_t*)root->mem_alloc(NULL, (int)sizeof(unit_t) * (c.selected + count), root->mem_alloc_opaque);
+	c.head = c.selected;
+	c.tail = c.head + count;
+	if (count > 0) {
+		memcpy(c.units + c.head, units, sizeof(unit_t) * (size_t)count);
+	}
+	root->mem_alloc(units, 0, root->mem_alloc_opaque);
+	if (run->durations) {
+		run->makespan_predicted_ns = schedule(&c, jobs);
+	}
+
+	c.workers = (worker_t*)root->mem_alloc(NULL, (int)sizeof(worker_t) * jobs, root->mem_alloc_opaque);
+	memset(c.workers, 0, sizeof(worker_t) * jobs);
+	c.worker_count = jobs;
+
+	ea__printf("Running %d unit(s) on %d worker process(es)\n", count, jobs);
+	void (*old_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+	unsigned long long start_ns = ea__now_ns();
+
+	// start workers and hand out the first units
+	for (int i = 0; i < jobs; ++i) {
+		if (spawn(&c, &c.workers[i])) {
+			dispatch(&c, &c.workers[i]);
+		}
+	}
+
+	// serve workers until all exited
+	struct pollfd fds[PARALLEL_MAX_JOBS];
+	int map[PARALLEL_MAX_JOBS];
+	while (1) {
+		int nfds = 0;
+		for (int i = 0; i < c.worker_count; ++i) {
+			if (c.workers[i].pid) {
+				fds[nfds].fd = c.workers[i].sock;
+				fds[nfds].events = POLLIN;
+				fds[nfds].revents = 0;
+				map[nfds++] = i;
+			}
+		}
+		if (nfds == 0) {
+			break;
+		}
+		if (poll(fds, nfds, -1) < 0) {
+			continue;
+		}
+		for (int i = 0; i < nfds; ++i) {
+			if (!fds[i].revents) {
+				continue;
+			}
+			worker_t* w = &c.workers[map[i]];
+			ssize_t n = read(w->sock, w->buf + w->len, PARALLEL_OUTPUT_BUF - w->len);
+			if (n > 0) {
+				w->len += (int)n;
+				process_output(&c, w);
+				if (!w->busy && !w->exiting) {
+					dispatch(&c, w);
+				}
+			}
+			else {
+				handle_exit(&c, w);
+			}
+		}
+	}
+
+	// run what is left in-process if workers could not be started
+	unit_t unit;
+	ea_group_t* set_up = NULL;
+	while (take_unit(&c, NULL, &unit)) {
+		run_unit(run, &unit, &set_up, 0);
+	}
+	leave_groups(run, &set_up, NULL);
+	run->makespan_ns = ea__now_ns() - start_ns;
+
+	signal(SIGPIPE, old_sigpipe);
+	root->mem_alloc(c.workers, 0, root->mem_alloc_opaque);
+	root->mem_alloc(c.units, 0, root->mem_alloc_opaque);
+	return 1;
+}
+
+#endif // EA_HAVE_POSIX
@@ -0,0 +1,147 @@
+#include <string.h>
+
+#ifdef EA_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "ea_internal.h"
+
+/*
+ * A serial run builds the setup of the next group that declared it
+ * prewarmable on a thread while the tests of the current group run. The next
+ * group is the next one with a setup in run order; the setups of its
+ * ancestors have run by then, as its parent is the current group or one of
+ * its ancestors. The group's run waits for the thread instead of calling the
+ * setup. One setup is prewarmed at a time. Only setups that tests ran next to
+ * are counted in the summary (not e.g. those of groups whose tests were all
+ * filtered out). Without threads the setups run as usual.
+ *
+ * The selection visits the groups in run order and links each one to the
+ * next group with a setup (if that one is prewarmable), so starting a group
+ * costs nothing when no setup is prewarmed.
+ */
+
+struct ea_prewarm_s {
+	ea_group_t* root; // for mem_alloc
+	const ea__run_t* run; // for its test count
+	ea_group_t* group; // group whose setup is running, NULL if none
+#ifdef EA_HAVE_PTHREADS
+	pthread_t thread;
+#endif
+	unsigned long long setup_ns; // duration of the running setup, set by the thread
+	int tests_before; // tests run when the setup started
+	int count; // setups prewarmed while tests ran
+	unsigned long long overlapped_ns; // setup time hidden behind tests
+};
+
+void ea__prewarm_select(ea__run_t* run, ea_group_t* group) {
+	if (group->setup) {
+		ea_group_t* next = group->prewarmable ? group : NULL;
+		for (ea_group_t* waiting = run->prewarm_waiting; waiting; ) {
+			ea_group_t* chained = waiting->prewarm_next;
+			waiting->prewarm_next = next;
+			waiting = chained;
+		}
+		run->prewarm_waiting = NULL;
+		// the setup of the first group has nothing to overlap with
+		if (next && (group != run->group)) {
+			run->prewarm_wanted = 1;
+		}
+	}
+	group->prewarm_next = run->prewarm_waiting;
+	run->prewarm_waiting = group;
+}
+
+void ea__prewarm_select_end(ea__run_t* run) {
+	for (ea_group_t* waiting = run->prewarm_waiting; waiting; ) {
+		ea_group_t* chained = waiting->prewarm_next;
+		waiting->prewarm_next = NULL;
+		waiting = chained;
+	}
+	run->prewarm_waiting = NULL;
+}
+
+#ifndef EA_HAVE_PTHREADS
+
+ea_prewarm_t* ea__prewarm_create(ea_group_t* root, const ea__run_t* run) {
+	(void)root;
+	(void)run;
+	return NULL;
+}
+
+void ea__prewarm_next(ea_prewarm_t* prewarm, ea_group_t* group) {
+	(void)prewarm;
+	(void)group;
+}
+
+int ea__prewarm_wait(ea_prewarm_t* prewarm, ea_group_t* group) {
+	(void)prewarm;
+	(void)group;
+	return 0;
+}
+
+void ea__prewarm_finish(ea_prewarm_t* prewarm) {
+	(void)prewarm;
+}
+
+#else
+
+ea_prewarm_t* ea__prewarm_create(ea_group_t* root, const ea__run_t* run) {
+	if (!run->prewarm_wanted) {
+		return NULL;
+	}
+	ea_prewarm_t* prewarm = (ea_prewarm_t*)root->mem_alloc(NULL, sizeof(ea_prewarm_t), root->mem_alloc_opaque);
+	memset(prewarm, 0, sizeof(ea_prewarm_t));
+	prewarm->root = root;
+	prewarm->run = run;
+	return prewarm;
+}
+
+static void* run_setup(void* opaque) {
+	ea_prewarm_t* prewarm = (ea_prewarm_t*)opaque;
+	unsigned long long start_ns = ea__now_ns();
+	prewarm->group->setup(prewarm->group->setup_opaque);
+	prewarm->setup_ns = ea__now_ns() - start_ns;
+	return NULL;
+}
+
+void ea__prewarm_next(ea_prewarm_t* prewarm, ea_group_t* group) {
+	ea_group_t* next = group->prewarm_next;
+	if (prewarm->group || !next) {
+		return;
+	}
+	prewarm->group = next;
+	prewarm->setup_ns = 0;
+	prewarm->tests_before = prewarm->run->info.total_count;
+	if (pthread_create(&prewarm->thread, NULL, run_setup, prewarm) != 0) {
+		prewarm->group = NULL; // the setup runs when the group starts
+	}
+}
+
+int ea__prewarm_wait(ea_prewarm_t* prewarm, ea_group_t* group) {
+	if (prewarm->group != group) {
+		return 0;
+	}
+	unsigned long long start_ns = ea__now_ns();
+	pthread_join(prewarm->thread, NULL);
+	unsigned long long waited_ns = ea__now_ns() - start_ns;
+	if ((prewarm->run->info.total_count > prewarm->tests_before) && (prewarm->setup_ns > waited_ns)) {
+		prewarm->overlapped_ns += prewarm->setup_ns - waited_ns;
+		prewarm->count++;
+	}
+	prewarm->group = NULL;
+	return 1;
+}
+
+void ea__prewarm_finish(ea_prewarm_t* prewarm) {
+	if (prewarm->group) {
+		pthread_join(prewarm->thread, NULL); // the run reaches every group, only after an early stop
+	}
+	if (prewarm->count) {
+		unsigned long long tenths = prewarm->overlapped_ns / 100000;
+		ea__printf("Prewarmed %d group setup(s), %llu.%llu ms overlapped with tests.\n", prewarm->count, tenths / 10, tenths % 10);
+	}
+	prewarm->root->mem_alloc(prewarm, 0, prewarm->root->mem_alloc_opaque);
+}
+
+#endif // EA_HAVE_PTHREADS
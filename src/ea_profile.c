@@ -0,0 +1,485 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // dladdr()
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ea_internal.h"
+
+#if defined(__GLIBC__) && defined(EA_HAVE_POSIX)
+#define PROFILE_SUPPORTED 1
+#endif
+
+#ifdef PROFILE_SUPPORTED
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <elf.h>
+#include <link.h>
+#define PROFILE_HAVE_ELF 1
+#endif
+#endif
+
+/*
+ * While a test runs, an ITIMER_PROF timer sends SIGPROF every 1/hz second of
+ * CPU time and the handler stores a backtrace in a preallocated pool. The
+ * frames of the runner (below the test function) are cut off by depth: they
+ * are the frames seen when the sampler is started. After the test the stacks
+ * are symbolized (the executable's symbol table, then dladdr()), folded into
+ * "test;outer;...;inner count" lines for flamegraph tools and the innermost
+ * frames are counted for the self-time summary. The timer is limited by the
+ * kernel's tick, so the CPU time of the test is measured separately and the
+ * delivered sample rate is reported.
+ */
+
+#ifndef PROFILE_DEFAULT_HZ
+#define PROFILE_DEFAULT_HZ 1000
+#endif
+
+#ifndef PROFILE_MAX_DEPTH
+#define PROFILE_MAX_DEPTH 64
+#endif
+
+// frames stored per test, samples beyond are dropped (and counted)
+#ifndef PROFILE_POOL_FRAMES
+#define PROFILE_POOL_FRAMES (256 * 1024)
+#endif
+
+#ifndef PROFILE_MAX_SAMPLES
+#define PROFILE_MAX_SAMPLES (32 * 1024)
+#endif
+
+// symbols listed next to the result
+#ifndef PROFILE_TOP_SYMBOLS
+#define PROFILE_TOP_SYMBOLS 5
+#endif
+
+#ifndef PROFILE_PATH_MAX
+#define PROFILE_PATH_MAX 1024
+#endif
+
+// frames of the signal handler and the signal trampoline
+#define PROFILE_HANDLER_FRAMES 2
+
+#ifndef PROFILE_SUPPORTED
+
+ea_profile_t* ea__profile_create(ea_group_t* root, const char* dir, int hz) {
+	(void)root;
+	(void)dir;
+	(void)hz;
+	ea__printf("Profiling is not supported on this platform.\n");
+	return NULL;
+}
+
+void ea__profile_start(ea_profile_t* profile) {
+	(void)profile;
+}
+
+void ea__profile_stop(ea_profile_t* profile) {
+	(void)profile;
+}
+
+void ea__profile_report(ea_profile_t* profile, const char* name, int name_len) {
+	(void)profile;
+	(void)name;
+	(void)name_len;
+}
+
+void ea__profile_finish(ea_profile_t* profile) {
+	(void)profile;
+}
+
+#else
+
+typedef struct {
+	int first; // index into the frame pool
+	int depth;
+} sample_t;
+
+typedef struct {
+	unsigned long long value; // link-time address
+	unsigned long long size;
+	const char* name; // into strtab
+} symbol_t;
+
+struct ea_profile_s {
+	ea_group_t* root; // for mem_alloc
+	const char* dir;
+	int hz;
+	int outer_frames; // frames of the runner, cut off the samples
+	unsigned long long cpu_start_ns, cpu_ns; // CPU time of the process while the test ran
+
+	// filled by the signal handler
+	void** frames;
+	sample_t* samples;
+	volatile int frame_count, sample_count, dropped;
+
+	// symbol table of the executable, NULL if not available
+	symbol_t* symbols;
+	int symbol_count;
+	char* strtab;
+	unsigned long long exe_bias; // load address of a position independent executable, 0 otherwise
+
+	struct sigaction old_prof;
+};
+
+// the runner is single-threaded, threads started by tests are sampled too
+static ea_profile_t* active = NULL;
+
+static void on_sample(int sig) {
+	(void)sig;
+	ea_profile_t* profile = active;
+	if (!profile) {
+		return;
+	}
+	int saved_errno = errno;
+	int sample = __atomic_fetch_add(&profile->sample_count, 1, __ATOMIC_RELAXED);
+	int first = __atomic_fetch_add(&profile->frame_count, PROFILE_MAX_DEPTH, __ATOMIC_RELAXED);
+	if ((sample < PROFILE_MAX_SAMPLES) && (first + PROFILE_MAX_DEPTH <= PROFILE_POOL_FRAMES)) {
+		profile->samples[sample].depth = backtrace(profile->frames + first, PROFILE_MAX_DEPTH);
+		profile->samples[sample].first = first;
+	}
+	else {
+		__atomic_fetch_add(&profile->dropped, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_sub(&profile->sample_count, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_sub(&profile->frame_count, PROFILE_MAX_DEPTH, __ATOMIC_RELAXED);
+	}
+	errno = saved_errno;
+}
+
+// symbols
+
+#ifdef PROFILE_HAVE_ELF
+
+static int compare_symbols(const void* a, const void* b) {
+	const symbol_t* sa = (const symbol_t*)a;
+	const symbol_t* sb = (const symbol_t*)b;
+	return (sa->value > sb->value) - (sa->value < sb->value);
+}
+
+// the executable is the first object
+static int get_exe_bias(struct dl_phdr_info* info, size_t size, void* data) {
+	(void)size;
+	*(unsigned long long*)data = (unsigned long long)info->dlpi_addr;
+	return 1;
+}
+
+// read the function symbols of the executable (static functions are not in
+// the dynamic symbol table dladdr() uses)
+static void load_symbols(ea_profile_t* profile) {
+	FILE* f = fopen("/proc/self/exe", "rb");
+	if (!f) {
+		return;
+	}
+	ea_group_t* root = profile->root;
+	Elf64_Ehdr eh;
+	Elf64_Shdr* sections = NULL;
+	Elf64_Sym* syms = NULL;
+	if ((fread(&eh, sizeof(eh), 1, f) != 1) || (memcmp(eh.e_ident, ELFMAG, SELFMAG) != 0) || (eh.e_ident[EI_CLASS] != ELFCLASS64)
+		|| (eh.e_shentsize != sizeof(Elf64_Shdr)) || !eh.e_shnum) {
+		fclose(f);
+		return;
+	}
+	sections = (Elf64_Shdr*)root->mem_alloc(NULL, (int)sizeof(Elf64_Shdr) * eh.e_shnum, root->mem_alloc_opaque);
+	int ok = (fseek(f, (long)eh.e_shoff, SEEK_SET) == 0) && (fread(sections, sizeof(Elf64_Shdr), eh.e_shnum, f) == eh.e_shnum);
+	for (int i = 0; ok && (i < eh.e_shnum); ++i) {
+		const Elf64_Shdr* sh = &sections[i];
+		if ((sh->sh_type != SHT_SYMTAB) || (sh->sh_link >= eh.e_shnum)) {
+			continue;
+		}
+		const Elf64_Shdr* str = &sections[sh->sh_link];
+		int count = (int)(sh->sh_size / sizeof(Elf64_Sym));
+		syms = (Elf64_Sym*)root->mem_alloc(NULL, (int)sh->sh_size, root->mem_alloc_opaque);
+		profile->strtab = (char*)root->mem_alloc(NULL, (int)str->sh_size + 1, root->mem_alloc_opaque);
+		if ((fseek(f, (long)sh->sh_offset, SEEK_SET) != 0) || (fread(syms, sizeof(Elf64_Sym), count, f) != (size_t)count)
+			|| (fseek(f, (long)str->sh_offset, SEEK_SET) != 0) || (fread(profile->strtab, 1, str->sh_size, f) != str->sh_size)) {
+			break;
+		}
+		profile->strtab[str->sh_size] = '\0';
+		profile->symbols = (symbol_t*)root->mem_alloc(NULL, (int)sizeof(symbol_t) * count, root->mem_alloc_opaque);
+		for (int j = 0; j < count; ++j) {
+			if ((ELF64_ST_TYPE(syms[j].st_info) == STT_FUNC) && syms[j].st_value && (syms[j].st_name < str->sh_size)) {
+				symbol_t* s = &profile->symbols[profile->symbol_count++];
+				s->value = syms[j].st_value;
+				s->size = syms[j].st_size;
+				s->name = profile->strtab + syms[j].st_name;
+			}
+		}
+		qsort(profile->symbols, profile->symbol_count, sizeof(symbol_t), compare_symbols);
+		break;
+	}
+	if (syms) {
+		root->mem_alloc(syms, 0, root->mem_alloc_opaque);
+	}
+	root->mem_alloc(sections, 0, root->mem_alloc_opaque);
+	fclose(f);
+
+	// symbol addresses are relative to the load address of a position independent executable
+	dl_iterate_phdr(get_exe_bias, &profile->exe_bias);
+}
+
+static const char* find_symbol(const ea_profile_t* profile, unsigned long long addr) {
+	int lo = 0, hi = profile->symbol_count - 1, found = -1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		if (profile->symbols[mid].value <= addr) {
+			found = mid;
+			lo = mid + 1;
+		}
+		else {
+			hi = mid - 1;
+		}
+	}
+	if ((found < 0) || (addr >= profile->symbols[found].value + (profile->symbols[found].size ? profile->symbols[found].size : 1))) {
+		return NULL;
+	}
+	return profile->symbols[found].name;
+}
+
+#else
+
+static void load_symbols(ea_profile_t* profile) {
+	(void)profile;
+}
+
+static const char* find_symbol(const ea_profile_t* profile, unsigned long long addr) {
+	(void)profile;
+	(void)addr;
+	return NULL;
+}
+
+#endif // PROFILE_HAVE_ELF
+
+// name of a frame, written to buf if not a symbol name
+static const char* frame_name(const ea_profile_t* profile, void* pc, char* buf, int size) {
+	// symbols of the executable (the lookup checks the size, so other modules are not found)
+	if (profile->symbols) {
+		const char* name = find_symbol(profile, (unsigned long long)(size_t)pc - profile->exe_bias);
+		if (name) {
+			return name;
+		}
+	}
+	Dl_info info;
+	int have_info = dladdr(pc, &info);
+	if (have_info && info.dli_sname) {
+		return info.dli_sname;
+	}
+	if (have_info && info.dli_fname) {
+		const char* module = strrchr(info.dli_fname, '/');
+		snprintf(buf, size, "%s+0x%llx", module ? module + 1 : info.dli_fname,
+			(unsigned long long)((char*)pc - (char*)info.dli_fbase));
+		return buf;
+	}
+	snprintf(buf, size, "0x%llx", (unsigned long long)(size_t)pc);
+	return buf;
+}
+
+// profiler
+
+ea_profile_t* ea__profile_create(ea_group_t* root, const char* dir, int hz) {
+	if (mkdir(dir, 0755) != 0 && (errno != EEXIST)) {
+		ea__printf("Cannot create the profile directory: %s\n", dir);
+		return NULL;
+	}
+	ea_profile_t* profile = (ea_profile_t*)root->mem_alloc(NULL, sizeof(ea_profile_t), root->mem_alloc_opaque);
+	memset(profile, 0, sizeof(ea_profile_t));
+	profile->root = root;
+	profile->dir = dir;
+	profile->hz = (hz > 0) ? hz : PROFILE_DEFAULT_HZ;
+	profile->frames = (void**)root->mem_alloc(NULL, (int)sizeof(void*) * PROFILE_POOL_FRAMES, root->mem_alloc_opaque);
+	profile->samples = (sample_t*)root->mem_alloc(NULL, (int)sizeof(sample_t) * PROFILE_MAX_SAMPLES, root->mem_alloc_opaque);
+	load_symbols(profile);
+
+	// the first backtrace() loads the unwinder, not something to do in a signal handler
+	void* warmup[4];
+	backtrace(warmup, 4);
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_sample;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGPROF, &sa, &profile->old_prof);
+	return profile;
+}
+
+static void set_timer(int hz) {
+	struct itimerval timer;
+	memset(&timer, 0, sizeof(timer));
+	if (hz > 0) {
+		timer.it_interval.tv_sec = 0;
+		timer.it_interval.tv_usec = (1000000 / hz > 0) ? 1000000 / hz : 1;
+		timer.it_value = timer.it_interval;
+	}
+	setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+static unsigned long long cpu_time_ns(void) {
+	struct timespec ts;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) {
+		return 0;
+	}
+	return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+void ea__profile_start(ea_profile_t* profile) {
+	// the frames below this one are the runner's, the test runs on top of them
+	void* frames[PROFILE_MAX_DEPTH];
+	profile->outer_frames = backtrace(frames, PROFILE_MAX_DEPTH) - 1;
+	profile->frame_count = 0;
+	profile->sample_count = 0;
+	profile->dropped = 0;
+	active = profile;
+	profile->cpu_start_ns = cpu_time_ns();
+	set_timer(profile->hz);
+}
+
+void ea__profile_stop(ea_profile_t* profile) {
+	set_timer(0);
+	profile->cpu_ns = cpu_time_ns() - profile->cpu_start_ns;
+	active = NULL;
+}
+
+static int compare_strings(const void* a, const void* b) {
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+typedef struct {
+	const char* name;
+	int count;
+} self_t;
+
+static int compare_self(const void* a, const void* b) {
+	return ((const self_t*)b)->count - ((const self_t*)a)->count;
+}
+
+void ea__profile_report(ea_profile_t* profile, const char* name, int name_len) {
+	int count = profile->sample_count;
+	if (count <= 0) {
+		return;
+	}
+	ea_group_t* root = profile->root;
+
+	// fold each sample to "test;outer;...;inner", then count equal lines
+	int cap = 4096, len = 0;
+	char* text = (char*)root->mem_alloc(NULL, cap, root->mem_alloc_opaque);
+	int* offsets = (int*)root->mem_alloc(NULL, (int)sizeof(int) * count * 2, root->mem_alloc_opaque);
+	int* self_offsets = offsets + count; // innermost frame of the line, -1 if none
+	for (int i = 0; i < count; ++i) {
+		const sample_t* sample = &profile->samples[i];
+		void** frames = profile->frames + sample->first;
+		int inner = PROFILE_HANDLER_FRAMES;
+		int outer = sample->depth - profile->outer_frames; // exclusive
+		if (outer <= inner) {
+			outer = sample->depth; // not on the runner's stack (e.g. a thread of the test)
+		}
+		int need = name_len + 2 + (outer - inner) * 256;
+		if (len + need > cap) {
+			while (len + need > cap) {
+				cap *= 2;
+			}
+			char* grown = (char*)root->mem_alloc(NULL, cap, root->mem_alloc_opaque);
+			memcpy(grown, text, len);
+			root->mem_alloc(text, 0, root->mem_alloc_opaque);
+			text = grown;
+		}
+		offsets[i] = len;
+		self_offsets[i] = -1;
+		len += snprintf(text + len, cap - len, "%.*s", name_len, name);
+		for (int f = outer - 1; f >= inner; --f) {
+			// return addresses point after the call, look up the call itself
+			char* pc = (char*)frames[f] - ((f > inner) ? 1 : 0);
+			char buf[256];
+			self_offsets[i] = len + 1;
+			len += snprintf(text + len, cap - len, ";%.250s", frame_name(profile, pc, buf, sizeof(buf)));
+		}
+		text[len++] = '\0';
+	}
+
+	// self time per innermost frame
+	self_t* selfs = (self_t*)root->mem_alloc(NULL, (int)sizeof(self_t) * count, root->mem_alloc_opaque);
+	int self_count = 0;
+	for (int i = 0; i < count; ++i) {
+		if (self_offsets[i] < 0) {
+			continue;
+		}
+		const char* self = text + self_offsets[i];
+		int s = 0;
+		while ((s < self_count) && (strcmp(selfs[s].name, self) != 0)) {
+			s++;
+		}
+		if (s == self_count) {
+			selfs[self_count].name = self;
+			selfs[self_count++].count = 0;
+		}
+		selfs[s].count++;
+	}
+	char** lines = (char**)root->mem_alloc(NULL, (int)sizeof(char*) * count, root->mem_alloc_opaque);
+	for (int i = 0; i < count; ++i) {
+		lines[i] = text + offsets[i];
+	}
+	qsort(lines, count, sizeof(char*), compare_strings);
+
+	// one file per test, the name with '/' replaced
+	char path[PROFILE_PATH_MAX];
+	int pos = snprintf(path, sizeof(path), "%s/", profile->dir);
+	for (int i = 0; (i < name_len) && (pos < (int)sizeof(path) - 8); ++i) {
+		path[pos++] = (name[i] == '/') ? '.' : name[i];
+	}
+	snprintf(path + pos, sizeof(path) - pos, ".folded");
+	FILE* f = fopen(path, "wb");
+	if (f) {
+		for (int i = 0; i < count; ) {
+			int j = i + 1;
+			while ((j < count) && (strcmp(lines[i], lines[j]) == 0)) {
+				j++;
+			}
+			fprintf(f, "%s %d\n", lines[i], j - i);
+			i = j;
+		}
+		fclose(f);
+	}
+
+	// summary, the rate the timer delivered may be lower than the requested one
+	unsigned long long tenths = profile->cpu_ns / 100000;
+	unsigned long long rate = profile->cpu_ns ? (unsigned long long)(count + profile->dropped) * 1000000000ull / profile->cpu_ns : 0;
+	ea__printf("  Profile: %d samples in %llu.%llu ms CPU (%llu Hz)", count, tenths / 10, tenths % 10, rate);
+	if (profile->dropped) {
+		ea__printf(", %d dropped", profile->dropped);
+	}
+	ea__printf(", %s %s\n", f ? "folded stacks in" : "cannot write", path);
+	qsort(selfs, self_count, sizeof(self_t), compare_self);
+	for (int s = 0; (s < self_count) && (s < PROFILE_TOP_SYMBOLS); ++s) {
+		int permille = selfs[s].count * 1000 / count;
+		ea__printf("  %5d.%d%%  %s\n", permille / 10, permille % 10, selfs[s].name);
+	}
+
+	root->mem_alloc(lines, 0, root->mem_alloc_opaque);
+	root->mem_alloc(selfs, 0, root->mem_alloc_opaque);
+	root->mem_alloc(offsets, 0, root->mem_alloc_opaque);
+	root->mem_alloc(text, 0, root->mem_alloc_opaque);
+}
+
+void ea__profile_finish(ea_profile_t* profile) {
+	ea_group_t* root = profile->root;
+	sigaction(SIGPROF, &profile->old_prof, NULL);
+	if (profile->symbols) {
+		root->mem_alloc(profile->symbols, 0, root->mem_alloc_opaque);
+	}
+	if (profile->strtab) {
+		root->mem_alloc(profile->strtab, 0, root->mem_alloc_opaque);
+	}
+	root->mem_alloc(profile->samples, 0, root->mem_alloc_opaque);
+	root->mem_alloc(profile->frames, 0, root->mem_alloc_opaque);
+	root->mem_alloc(profile, 0, root->mem_alloc_opaque);
+}
+
+#endif // PROFILE_SUPPORTED
@@ -0,0 +1,516 @@
+#include <string.h>
+
+#ifdef EA_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "ea_internal.h"
+
+#ifndef PROPERTY_MAX_CHOICES
+#define PROPERTY_MAX_CHOICES 4096
+#endif
+
+#ifndef PROPERTY_MAX_SHRINKS
+#define PROPERTY_MAX_SHRINKS 10000
+#endif
+
+#ifndef PROPERTY_MAX_THREADS
+#define PROPERTY_MAX_THREADS 64
+#endif
+
+#ifndef PROPERTY_DEFAULT_CASES
+#define PROPERTY_DEFAULT_CASES 100
+#endif
+
+#ifdef EA_HAVE_PTHREADS
+#define prop_atomic_inc(ptr) __atomic_fetch_add(ptr, 1, __ATOMIC_RELAXED)
+#define prop_atomic_load(ptr) __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#define prop_atomic_store(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELAXED)
+#define prop_atomic_cas(ptr, expected, desired) __atomic_compare_exchange_n(ptr, expected, desired, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#else
+#define prop_atomic_inc(ptr) ((*(ptr))++)
+#define prop_atomic_load(ptr) (*(ptr))
+#define prop_atomic_store(ptr, value) (*(ptr) = (value))
+static int prop_atomic_cas(int* ptr, int* expected, int desired) {
+	if (*ptr != *expected) {
+		*expected = *ptr;
+		return 0;
+	}
+	*ptr = desired;
+	return 1;
+}
+#endif
+
+typedef struct {
+	ea__prop_func_t prop_func;
+	int cases;
+	int time_budget_ms;
+	int threads;
+} ea_property_t;
+
+/*
+ * Every generator draws raw 64-bit choices through draw(). In record mode the
+ * choices come from the random generator and are recorded, in replay mode they
+ * are read back from the buffer (reading past the end yields 0). Generators map
+ * smaller raw values to simpler values, so a failing case is shrunk by
+ * deleting and minimizing the recorded choices and replaying the body.
+ */
+struct ea_prop_s {
+	unsigned long long rng;
+	unsigned long long* choices;
+	int count; // number of valid choices
+	int pos; // next choice to draw
+	int replay;
+	int print; // print generated inputs (final counterexample replay)
+	int input_index;
+};
+
+static unsigned long long next_random(unsigned long long* state) {
+	// splitmix64
+	unsigned long long z = (*state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+static unsigned long long draw(ea_prop_t* prop, unsigned long long random_value) {
+	if (prop->replay) {
+		unsigned long long r = (prop->pos < prop->count) ? prop->choices[prop->pos] : 0;
+		prop->pos++;
+		return r;
+	}
+	if (prop->pos >= PROPERTY_MAX_CHOICES) {
+		return 0; // out of space, same as replaying past the end
+	}
+	prop->choices[prop->pos++] = random_value;
+	prop->count = prop->pos;
+	return random_value;
+}
+
+// integers: raw values zig-zag around the value closest to 0 while both sides
+// are in range, then continue on the longer side, so smaller raw values are
+// always closer to the origin
+static long long int_origin(long long min, long long max) {
+	return (min > 0) ? min : ((max < 0) ? max : 0);
+}
+
+static long long int_from_raw(unsigned long long r, long long min, long long max) {
+	long long origin = int_origin(min, max);
+	unsigned long long below = (unsigned long long)origin - (unsigned long long)min;
+	unsigned long long above = (unsigned long long)max - (unsigned long long)origin;
+	unsigned long long shorter = (below < above) ? below : above;
+	unsigned long long d = (r >> 1) + (r & 1);
+	if (d <= shorter) {
+		return (long long)((r & 1) ? (unsigned long long)origin - d : (unsigned long long)origin + d);
+	}
+	d = r - shorter;
+	if ((above > below) && (d <= above)) {
+		return (long long)((unsigned long long)origin + d);
+	}
+	if ((below >= above) && (d <= below)) {
+		return (long long)((unsigned long long)origin - d);
+	}
+	unsigned long long span = above + below + 1;
+	return (long long)((unsigned long long)min + (span ? r % span : r));
+}
+
+static unsigned long long int_to_raw(long long v, long long min, long long max) {
+	long long origin = int_origin(min, max);
+	unsigned long long below = (unsigned long long)origin - (unsigned long long)min;
+	unsigned long long above = (unsigned long long)max - (unsigned long long)origin;
+	unsigned long long shorter = (below < above) ? below : above;
+	unsigned long long d = (v >= origin) ? (unsigned long long)v - (unsigned long long)origin : (unsigned long long)origin - (unsigned long long)v;
+	if (d > shorter) {
+		return d + shorter;
+	}
+	return (v >= origin) ? d * 2 : d * 2 - 1;
+}
+
+static long long gen_int(ea_prop_t* prop, long long min, long long max) {
+	if (min > max) {
+		long long tmp = min;
+		min = max;
+		max = tmp;
+	}
+	unsigned long long r = 0;
+	if (!prop->replay) {
+		r = next_random(&prop->rng);
+		unsigned long long bias = next_random(&prop->rng);
+		if ((bias & 7) == 0) {
+			// prefer edge cases now and then
+			long long origin = int_origin(min, max);
+			long long edges[5] = { min, max, origin, origin, origin };
+			if (origin < max) edges[3] = origin + 1;
+			if (origin > min) edges[4] = origin - 1;
+			r = int_to_raw(edges[(bias >> 3) % 5], min, max);
+		}
+	}
+	return int_from_raw(draw(prop, r), min, max);
+}
+
+long long ea_gen_int(ea_prop_t* prop, long long min, long long max) {
+	long long v = gen_int(prop, min, max);
+	if (prop->print) {
+		ea__printf("  Input #%d: %lld\n", ++prop->input_index, v);
+	}
+	return v;
+}
+
+unsigned long long ea_gen_uint(ea_prop_t* prop, unsigned long long min, unsigned long long max) {
+	if (min > max) {
+		unsigned long long tmp = min;
+		min = max;
+		max = tmp;
+	}
+	unsigned long long r = 0;
+	if (!prop->replay) {
+		r = next_random(&prop->rng);
+		unsigned long long bias = next_random(&prop->rng);
+		if ((bias & 7) == 0) {
+			unsigned long long edges[3] = { 0, max - min, 1 };
+			r = edges[(bias >> 3) % ((max > min) ? 3 : 2)];
+		}
+	}
+	r = draw(prop, r);
+	unsigned long long span = max - min + 1;
+	unsigned long long v = (r <= max - min) ? min + r : min + (span ? r % span : r);
+	if (prop->print) {
+		ea__printf("  Input #%d: %llu\n", ++prop->input_index, v);
+	}
+	return v;
+}
+
+double ea_gen_double(ea_prop_t* prop, double min, double max) {
+	if (min > max) {
+		double tmp = min;
+		min = max;
+		max = tmp;
+	}
+	double origin = (min > 0.0) ? min : ((max < 0.0) ? max : 0.0);
+	unsigned long long r = 0;
+	if (!prop->replay) {
+		r = next_random(&prop->rng);
+		unsigned long long bias = next_random(&prop->rng);
+		if ((bias & 7) == 0) {
+			r = (bias >> 3) % 3;
+		}
+	}
+	r = draw(prop, r);
+
+	// 0, 1 and 2 are the origin and the bounds, otherwise the low bit selects
+	// the direction and the high bits the distance from the origin
+	double v;
+	switch (r) {
+	case 0: v = origin; break;
+	case 1: v = min; break;
+	case 2: v = max; break;
+	default: {
+		double mag = (double)(r >> 11) * (1.0 / 9007199254740992.0);
+		v = (r & 1) ? origin + mag * (min - origin) : origin + mag * (max - origin);
+		if (v < min) v = min;
+		if (v > max) v = max;
+		break;
+	}
+	}
+	if (prop->print) {
+		ea__printf("  Input #%d: %.17g\n", ++prop->input_index, v);
+	}
+	return v;
+}
+
+int ea_gen_bytes(ea_prop_t* prop, unsigned char* buf, int min_len, int max_len) {
+	int len = (int)gen_int(prop, min_len, max_len);
+	for (int i = 0; i < len; ++i) {
+		buf[i] = (unsigned char)gen_int(prop, 0, 255);
+	}
+	if (prop->print) {
+		ea__printf("  Input #%d: %d byte(s):", ++prop->input_index, len);
+		for (int i = 0; (i < len) && (i < 32); ++i) {
+			ea__printf(" %02x", buf[i]);
+		}
+		ea__printf("%s\n", (len > 32) ? " ..." : "");
+	}
+	return len;
+}
+
+static const char default_alphabet[] =
+	"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+	" !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+int ea_gen_str(ea_prop_t* prop, char* buf, int max_len, const char* alphabet) {
+	if (!alphabet || !*alphabet) {
+		alphabet = default_alphabet;
+	}
+	int alphabet_len = (int)strlen(alphabet);
+	int len = (int)gen_int(prop, 0, max_len);
+	for (int i = 0; i < len; ++i) {
+		buf[i] = alphabet[gen_int(prop, 0, alphabet_len - 1)];
+	}
+	buf[len] = '\0';
+	if (prop->print) {
+		ea__printf("  Input #%d: \"%s\"\n", ++prop->input_index, buf);
+	}
+	return len;
+}
+
+// case execution
+
+typedef struct {
+	const ea_property_t* property;
+	const ea__test_info_t* outer; // test info of the property test
+	unsigned long long seed;
+	int cases;
+	unsigned long long deadline; // 0 if there is no time budget
+
+	// shared between threads
+	int next_case;
+	int done_cases;
+	int failed_case; // lowest failing case found, or cases if none
+	int stop;
+} prop_run_t;
+
+typedef struct {
+	prop_run_t* run;
+	ea_prop_t* prop;
+} prop_worker_t;
+
+static int run_body(const prop_run_t* run, ea_prop_t* prop) {
+	ea__test_info_t test_info = { 0 };
+	test_info.quiet = 1;
+	test_info.test = run->outer->test;
+	test_info.name = run->outer->name;
+	test_info.name_len = run->outer->name_len;
+	prop->pos = 0;
+	prop->input_index = 0;
+	run->property->prop_func(&test_info, prop);
+	return test_info.current_failed;
+}
+
+static void start_case(const prop_run_t* run, ea_prop_t* prop, int case_index) {
+	prop->rng = run->seed ^ ((unsigned long long)case_index * 0xd1b54a32d192ed03ull);
+	next_random(&prop->rng);
+	prop->replay = 0;
+	prop->count = 0;
+}
+
+static void* run_cases(void* opaque) {
+	prop_worker_t* worker = (prop_worker_t*)opaque;
+	prop_run_t* run = worker->run;
+	while (!prop_atomic_load(&run->stop)) {
+		int case_index = prop_atomic_inc(&run->next_case);
+		if (case_index >= run->cases) {
+			break;
+		}
+		if (run->deadline && ((case_index & 63) == 0) && (ea__now_ns() > run->deadline)) {
+			prop_atomic_store(&run->stop, 1);
+			break;
+		}
+		start_case(run, worker->prop, case_index);
+		prop_atomic_inc(&run->done_cases);
+		if (run_body(run, worker->prop)) {
+			int lowest = prop_atomic_load(&run->failed_case);
+			while ((case_index < lowest) && !prop_atomic_cas(&run->failed_case, &lowest, case_index)) {
+			}
+			prop_atomic_store(&run->stop, 1);
+			break;
+		}
+	}
+	return NULL;
+}
+
+// shrinking
+
+typedef struct {
+	const prop_run_t* run;
+	ea_prop_t* prop; // replay buffer
+	unsigned long long* best;
+	int best_count;
+	int steps;
+} shrinker_t;
+
+static int is_simpler(const unsigned long long* a, int acount, const unsigned long long* b, int bcount) {
+	if (acount != bcount) {
+		return acount < bcount;
+	}
+	for (int i = 0; i < acount; ++i) {
+		if (a[i] != b[i]) {
+			return a[i] < b[i];
+		}
+	}
+	return 0;
+}
+
+// replays the candidate in the prop buffer, keeps it if it still fails and is simpler
+static int try_candidate(shrinker_t* s, int count) {
+	s->steps++;
+	s->prop->replay = 1;
+	s->prop->count = count;
+	if (!run_body(s->run, s->prop)) {
+		return 0;
+	}
+	int used = (s->prop->pos < count) ? s->prop->pos : count;
+	if (!is_simpler(s->prop->choices, used, s->best, s->best_count)) {
+		return 0;
+	}
+	memcpy(s->best, s->prop->choices, sizeof(unsigned long long) * used);
+	s->best_count = used;
+	return 1;
+}
+
+static void shrink(shrinker_t* s) {
+	int improved = 1;
+	while (improved && (s->steps < PROPERTY_MAX_SHRINKS)) {
+		improved = 0;
+
+		// delete blocks of choices, starting from the end
+		for (int size = 8; size >= 1; size /= 2) {
+			for (int i = s->best_count - size; (i >= 0) && (s->steps < PROPERTY_MAX_SHRINKS); --i) {
+				if (i + size > s->best_count) {
+					continue;
+				}
+				memcpy(s->prop->choices, s->best, sizeof(unsigned long long) * i);
+				memcpy(s->prop->choices + i, s->best + i + size, sizeof(unsigned long long) * (s->best_count - i - size));
+				if (try_candidate(s, s->best_count - size)) {
+					improved = 1;
+				}
+			}
+		}
+
+		// minimize each choice: try 0, then binary search the smallest failing value
+		for (int i = 0; (i < s->best_count) && (s->steps < PROPERTY_MAX_SHRINKS); ++i) {
+			if (s->best[i] == 0) {
+				continue;
+			}
+			unsigned long long lo = 0;
+			unsigned long long hi = s->best[i];
+			unsigned long long mid = 0;
+			while ((i < s->best_count) && (s->best[i] == hi) && (s->steps < PROPERTY_MAX_SHRINKS)) {
+				memcpy(s->prop->choices, s->best, sizeof(unsigned long long) * s->best_count);
+				s->prop->choices[i] = mid;
+				if (try_candidate(s, s->best_count)) {
+					improved = 1;
+					hi = mid;
+				}
+				else {
+					lo = mid;
+				}
+				if (lo + 1 >= hi) {
+					break;
+				}
+				mid = lo + (hi - lo) / 2;
+			}
+		}
+	}
+}
+
+// property test function
+
+static int resolve(int own, int configured, int fallback) {
+	return own ? own : (configured ? configured : fallback);
+}
+
+static unsigned long long hash_name(const char* name, int len) {
+	unsigned long long h = 0xcbf29ce484222325ull;
+	for (int i = 0; i < len; ++i) {
+		h = (h ^ (unsigned char)name[i]) * 0x100000001b3ull;
+	}
+	return h;
+}
+
+static void run_property(ea__test_info_t* test_info) {
+	const ea_property_t* property = (const ea_property_t*)test_info->test->opaque;
+	ea_group_t* group = test_info->test->parent;
+	const ea_config_t* config = ea__get_config(group);
+
+	// resolve settings
+	prop_run_t run = { 0 };
+	run.property = property;
+	run.outer = test_info;
+	run.cases = resolve(property->cases, config->prop_cases, PROPERTY_DEFAULT_CASES);
+	run.failed_case = run.cases;
+	int time_budget_ms = resolve(property->time_budget_ms, config->prop_time_ms, 0);
+	if (time_budget_ms > 0) {
+		run.deadline = ea__now_ns() + (unsigned long long)time_budget_ms * 1000000ull;
+	}
+	int threads = resolve(property->threads, config->prop_threads, 1);
+#ifndef EA_HAVE_PTHREADS
+	threads = 1;
+#endif
+	if (threads > PROPERTY_MAX_THREADS) threads = PROPERTY_MAX_THREADS;
+	if (threads > run.cases) threads = run.cases;
+	if (threads < 1) threads = 1;
+	unsigned long long base_seed = config->seed_set ? config->seed : ea__now_ns();
+	run.seed = base_seed ^ hash_name(test_info->name, test_info->name_len);
+
+	// allocate generator states (one per thread) plus the shrinking buffer
+	int state_size = (int)(sizeof(ea_prop_t) + sizeof(unsigned long long) * PROPERTY_MAX_CHOICES);
+	char* block = (char*)group->mem_alloc(NULL, state_size * threads + (int)sizeof(unsigned long long) * PROPERTY_MAX_CHOICES, group->mem_alloc_opaque);
+	prop_worker_t workers[PROPERTY_MAX_THREADS];
+	for (int i = 0; i < threads; ++i) {
+		ea_prop_t* prop = (ea_prop_t*)(block + state_size * i);
+		memset(prop, 0, sizeof(ea_prop_t));
+		prop->choices = (unsigned long long*)(prop + 1);
+		workers[i].run = &run;
+		workers[i].prop = prop;
+	}
+	unsigned long long* best = (unsigned long long*)(block + state_size * threads);
+
+	// run cases, the calling thread is worker 0
+#ifdef EA_HAVE_PTHREADS
+	pthread_t thread_ids[PROPERTY_MAX_THREADS];
+	int started = 1;
+	for (; started < threads; ++started) {
+		if (pthread_create(&thread_ids[started], NULL, run_cases, &workers[started]) != 0) {
+			break;
+		}
+	}
+	run_cases(&workers[0]);
+	for (int i = 1; i < started; ++i) {
+		pthread_join(thread_ids[i], NULL);
+	}
+#else
+	run_cases(&workers[0]);
+#endif
+
+	if (run.failed_case < run.cases) {
+		// regenerate the failing case, then shrink it
+		ea_prop_t* prop = workers[0].prop;
+		start_case(&run, prop, run.failed_case);
+		run_body(&run, prop);
+		shrinker_t s = { 0 };
+		s.run = &run;
+		s.prop = prop;
+		s.best = best;
+		s.best_count = (prop->pos < prop->count) ? prop->pos : prop->count;
+		memcpy(best, prop->choices, sizeof(unsigned long long) * s.best_count);
+		shrink(&s);
+
+		// replay the minimal counterexample with output enabled
+		if (!test_info->quiet) {
+			if (!test_info->current_failed) {
+				ea__printf("FAILED\n");
+			}
+			ea__printf("  Property falsified after %d case(s) with --seed=%llu, shrunk in %d step(s):\n",
+				run.done_cases, base_seed, s.steps);
+		}
+		test_info->current_failed = 1;
+		memcpy(prop->choices, best, sizeof(unsigned long long) * s.best_count);
+		prop->replay = 1;
+		prop->count = s.best_count;
+		prop->pos = 0;
+		prop->input_index = 0;
+		prop->print = !test_info->quiet;
+		property->prop_func(test_info, prop);
+	}
+
+	group->mem_alloc(block, 0, group->mem_alloc_opaque);
+}
+
+void ea__property_add(ea_group_t* group, ea__prop_func_t prop_func, const char* prop_name, const char* file, int line, int cases, int time_budget_ms, int threads) {
+	ea_property_t* property = (ea_property_t*)group->mem_alloc(NULL, sizeof(ea_property_t), group->mem_alloc_opaque);
+	property->prop_func = prop_func;
+	property->cases = cases;
+	property->time_budget_ms = time_budget_ms;
+	property->threads = threads;
+	ea__test_add_ex(group, run_property, prop_name, file, line, property);
+}
@@ -0,0 +1,205 @@
+#include <string.h>
+
+#include "ea_internal.h"
+
+#ifdef EA_HAVE_POSIX
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/*
+ * The server accepts one request per connection on a Unix domain socket: a
+ * line with a command and an optional filter string. The output of the run
+ * goes to the connection, which is closed after it. Runs are warm: group
+ * setups run once, before the first test of the group, and shared fixtures
+ * stay built, so only the first request pays for them. Everything is torn
+ * down by ea_release_group() after the shutdown request.
+ */
+
+#ifndef SERVER_REQUEST_LEN
+#define SERVER_REQUEST_LEN 4096
+#endif
+
+#ifndef EA_HAVE_POSIX
+
+int ea__serve(ea_group_t* group, const char* path) {
+	(void)group;
+	(void)path;
+	ea__printf("The test server is not supported on this platform.\n");
+	return 0;
+}
+
+#else
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // a client closing early must not kill the server (SO_NOSIGPIPE elsewhere)
+#endif
+
+static void send_output(const char* data, int len, void* opaque) {
+	int fd = *(int*)opaque;
+	while (len > 0) {
+		ssize_t n = send(fd, data, (size_t)len, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return; // the client is gone, the run goes on
+		}
+		data += n;
+		len -= (int)n;
+	}
+}
+
+static void discard_output(const char* data, int len, void* opaque) {
+	(void)data;
+	(void)len;
+	(void)opaque;
+}
+
+static const char* status_name(ea_test_status_t status) {
+	switch (status) {
+	case EA_TEST_PASSED: return "passed";
+	case EA_TEST_FAILED: return "failed";
+	default: return "crashed";
+	}
+}
+
+static void print_results_json(const ea_results_t* results) {
+	ea__printf("{\"total\": %d, \"failed\": %d, \"filtered\": %d, \"unchanged\": %d, \"tests\": [",
+		results->total_count, results->failed_count, results->filtered_count, results->unchanged_count);
+	for (int i = 0; i < results->count; ++i) {
+		const ea_test_result_t* test = &results->tests[i];
+		ea__printf("%s\n  {\"name\": ", i ? "," : "");
+		ea__print_json_string(test->name, -1);
+		ea__printf(", \"status\": \"%s\", \"file\": ", status_name(test->status));
+		ea__print_json_string(test->file ? test->file : "", -1);
+		ea__printf(", \"line\": %d, \"duration_ns\": %llu, \"assertions\": %d",
+			test->line, test->duration_ns, test->assertion_count);
+		if (test->failure_file) {
+			ea__printf(", \"failure_file\": ");
+			ea__print_json_string(test->failure_file, -1);
+			ea__printf(", \"failure_line\": %d, \"message\": ", test->failure_line);
+			ea__print_json_string(test->failure_message, -1);
+		}
+		if (test->output) {
+			ea__printf(", \"output\": ");
+			ea__print_json_string(test->output, -1);
+		}
+		ea__printf("}");
+	}
+	ea__printf("%s]}\n", results->count ? "\n" : "");
+}
+
+// read the request line, NULL-terminated without the newline; 0 if none
+static int read_request(int fd, char* buf, int cap) {
+	int len = 0;
+	while (len < cap - 1) {
+		ssize_t n = read(fd, buf + len, (size_t)(cap - 1 - len));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			break;
+		}
+		len += (int)n;
+		if (memchr(buf, '\n', (size_t)len)) {
+			break;
+		}
+	}
+	buf[len] = '\0';
+	buf[strcspn(buf, "\r\n")] = '\0';
+	return len > 0;
+}
+
+// handle a request on the connection, returns 0 after the shutdown request
+static int handle(ea_group_t* group, int fd, char* request) {
+	char* filter = strchr(request, ' ');
+	if (filter) {
+		*filter++ = '\0';
+		while (*filter == ' ') {
+			filter++;
+		}
+	}
+	const char* filterstring = (filter && *filter) ? filter : NULL;
+
+	ea_output_func_t old_func;
+	void* old_opaque;
+	ea__get_output(&old_func, &old_opaque);
+	int keep_serving = 1;
+	if (strcmp(request, "run") == 0) {
+		ea_set_output(send_output, &fd);
+		ea__run_warm(group, filterstring, 0);
+	}
+	else if (strcmp(request, "json") == 0) {
+		ea_set_output(discard_output, NULL);
+		ea_results_t* results = ea__run_warm(group, filterstring, 1);
+		ea_set_output(send_output, &fd);
+		print_results_json(results);
+		ea_results_free(group, results);
+	}
+	else if (strcmp(request, "shutdown") == 0) {
+		ea_set_output(send_output, &fd);
+		ea__printf("Shutting down.\n");
+		keep_serving = 0;
+	}
+	else {
+		ea_set_output(send_output, &fd);
+		ea__printf("Unknown request: %s (expected run, json or shutdown)\n", request);
+	}
+	ea_set_output(old_func, old_opaque);
+	return keep_serving;
+}
+
+int ea__serve(ea_group_t* group, const char* path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		ea__printf("Socket path too long: %s\n", path);
+		return 0;
+	}
+	strcpy(addr.sun_path, path);
+
+	int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd < 0) {
+		ea__printf("Cannot create the server socket.\n");
+		return 0;
+	}
+	unlink(path); // left over by a server that was killed
+	if ((bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) || (listen(listen_fd, 8) != 0)) {
+		ea__printf("Cannot listen on: %s\n", path);
+		close(listen_fd);
+		return 0;
+	}
+	ea__printf("Serving tests on: %s\n", path);
+
+	char request[SERVER_REQUEST_LEN];
+	int requests = 0;
+	for (int serving = 1; serving; ) {
+		int fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			ea__printf("Cannot accept connections: %s\n", strerror(errno));
+			break;
+		}
+#ifdef SO_NOSIGPIPE
+		int one = 1;
+		setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+		if (read_request(fd, request, sizeof(request))) {
+			requests++;
+			serving = handle(group, fd, request);
+		}
+		close(fd);
+	}
+	close(listen_fd);
+	unlink(path);
+	ea__printf("Served %d request(s).\n", requests);
+	return 1;
+}
+
+#endif // EA_HAVE_POSIX
@@ -0,0 +1,294 @@
+#include <string.h>
+
+#include "ea_internal.h"
+
+/*
+ * Failures are counted per site (file and line of the assertion) over a run.
+ * The first failures of a site are printed in full, later ones only count,
+ * with the range of the actual values where the assertion has one. Sites are
+ * kept in the order of their first failure, with an open addressing index.
+ * Worker processes and the children of isolated tests send the sites that
+ * failed since they last sent, their parent merges them into its own.
+ */
+
+enum {
+	value_none = 0,
+	value_int,
+	value_uint,
+	value_double,
+};
+
+typedef struct {
+	const char* file;
+	int line;
+	int count;
+	int value_kind; // kind of the observed values, value_none if none (or mixed)
+	long long int_min, int_max;
+	unsigned long long uint_min, uint_max;
+#ifndef EA_NO_DOUBLE
+	double double_min, double_max;
+#endif
+	int sent; // failures already sent to the coordinator
+	int next_changed; // index of the next site with unsent failures, -1 if last
+} site_t;
+
+struct ea_sites_s {
+	ea_group_t* root; // for mem_alloc
+	int full_limit;
+	site_t* sites;
+	int count, capacity;
+	int* index; // site indices, -1 if empty, power of two
+	int index_capacity;
+	int changed; // first site with unsent failures, -1 if none
+};
+
+static unsigned hash_site(const char* file, int line) {
+	unsigned h = 2166136261u ^ (unsigned)line;
+	for (; *file; ++file) {
+		h = (h ^ (unsigned char)*file) * 16777619u;
+	}
+	return h;
+}
+
+// same site, file names of other translation units may be other strings
+static int same_site(const site_t* site, const char* file, int line) {
+	return (site->line == line) && ((site->file == file) || (strcmp(site->file, file) == 0));
+}
+
+ea_sites_t* ea__sites_create(ea_group_t* root, int full_limit) {
+	ea_sites_t* sites = (ea_sites_t*)root->mem_alloc(NULL, sizeof(ea_sites_t), root->mem_alloc_opaque);
+	memset(sites, 0, sizeof(ea_sites_t));
+	sites->root = root;
+	sites->full_limit = full_limit;
+	sites->changed = -1;
+	return sites;
+}
+
+static void rebuild_index(ea_sites_t* sites, int capacity) {
+	ea_group_t* root = sites->root;
+	if (sites->index) {
+		root->mem_alloc(sites->index, 0, root->mem_alloc_opaque);
+	}
+	sites->index = (int*)root->mem_alloc(NULL, (int)sizeof(int) * capacity, root->mem_alloc_opaque);
+	sites->index_capacity = capacity;
+	for (int i = 0; i < capacity; ++i) {
+		sites->index[i] = -1;
+	}
+	for (int i = 0; i < sites->count; ++i) {
+		unsigned idx = hash_site(sites->sites[i].file, sites->sites[i].line) & (capacity - 1);
+		while (sites->index[idx] >= 0) {
+			idx = (idx + 1) & (capacity - 1);
+		}
+		sites->index[idx] = i;
+	}
+}
+
+// the site, NULL if it never failed; *slot is the free index slot then
+static site_t* find(ea_sites_t* sites, const char* file, int line, unsigned* slot) {
+	if (!sites->index) {
+		return NULL;
+	}
+	unsigned idx = hash_site(file, line) & (sites->index_capacity - 1);
+	while (sites->index[idx] >= 0) {
+		site_t* site = &sites->sites[sites->index[idx]];
+		if (same_site(site, file, line)) {
+			return site;
+		}
+		idx = (idx + 1) & (sites->index_capacity - 1);
+	}
+	if (slot) {
+		*slot = idx;
+	}
+	return NULL;
+}
+
+// the site, created if it never failed
+static site_t* get_site(ea_sites_t* sites, const char* file, int line) {
+	unsigned slot = 0;
+	site_t* site = find(sites, file, line, &slot);
+	if (!site) {
+		ea_group_t* root = sites->root;
+		if (sites->count == sites->capacity) {
+			int capacity = sites->capacity ? sites->capacity * 2 : 16;
+			site_t* grown = (site_t*)root->mem_alloc(NULL, (int)sizeof(site_t) * capacity, root->mem_alloc_opaque);
+			if (sites->count) {
+				memcpy(grown, sites->sites, sizeof(site_t) * sites->count);
+				root->mem_alloc(sites->sites, 0, root->mem_alloc_opaque);
+			}
+			sites->sites = grown;
+			sites->capacity = capacity;
+		}
+		site = &sites->sites[sites->count++];
+		memset(site, 0, sizeof(site_t));
+		site->file = file;
+		site->line = line;
+		site->value_kind = -1; // no value yet
+		if (sites->count * 2 > sites->index_capacity) {
+			rebuild_index(sites, sites->index_capacity ? sites->index_capacity * 2 : 64);
+		}
+		else {
+			sites->index[slot] = sites->count - 1;
+		}
+	}
+	return site;
+}
+
+int ea__sites_note(ea_sites_t* sites, const char* file, int line) {
+	site_t* site = get_site(sites, file, line);
+	if (site->count++ == site->sent) {
+		site->next_changed = sites->changed;
+		sites->changed = (int)(site - sites->sites);
+	}
+	return (sites->full_limit < 0) || (site->count <= sites->full_limit);
+}
+
+// the site of a counted failure with a value of the kind, NULL if the kinds are mixed
+static site_t* value_site(ea_sites_t* sites, const char* file, int line, int kind, int* first) {
+	site_t* site = find(sites, file, line, NULL);
+	*first = 0;
+	if (!site || (site->value_kind == value_none)) {
+		return NULL;
+	}
+	if (site->value_kind < 0) {
+		site->value_kind = kind;
+		*first = 1;
+	}
+	else if (site->value_kind != kind) {
+		site->value_kind = value_none;
+		return NULL;
+	}
+	return site;
+}
+
+void ea__sites_int(ea_sites_t* sites, const char* file, int line, long long value) {
+	int first;
+	site_t* site = value_site(sites, file, line, value_int, &first);
+	if (site) {
+		site->int_min = (first || (value < site->int_min)) ? value : site->int_min;
+		site->int_max = (first || (value > site->int_max)) ? value : site->int_max;
+	}
+}
+
+void ea__sites_uint(ea_sites_t* sites, const char* file, int line, unsigned long long value) {
+	int first;
+	site_t* site = value_site(sites, file, line, value_uint, &first);
+	if (site) {
+		site->uint_min = (first || (value < site->uint_min)) ? value : site->uint_min;
+		site->uint_max = (first || (value > site->uint_max)) ? value : site->uint_max;
+	}
+}
+
+#ifndef EA_NO_DOUBLE
+void ea__sites_double(ea_sites_t* sites, const char* file, int line, double value) {
+	int first;
+	site_t* site = value_site(sites, file, line, value_double, &first);
+	if (site) {
+		site->double_min = (first || (value < site->double_min)) ? value : site->double_min;
+		site->double_max = (first || (value > site->double_max)) ? value : site->double_max;
+	}
+}
+#endif
+
+int ea__sites_changed(ea_sites_t* sites, ea__site_change_t* change) {
+	if (sites->changed < 0) {
+		return 0;
+	}
+	site_t* site = &sites->sites[sites->changed];
+	sites->changed = site->next_changed;
+	change->file = site->file;
+	change->line = site->line;
+	change->count = site->count - site->sent;
+	change->value_kind = site->value_kind;
+	change->min = change->max = 0;
+	switch (site->value_kind) {
+	case value_int:
+		change->min = (unsigned long long)site->int_min;
+		change->max = (unsigned long long)site->int_max;
+		break;
+	case value_uint:
+		change->min = site->uint_min;
+		change->max = site->uint_max;
+		break;
+#ifndef EA_NO_DOUBLE
+	case value_double:
+		memcpy(&change->min, &site->double_min, sizeof(double));
+		memcpy(&change->max, &site->double_max, sizeof(double));
+		break;
+#endif
+	default: break;
+	}
+	site->sent = site->count;
+	return 1;
+}
+
+void ea__sites_merge(ea_sites_t* sites, const ea__site_change_t* change) {
+	site_t* site = get_site(sites, change->file, change->line);
+	if ((change->count > 0) && (site->count == site->sent)) {
+		// left unsent, a worker passes on the failures of its isolated tests
+		site->next_changed = sites->changed;
+		sites->changed = (int)(site - sites->sites);
+	}
+	site->count += change->count;
+	switch (change->value_kind) {
+	case value_int:
+		ea__sites_int(sites, change->file, change->line, (long long)change->min);
+		ea__sites_int(sites, change->file, change->line, (long long)change->max);
+		break;
+	case value_uint:
+		ea__sites_uint(sites, change->file, change->line, change->min);
+		ea__sites_uint(sites, change->file, change->line, change->max);
+		break;
+#ifndef EA_NO_DOUBLE
+	case value_double: {
+		double min, max;
+		memcpy(&min, &change->min, sizeof(double));
+		memcpy(&max, &change->max, sizeof(double));
+		ea__sites_double(sites, change->file, change->line, min);
+		ea__sites_double(sites, change->file, change->line, max);
+		break;
+	}
+#endif
+	case value_none:
+		site->value_kind = value_none; // mixed in the worker
+		break;
+	default: break; // no value yet
+	}
+}
+
+void ea__sites_finish(ea_sites_t* sites) {
+	// list every site with its failures
+	if (sites->count) {
+		ea__printf("Failure sites:\n");
+		for (int i = 0; i < sites->count; ++i) {
+			const site_t* site = &sites->sites[i];
+			const char* short_file = site->file;
+			for (const char* p = site->file; *p; ++p) {
+				if ((*p == '/') || (*p == '\\')) {
+					short_file = p + 1;
+				}
+			}
+			ea__printf("  %s line %d: %d failure(s)", short_file, site->line, site->count);
+			if ((sites->full_limit >= 0) && (site->count > sites->full_limit)) {
+				ea__printf(", %d not printed", site->count - sites->full_limit);
+			}
+			switch (site->value_kind) {
+			case value_int: ea__printf(", actual values %lld to %lld", site->int_min, site->int_max); break;
+			case value_uint: ea__printf(", actual values %llu to %llu", site->uint_min, site->uint_max); break;
+#ifndef EA_NO_DOUBLE
+			case value_double: ea__printf(", actual values %g to %g", site->double_min, site->double_max); break;
+#endif
+			default: break;
+			}
+			ea__printf("\n");
+		}
+	}
+
+	ea_group_t* root = sites->root;
+	if (sites->sites) {
+		root->mem_alloc(sites->sites, 0, root->mem_alloc_opaque);
+	}
+	if (sites->index) {
+		root->mem_alloc(sites->index, 0, root->mem_alloc_opaque);
+	}
+	root->mem_alloc(sites, 0, root->mem_alloc_opaque);
+}
@@ -0,0 +1,213 @@
+#include <string.h>
+
+#include "ea_internal.h"
+
+#if defined(__linux__) && defined(EA_HAVE_POSIX)
+#define STACK_HAVE_CONTEXT 1
+#endif
+
+#ifdef STACK_HAVE_CONTEXT
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+/*
+ * A measured test runs on a dedicated stack (makecontext/swapcontext) which
+ * is filled with a pattern beforehand, the bytes no longer holding it after
+ * the test are the ones it touched. Below the stack (it grows down) is a
+ * guard page, a fault there is reported as stack overflow and fails the test
+ * instead of corrupting memory. Only the touched part is refilled for the
+ * next test.
+ */
+
+#ifndef STACK_DEFAULT_SIZE
+#define STACK_DEFAULT_SIZE (256 * 1024)
+#endif
+
+#ifndef STACK_FILL_BYTE
+#define STACK_FILL_BYTE 0xA5
+#endif
+
+// stack of the fault handler, the test stack is unusable when it overflows
+#ifndef STACK_SIGNAL_STACK_SIZE
+#define STACK_SIGNAL_STACK_SIZE (64 * 1024)
+#endif
+
+void ea__test_add_stack(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line, int budget_bytes) {
+	ea__test_add_ex(group, test_func, test_name, file, line, NULL)->stack_budget = budget_bytes;
+}
+
+int ea__stack_wanted(const ea__run_t* run, const ea_test_t* test) {
+	return run->config->stack_size || run->config->stack_budget || test->stack_budget;
+}
+
+#ifdef STACK_HAVE_CONTEXT
+
+struct ea_stack_s {
+	ea_group_t* root; // for mem_alloc
+	char* map; // guard page followed by the stack, mmap'ed (the guard needs page alignment)
+	int map_size;
+	char* base; // lowest byte of the stack
+	int size;
+
+	ucontext_t run_ctx, test_ctx;
+	sigjmp_buf overflow_jmp;
+	ea__test_func_t test_func;
+	ea__test_info_t* test_info;
+
+	char signal_stack[STACK_SIGNAL_STACK_SIZE];
+};
+
+// stack of the running test, the runner is single-threaded
+static ea_stack_t* active = NULL;
+static struct sigaction old_segv, old_bus;
+
+static void on_fault(int sig, siginfo_t* info, void* uctx) {
+	(void)uctx;
+	char* addr = (char*)info->si_addr;
+	if (active && (addr >= active->map) && (addr < active->base)) {
+		siglongjmp(active->overflow_jmp, 1);
+	}
+	// not an overflow, fault again with the previous handler
+	sigaction(sig, (sig == SIGSEGV) ? &old_segv : &old_bus, NULL);
+}
+
+static void stack_entry(void) {
+	active->test_func(active->test_info);
+	// returns to the runner through uc_link
+}
+
+static int get_budget(const ea__run_t* run, const ea_test_t* test) {
+	return test->stack_budget ? test->stack_budget : run->config->stack_budget;
+}
+
+static void stack_free(ea_stack_t* stack) {
+	munmap(stack->map, stack->map_size);
+	stack->root->mem_alloc(stack, 0, stack->root->mem_alloc_opaque);
+}
+
+static ea_stack_t* stack_alloc(ea_group_t* root, int size) {
+	int page = (int)sysconf(_SC_PAGESIZE);
+	size = (size + page - 1) / page * page;
+	char* map = (char*)mmap(NULL, page + size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		return NULL;
+	}
+	ea_stack_t* stack = (ea_stack_t*)root->mem_alloc(NULL, sizeof(ea_stack_t), root->mem_alloc_opaque);
+	stack->root = root;
+	stack->map = map;
+	stack->map_size = page + size;
+	mprotect(stack->map, page, PROT_NONE);
+	stack->base = stack->map + page;
+	stack->size = size;
+	memset(stack->base, STACK_FILL_BYTE, size);
+	return stack;
+}
+
+void ea__stack_run(ea__run_t* run, ea_test_t* test, ea__test_info_t* test_info) {
+	// the volatile locals are used after an overflow returns through siglongjmp()
+	int size = run->config->stack_size ? run->config->stack_size : STACK_DEFAULT_SIZE;
+	volatile int budget = get_budget(run, test);
+	if (size < budget) {
+		size = budget;
+	}
+
+	// (re)allocate the stack if it is too small
+	ea_stack_t* volatile stack = run->stack;
+	if (stack && (stack->size < size)) {
+		stack_free(stack);
+		stack = NULL;
+	}
+	if (!stack) {
+		stack = stack_alloc(ea__get_root(run->group), size);
+		run->stack = stack;
+	}
+	if (!stack) {
+		test->test_func(test_info);
+		return;
+	}
+
+	// catch faults on the guard page on a separate signal stack
+	stack_t ss;
+	ss.ss_sp = stack->signal_stack;
+	ss.ss_size = sizeof(stack->signal_stack);
+	ss.ss_flags = 0;
+	stack_t old_ss;
+	sigaltstack(&ss, &old_ss);
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = on_fault;
+	sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGSEGV, &sa, &old_segv);
+	sigaction(SIGBUS, &sa, &old_bus);
+
+	// run the test
+	stack->test_func = test->test_func;
+	stack->test_info = test_info;
+	getcontext(&stack->test_ctx);
+	stack->test_ctx.uc_stack.ss_sp = stack->base;
+	stack->test_ctx.uc_stack.ss_size = (size_t)stack->size;
+	stack->test_ctx.uc_link = &stack->run_ctx;
+	makecontext(&stack->test_ctx, stack_entry, 0);
+	active = stack;
+	volatile int overflow = 0;
+	if (sigsetjmp(stack->overflow_jmp, 1) == 0) {
+		swapcontext(&stack->run_ctx, &stack->test_ctx);
+	}
+	else {
+		overflow = 1;
+	}
+	active = NULL;
+
+	sigaction(SIGSEGV, &old_segv, NULL);
+	sigaction(SIGBUS, &old_bus, NULL);
+	sigaltstack(&old_ss, NULL);
+
+	// measure from the bottom, then refill what was touched
+	char* top = stack->base + stack->size;
+	char* p = stack->base;
+	while ((p < top) && (*(unsigned char*)p == STACK_FILL_BYTE)) {
+		p++;
+	}
+	int used = overflow ? stack->size : (int)(top - p);
+	memset(p, STACK_FILL_BYTE, top - p);
+	run->stack_used = used;
+
+	// report
+	int over_budget = (budget > 0) && (used > budget);
+	if (overflow) {
+		if (ea__fail_test(test_info)) {
+			ea__fail_printf(test_info, "  Stack overflow: more than %d bytes used\n", stack->size);
+		}
+	}
+	else if (over_budget) {
+		if (ea__fail_test(test_info)) {
+			ea__fail_printf(test_info, "  Stack usage of %d bytes exceeds the budget of %d bytes\n", used, budget);
+		}
+	}
+	else if (test_info->current_failed) {
+		ea__printf("  Stack usage: %d bytes\n", used);
+	}
+}
+
+void ea__stack_finish(ea_stack_t* stack) {
+	stack_free(stack);
+}
+
+#else
+
+void ea__stack_run(ea__run_t* run, ea_test_t* test, ea__test_info_t* test_info) {
+	// no dedicated stacks on this platform, run the test unmeasured
+	(void)run;
+	test->test_func(test_info);
+}
+
+void ea__stack_finish(ea_stack_t* stack) {
+	(void)stack;
+}
+
+#endif // STACK_HAVE_CONTEXT
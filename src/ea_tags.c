@@ -0,0 +1,139 @@
+#include <string.h>
+
+#include "ea_internal.h"
+
+/*
+ * Tags are interned in a per-tree index and represented as bits, so tests
+ * and groups carry a mask and selection is a couple of mask operations.
+ */
+struct ea_tag_index_s {
+	const char* names[EA_MAX_TAGS]; // not null-terminated
+	int lengths[EA_MAX_TAGS];
+	int count;
+};
+
+static int find_tag(const ea_tag_index_t* index, const char* name, int len) {
+	if (!index) {
+		return -1;
+	}
+	for (int i = 0; i < index->count; ++i) {
+		if ((index->lengths[i] == len) && (strncmp(index->names[i], name, len) == 0)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static int intern_tag(ea_group_t* root, const char* name, int len) {
+	if (!root->tag_index) {
+		root->tag_index = (ea_tag_index_t*)root->mem_alloc(NULL, sizeof(ea_tag_index_t), root->mem_alloc_opaque);
+		root->tag_index->count = 0;
+	}
+	ea_tag_index_t* index = root->tag_index;
+	int bit = find_tag(index, name, len);
+	if (bit >= 0) {
+		return bit;
+	}
+	if (index->count >= EA_MAX_TAGS) {
+		ea__printf("Too many distinct tags, ignoring: %.*s\n", len, name);
+		return -1;
+	}
+	index->names[index->count] = name;
+	index->lengths[index->count] = len;
+	return index->count++;
+}
+
+typedef void(*tag_visit_func_t)(const char* name, int len, int negated, void* opaque);
+
+static void for_each_tag(const char* tags, tag_visit_func_t visit, void* opaque) {
+	const char* start = tags;
+	for (const char* p = tags; ; ++p) {
+		if ((*p == ',') || (*p == '\0')) {
+			int negated = (start < p) && (*start == '~');
+			if (negated) {
+				start++;
+			}
+			if (p > start) {
+				visit(start, (int)(p - start), negated, opaque);
+			}
+			if (*p == '\0') {
+				break;
+			}
+			start = p + 1;
+		}
+	}
+}
+
+typedef struct {
+	ea_group_t* root;
+	ea__tag_mask_t mask;
+} mask_builder_t;
+
+static void add_to_mask(const char* name, int len, int negated, void* opaque) {
+	(void)negated;
+	mask_builder_t* builder = (mask_builder_t*)opaque;
+	int bit = intern_tag(builder->root, name, len);
+	if (bit >= 0) {
+		builder->mask |= (ea__tag_mask_t)1 << bit;
+	}
+}
+
+ea__tag_mask_t ea__tags_mask(ea_group_t* group, const char* tags) {
+	mask_builder_t builder = { ea__get_root(group), 0 };
+	if (tags) {
+		for_each_tag(tags, add_to_mask, &builder);
+	}
+	return builder.mask;
+}
+
+void ea_group_add_tags(ea_group_t* group, const char* tags) {
+	group->tags |= ea__tags_mask(group, tags);
+}
+
+static void add_to_selector(const char* name, int len, int negated, void* opaque) {
+	ea__tag_selector_t* selector = (ea__tag_selector_t*)opaque;
+	int bit = find_tag(selector->index, name, len);
+	if (negated) {
+		if (bit >= 0) {
+			selector->exclude |= (ea__tag_mask_t)1 << bit;
+		}
+	}
+	else {
+		// an unknown tag matches nothing, but still makes the selector restrictive
+		selector->has_include = 1;
+		if (bit >= 0) {
+			selector->include |= (ea__tag_mask_t)1 << bit;
+		}
+	}
+}
+
+void ea__tags_selector(ea_group_t* group, const char* tags, ea__tag_selector_t* selector) {
+	selector->index = ea__get_root(group)->tag_index;
+	selector->include = 0;
+	selector->exclude = 0;
+	selector->has_include = 0;
+	for_each_tag(tags, add_to_selector, selector);
+}
+
+int ea__tags_match(const ea__tag_selector_t* selector, ea__tag_mask_t mask) {
+	if (mask & selector->exclude) {
+		return 0;
+	}
+	return !selector->has_include || (mask & selector->include);
+}
+
+int ea__tags_name(const ea_group_t* root, int bit, const char** name) {
+	const ea_tag_index_t* index = root->tag_index;
+	if (!index || (bit >= index->count)) {
+		return 0;
+	}
+	*name = index->names[bit];
+	return index->lengths[bit];
+}
+
+void ea__tags_free(ea_group_t* root) {
+	if (root->tag_index) {
+		root->mem_alloc(root->tag_index, 0, root->mem_alloc_opaque);
+		root->tag_index = NULL;
+	}
+}
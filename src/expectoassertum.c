@@ -1,51 +1,11 @@
 #include <stdarg.h>
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef EA_FREESTANDING
+#include <time.h>
+#endif
 
-#include "expectoassertum.h"
-
-typedef struct ea_test_s {
-	// tree
-	struct ea_test_s* next;
-
-	// info
-	const char* name;
-
-	// test function
-	ea__test_func_t test_func;
-} ea_test_t;
-
-struct ea__test_info_s {
-	int total_count; // total executed test count
-	int failed_count; // total failed test count
-	int filtered_count; // total filtered out test count
-
-	int current_failed; // current test failed flag
-};
-
-struct ea_group_s {
-	// tree
-	ea_group_t* parent;
-	ea_group_t* next_sibling;
-	ea_group_t* prev_sibling;
-	ea_group_t* children_head;
-	ea_group_t* children_tail;
-	ea_test_t* tests_head;
-	ea_test_t* tests_tail;
-
-	// info
-	const char* name;
-
-	// memory
-	ea_mem_alloc_func_t mem_alloc;
-	void* mem_alloc_opaque;
-
-	// setup/teardown
-	ea_group_setup_teardown_func_t setup, teardown;
-	void* setup_opaque;
-	void* teardown_opaque;
-};
+#include "ea_internal.h"
 
 static ea_group_t* create_group(ea_group_t* parent, const char* name,
 	ea_mem_alloc_func_t mem_alloc, void* mem_alloc_opaque)
@@ -65,6 +25,19 @@ static ea_group_t* create_group(ea_group_t* parent, const char* name,
 	group->teardown = NULL;
 	group->setup_opaque = NULL;
 	group->teardown_opaque = NULL;
+	group->fixtures = NULL;
+	group->dependencies = NULL;
+	group->tags = 0;
+	group->config = NULL;
+	group->fixture_registry = NULL;
+	group->fixture_stamp = 0;
+	group->tag_index = NULL;
+	group->warm = 0;
+	group->prewarmable = 0;
+	group->prewarm_next = NULL;
+	group->isolated = 0;
+	group->lazy_register = NULL;
+	group->lazy_opaque = NULL;
 
 	if (parent) {
 		// link into parent's children list
@@ -104,6 +77,13 @@ ea_group_t* ea_group_create(ea_group_t* parent, const char* name) {
 	return create_group(parent, name, parent->mem_alloc, parent->mem_alloc_opaque);
 }
 
+ea_group_t* ea_group_create_lazy(ea_group_t* parent, const char* name, ea_group_register_func_t register_func, void* opaque) {
+	ea_group_t* group = create_group(parent, name, parent->mem_alloc, parent->mem_alloc_opaque);
+	group->lazy_register = register_func;
+	group->lazy_opaque = opaque;
+	return group;
+}
+
 void ea_release_group(ea_group_t* group) {
 	// release children
 	while (1) {
@@ -117,6 +97,10 @@ void ea_release_group(ea_group_t* group) {
 		ea_test_t* head = group->tests_head;
 		if (!head) break;
 		group->tests_head = head->next;
+		if (head->opaque) {
+			group->mem_alloc(head->opaque, 0, group->mem_alloc_opaque);
+		}
+		ea__fixture_uses_free(group, head->fixtures);
 		group->mem_alloc(head, 0, group->mem_alloc_opaque);
 	}
 
@@ -136,6 +120,33 @@ void ea_release_group(ea_group_t* group) {
 		}
 	}
 
+	// tear down what a server left up: the setup of the group, the fixtures
+	if (group->warm && group->teardown) {
+		group->teardown(group->teardown_opaque);
+	}
+	if (group->fixture_registry) {
+		ea__fixtures_finish(group);
+	}
+
+	// free fixture requirements and registry
+	ea__fixture_uses_free(group, group->fixtures);
+	ea__fixtures_free(group);
+
+	// free dependencies
+	while (group->dependencies) {
+		ea_dependency_t* next = group->dependencies->next;
+		group->mem_alloc(group->dependencies, 0, group->mem_alloc_opaque);
+		group->dependencies = next;
+	}
+
+	// free tag index
+	ea__tags_free(group);
+
+	// free run configuration
+	if (group->config) {
+		group->mem_alloc(group->config, 0, group->mem_alloc_opaque);
+	}
+
 	// free group memory
 	group->mem_alloc(group, 0, group->mem_alloc_opaque);
 }
@@ -150,11 +161,28 @@ void ea_group_set_teardown(ea_group_t* group, ea_group_setup_teardown_func_t tea
 	group->teardown_opaque = opaque;
 }
 
-void ea__test_add(ea_group_t* group, ea__test_func_t test_func, const char* test_name) {
+void ea_group_set_prewarmable(ea_group_t* group, int prewarmable) {
+	group->prewarmable = prewarmable;
+}
+
+void ea_group_set_isolated(ea_group_t* group, int isolated) {
+	group->isolated = isolated;
+}
+
+ea_test_t* ea__test_add_ex(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line, void* opaque) {
 	ea_test_t* test = (ea_test_t*)group->mem_alloc(NULL, sizeof(ea_test_t), group->mem_alloc_opaque);
 	test->next = NULL;
+	test->parent = group;
 	test->name = test_name;
+	test->file = file;
+	test->line = line;
 	test->test_func = test_func;
+	test->opaque = opaque;
+	test->fixtures = NULL;
+	test->tags = 0;
+	test->async = 0;
+	test->stack_budget = 0;
+	test->selected = 0;
 
 	if (group->tests_tail) {
 		group->tests_tail->next = test;
@@ -164,6 +192,203 @@ void ea__test_add(ea_group_t* group, ea__test_func_t test_func, const char* test
 		group->tests_head = test;
 		group->tests_tail = test;
 	}
+	return test;
+}
+
+void ea__test_add(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line) {
+	ea__test_add_ex(group, test_func, test_name, file, line, NULL);
+}
+
+void ea__test_add_with(ea_group_t* group, ea__test_func_t test_func, const char* test_name, const char* file, int line, const char* tags, const char* fixture_names) {
+	ea_test_t* test = ea__test_add_ex(group, test_func, test_name, file, line, NULL);
+	test->tags = ea__tags_mask(group, tags);
+	if (fixture_names) {
+		ea__fixtures_add_uses(group, &test->fixtures, fixture_names);
+	}
+}
+
+ea_group_t* ea__get_root(ea_group_t* group) {
+	while (group->parent) {
+		group = group->parent;
+	}
+	return group;
+}
+
+static const ea_config_t default_config = { 0 };
+
+const ea_config_t* ea__get_config(const ea_group_t* group) {
+	while (group->parent) {
+		group = group->parent;
+	}
+	return group->config ? group->config : &default_config;
+}
+
+static ea_config_t* get_config_for_write(ea_group_t* group) {
+	ea_group_t* root = ea__get_root(group);
+	if (!root->config) {
+		root->config = (ea_config_t*)root->mem_alloc(NULL, sizeof(ea_config_t), root->mem_alloc_opaque);
+		*root->config = default_config;
+	}
+	return root->config;
+}
+
+static int parse_int_option(const char* value, int* out) {
+	char* end;
+	long v = strtol(value, &end, 0);
+	if ((end == value) || *end || (v < 0)) {
+		return 0;
+	}
+	*out = (int)v;
+	return 1;
+}
+
+int ea_set_option(ea_group_t* group, const char* name, const char* value) {
+	ea_config_t* config = get_config_for_write(group);
+	if (strcmp(name, "seed") == 0) {
+		char* end;
+		config->seed = strtoull(value, &end, 0);
+		config->seed_set = (end != value) && !*end;
+		return config->seed_set;
+	}
+	if (strcmp(name, "prop-cases") == 0) {
+		return parse_int_option(value, &config->prop_cases);
+	}
+	if (strcmp(name, "prop-time") == 0) {
+		return parse_int_option(value, &config->prop_time_ms);
+	}
+	if (strcmp(name, "prop-threads") == 0) {
+		return parse_int_option(value, &config->prop_threads);
+	}
+	if (strcmp(name, "changed-since") == 0) {
+		config->changed_since = *value ? value : NULL;
+		return *value != '\0';
+	}
+	if (strcmp(name, "async-timeout") == 0) {
+		return parse_int_option(value, &config->async_timeout_ms);
+	}
+	if (strcmp(name, "stack") == 0) {
+		return parse_int_option(value, &config->stack_size);
+	}
+	if (strcmp(name, "stack-budget") == 0) {
+		return parse_int_option(value, &config->stack_budget);
+	}
+	if (strcmp(name, "bench-time") == 0) {
+		return parse_int_option(value, &config->bench_time_ms);
+	}
+	if (strcmp(name, "bench-trials") == 0) {
+		return parse_int_option(value, &config->bench_trials);
+	}
+	if (strcmp(name, "bench-cpu") == 0) {
+		config->bench_cpu_set = parse_int_option(value, &config->bench_cpu);
+		return config->bench_cpu_set;
+	}
+	if (strcmp(name, "profile") == 0) {
+		config->profile = *value ? value : ".";
+		return 1;
+	}
+	if (strcmp(name, "profile-hz") == 0) {
+		return parse_int_option(value, &config->profile_hz);
+	}
+	if (strcmp(name, "serve") == 0) {
+		config->serve = *value ? value : NULL;
+		return *value != '\0';
+	}
+	if (strcmp(name, "capture") == 0) {
+		if (*value == '\0') {
+			config->capture = -1; // default size
+			return 1;
+		}
+		return parse_int_option(value, &config->capture) && (config->capture > 0);
+	}
+	if (strcmp(name, "isolate") == 0) {
+		config->isolate = 1;
+		return *value == '\0';
+	}
+	if (strcmp(name, "failures-per-site") == 0) {
+		if (strcmp(value, "all") == 0) {
+			config->failures_per_site = -1;
+			return 1;
+		}
+		return parse_int_option(value, &config->failures_per_site) && (config->failures_per_site > 0);
+	}
+	if (strcmp(name, "durations") == 0) {
+		config->durations = *value ? value : NULL;
+		return *value != '\0';
+	}
+	if (strcmp(name, "journal") == 0) {
+		config->journal = *value ? value : NULL;
+		return *value != '\0';
+	}
+	if (strcmp(name, "resume") == 0) {
+		// without a file it resumes the journal option
+		if (*value) {
+			config->journal = value;
+		}
+		config->resume = 1;
+		return 1;
+	}
+	if (strcmp(name, "jobs") == 0) {
+#ifndef EA_FREESTANDING
+		if (strcmp(value, "auto") == 0) {
+			config->jobs = ea__cpu_count();
+			return 1;
+		}
+#endif
+		return parse_int_option(value, &config->jobs);
+	}
+	if (strcmp(name, "tags") == 0) {
+		config->tags = *value ? value : NULL;
+		return 1;
+	}
+	if (strcmp(name, "list") == 0) {
+		if (*value == '\0') {
+			config->list_mode = ea__list_plain;
+		}
+		else if (strcmp(value, "json") == 0) {
+			config->list_mode = ea__list_json;
+		}
+		else {
+			return 0;
+		}
+		return 1;
+	}
+	return 0;
+}
+
+void ea_parse_cmdline(ea_group_t* group, int argc, char** argv) {
+	char namebuf[32];
+	for (int i = 1; i < argc; ++i) {
+		// only --name=value arguments are options, --filter is handled by ea_parse_filter_cmdline
+		const char* arg = argv[i];
+		if ((arg[0] != '-') || (arg[1] != '-')) continue;
+		arg += 2;
+		const char* eq = strchr(arg, '=');
+		int namelen = eq ? (int)(eq - arg) : (int)strlen(arg);
+		if ((namelen == 0) || (namelen >= (int)sizeof(namebuf))) continue;
+		memcpy(namebuf, arg, namelen);
+		namebuf[namelen] = '\0';
+		if (strcmp(namebuf, "filter") == 0) continue;
+		if (!ea_set_option(group, namebuf, eq ? eq + 1 : "")) {
+#ifndef EA_FREESTANDING
+			// not on stdout, where tools read e.g. --list=json
+			fprintf(stderr, "Ignoring invalid option: %s\n", argv[i]);
+#else
+			ea__printf("Ignoring invalid option: %s\n", argv[i]);
+#endif
+		}
+	}
+}
+
+unsigned long long ea__now_ns(void) {
+#if defined(EA_FREESTANDING)
+	return 0;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+#else
+	return (unsigned long long)clock() * (1000000000ull / CLOCKS_PER_SEC);
+#endif
 }
 
 const char* ea_parse_filter_cmdline(int argc, char** argv) {
@@ -182,11 +407,11 @@ enum {
 	filter_mode_prefix = 'p',
 	filter_mode_suffix = 's',
 };
-typedef struct {
+struct ea_filter_s {
 	const char* match;
 	int length;
 	char mode, negated;
-} ea_filter_t;
+};
 
 static const ea_filter_t* parse_filters(ea_group_t* group, const char* filterstring) {
 	// count filters
@@ -285,11 +510,45 @@ int match_filters(const ea_filter_t* filters, const char* testname, int testname
 	return matched;
 }
 
-#ifndef TESTNAME_BUF_LEN
-#define TESTNAME_BUF_LEN 256
-#endif
+// nonzero if a test below the group named path (in a name buffer) could match the filters
+static int match_filters_below(const ea_filter_t* filters, char* path, int path_len) {
+	if (!filters) {
+		return 1;
+	}
+	// the names of the tests below start with the path and a slash
+	if ((path_len > 0) && (path_len < TESTNAME_BUF_LEN)) {
+		path[path_len++] = '/';
+	}
+	int may_match = 0;
+	for (const ea_filter_t* filter = filters; filter->match; ++filter) {
+		int common = (filter->length < path_len) ? filter->length : path_len;
+		if (filter->negated) {
+			// a negated prefix covering the path excludes everything below
+			if ((filter->mode == filter_mode_prefix) && (filter->length <= path_len) && (strncmp(path, filter->match, filter->length) == 0)) {
+				return 0;
+			}
+			continue;
+		}
+		switch (filter->mode) {
+		case filter_mode_full:
+			if ((filter->length > path_len) && (strncmp(path, filter->match, path_len) == 0)) {
+				may_match = 1;
+			}
+			break;
+		case filter_mode_prefix:
+			if (strncmp(path, filter->match, common) == 0) {
+				may_match = 1;
+			}
+			break;
+		case filter_mode_suffix:
+			may_match = 1;
+			break;
+		}
+	}
+	return may_match;
+}
 
-static int append_name_to_buf(char* buf, int pos, const char* name) {
+int ea__append_name(char* buf, int pos, const char* name) {
 	if ((pos > 0) && (pos < TESTNAME_BUF_LEN)) {
 		buf[pos++] = '/';
 	}
@@ -299,108 +558,674 @@ static int append_name_to_buf(char* buf, int pos, const char* name) {
 	return pos;
 }
 
-#ifndef TESTNAME_WIDTH
-#define TESTNAME_WIDTH 65
+int ea__group_name(const ea_group_t* top, const ea_group_t* group, char* buf) {
+	if (group == top) {
+		return ea__append_name(buf, 0, group->name);
+	}
+	return ea__append_name(buf, ea__group_name(top, group->parent, buf), group->name);
+}
+
+// mark the tests to run, returns the number of selected tests
+static int select_group(ea__run_t* run, ea_group_t* group, int namebufpos, ea__tag_mask_t tags) {
+	int count = 0;
+	char* namebuf = run->namebuf;
+	namebufpos = ea__append_name(namebuf, namebufpos, group->name);
+	tags |= group->tags;
+#ifndef EA_FREESTANDING
+	ea__prewarm_select(run, group);
 #endif
 
-void run_group(ea_group_t* group, char* namebuf, int namebufpos, ea__test_info_t* info, const ea_filter_t* filters) {
-	// write group name to name buffer
-	namebufpos = append_name_to_buf(namebuf, namebufpos, group->name);
+	// register the content of a lazy group if anything below could be selected
+	if (group->lazy_register) {
+		int wanted = match_filters_below(run->filters, namebuf, namebufpos) && (!run->use_tags || !(tags & run->tags.exclude));
+#ifndef EA_FREESTANDING
+		wanted = wanted || run->changes;
+#endif
+		if (!wanted) {
+			return 0;
+		}
+		ea_group_register_func_t register_func = group->lazy_register;
+		group->lazy_register = NULL;
+		register_func(group, group->lazy_opaque);
+		group->lazy_opaque = NULL;
+		// the tests may have added tags the selector does not know yet
+		if (run->use_tags) {
+			ea__tags_selector(run->group, run->config->tags, &run->tags);
+		}
+	}
+
+	ea__fixtures_check(group, group->fixtures);
+	for (ea_test_t* test = group->tests_head; test; test = test->next) {
+		int testnamepos = ea__append_name(namebuf, namebufpos, test->name);
+		int match = match_filters(run->filters, namebuf, testnamepos);
+		if (match && run->use_tags) {
+			match = ea__tags_match(&run->tags, tags | test->tags);
+		}
+		test->selected = match ? ea__selected_yes : ea__selected_no;
+#ifndef EA_FREESTANDING
+		if (run->changes) {
+			if (test->selected != ea__selected_yes) {
+				ea__changes_skip(run->changes, test);
+			}
+			else if (!ea__changes_select(run->changes, test, namebuf, testnamepos)) {
+				test->selected = ea__selected_unchanged;
+			}
+		}
+		if (run->journal && (test->selected == ea__selected_yes)) {
+			ea__journal_result_t previous;
+			if (ea__journal_lookup(run->journal, namebuf, testnamepos, &previous)) {
+				test->selected = ea__selected_resumed;
+				if (run->changes) {
+					ea__changes_skip(run->changes, test);
+				}
+			}
+		}
+#endif
+		if (test->selected == ea__selected_yes) {
+			ea__fixtures_check(group, test->fixtures);
+			ea__fixtures_count_user(test);
+			run->result_names_cap += testnamepos + 1;
+			count++;
+		}
+		else if (test->selected == ea__selected_unchanged) {
+			run->info.unchanged_count++;
+		}
+		else if (test->selected == ea__selected_resumed) {
+			run->info.resumed_count++;
+			run->result_names_cap += testnamepos + 1;
+		}
+		else {
+			run->info.filtered_count++;
+		}
+	}
+	for (ea_group_t* child = group->children_head; child; child = child->next_sibling) {
+		count += select_group(run, child, namebufpos, tags);
+	}
+	return count;
+}
+
+void ea__print_test_name(const char* name, int namelen) {
+	ea__printf("%.*s", namelen, name);
+	for (int i = namelen; i < TESTNAME_WIDTH; ++i) {
+		ea__printf(" ");
+	}
+	ea__printf(" => ");
+}
+
+int ea__run_test(ea__run_t* run, ea_test_t* test, int namelen) {
+	// build shared fixtures needed by the test
+	ea__fixtures_acquire(test);
+
+	// print test name
+	ea__print_test_name(run->namebuf, namelen);
+
+	// create test info
+	ea__test_info_t test_info = { 0 };
+	test_info.test = test;
+	test_info.name = run->namebuf;
+	test_info.name_len = namelen;
+	test_info.sites = run->sites;
+	char failure_message[EA_RESULT_MESSAGE_LEN];
+	if (run->results) {
+		failure_message[0] = '\0';
+		test_info.failure_message = failure_message;
+		test_info.bench_environment = &run->results->bench_environment;
+	}
+
+	// run test
+#ifndef EA_FREESTANDING
+	if (run->journal) {
+		ea__journal_start(run->journal, run->namebuf, namelen);
+	}
+#endif
+#ifndef EA_FREESTANDING
+	if (run->capture) {
+		ea__capture_start(run->capture);
+	}
+#endif
+#ifndef EA_FREESTANDING
+	if (ea__isolate_wanted(run, test)) {
+		ea__isolate_run(run, test, &test_info);
+	}
+	else {
+		ea__run_test_body(run, test, &test_info);
+	}
+#else
+	ea__run_test_body(run, test, &test_info);
+#endif
+#ifndef EA_FREESTANDING
+	if (run->capture) {
+		ea__capture_stop(run->capture, &test_info);
+	}
+#endif
+
+	int failed = ea__test_finish(run, test, namelen, &test_info, test_info.current_failed);
+
+	// details of the test (e.g. benchmark results)
+	if (test_info.report) {
+		test_info.report(&test_info);
+	}
+#ifndef EA_FREESTANDING
+	if (run->profile) {
+		ea__profile_report(run->profile, run->namebuf, namelen);
+	}
+#endif
+	return failed;
+}
+
+void ea__run_test_body(ea__run_t* run, ea_test_t* test, ea__test_info_t* test_info) {
+	ea__mock_reset();
+	unsigned long long start_ns = ea__now_ns();
+#ifndef EA_FREESTANDING
+	if (run->profile) {
+		ea__profile_start(run->profile);
+		test->test_func(test_info);
+		ea__profile_stop(run->profile);
+	}
+	else if (ea__stack_wanted(run, test)) {
+		ea__stack_run(run, test, test_info);
+	}
+	else {
+		test->test_func(test_info);
+	}
+#else
+	test->test_func(test_info);
+#endif
+	run->test_ns = ea__now_ns() - start_ns;
+}
+
+int ea__test_finish(ea__run_t* run, ea_test_t* test, int namelen, const ea__test_info_t* test_info, int failed) {
+	ea__test_info_t* info = &run->info;
+	ea_test_status_t status = !failed ? EA_TEST_PASSED : test_info->crashed ? EA_TEST_CRASHED : EA_TEST_FAILED;
+
+	// if success, print result (with the stack usage if measured)
+	if (!failed) {
+		if (run->stack_used) {
+			ea__printf("OK (stack: %d bytes)\n", run->stack_used);
+		}
+		else {
+			ea__printf("OK\n");
+		}
+	}
+
+	// if failed, increment failed counter
+	else {
+		info->failed_count++;
+	}
+
+	// increment total counter
+	info->total_count++;
 
-	// run group setup
+	// record the result for ea_run_ex()
+	if (run->results) {
+		ea__record_result(run, test, namelen, status, test_info);
+	}
+
+#ifndef EA_FREESTANDING
+	// remember the result for change-based selection
+	if (run->changes) {
+		ea__changes_result(run->changes, run->namebuf, namelen, failed);
+	}
+
+	// update the duration history
+	if (run->durations) {
+		ea__durations_record(run->durations, run->namebuf, namelen, run->test_ns);
+	}
+
+	// journal the result
+	if (run->journal) {
+		ea__journal_finish(run->journal, run->namebuf, namelen, status, run->test_ns, test_info->assertion_count);
+	}
+#else
+	(void)namelen;
+#endif
+
+	// tear down fixtures this was the last user of (a server keeps them)
+	if (!run->warm) {
+		ea__fixtures_release(test);
+	}
+
+	run->stack_used = 0;
+	return failed;
+}
+
+// copy failure details without the indentation of the lines and the final newline
+static void copy_details(char* dst, const char* src) {
+	int len = 0;
+	for (int start = 1; *src && (len < EA_RESULT_MESSAGE_LEN - 1); ++src) {
+		if (start && (src[0] == ' ') && (src[1] == ' ')) {
+			src++;
+			start = 0;
+			continue;
+		}
+		start = (*src == '\n');
+		dst[len++] = *src;
+	}
+	while (len && (dst[len - 1] == '\n')) {
+		len--;
+	}
+	dst[len] = '\0';
+}
+
+void ea__record_result(ea__run_t* run, const ea_test_t* test, int namelen, ea_test_status_t status, const ea__test_info_t* test_info) {
+	ea_results_t* results = run->results;
+	if (!results || (results->count == run->results_cap) || (run->result_names_len + namelen + 1 > run->result_names_cap)) {
+		return;
+	}
+	ea_test_result_t* result = &results->tests[results->count++];
+	char* name = run->result_names + run->result_names_len;
+	memcpy(name, run->namebuf, namelen);
+	name[namelen] = '\0';
+	run->result_names_len += namelen + 1;
+
+	result->name = name;
+	result->file = test->file;
+	result->line = test->line;
+	result->status = status;
+	result->duration_ns = run->test_ns;
+	result->assertion_count = test_info ? test_info->assertion_count : 0;
+	result->failure_file = test_info ? test_info->failure_file : NULL;
+	result->failure_line = test_info ? test_info->failure_line : 0;
+	result->failure_message[0] = '\0';
+	if (test_info && test_info->failure_message) {
+		copy_details(result->failure_message, test_info->failure_message);
+	}
+	result->stack_bytes = run->stack_used;
+	result->output = NULL;
+	if (test_info && test_info->output) {
+		ea_group_t* group = run->group;
+		result->output = (char*)group->mem_alloc(NULL, test_info->output_len + 1, group->mem_alloc_opaque);
+		memcpy(result->output, test_info->output, test_info->output_len);
+		result->output[test_info->output_len] = '\0';
+	}
+}
+
+// server mode: run the setups of the group and its ancestors in the run once,
+// before their first test
+static void warm_up(ea__run_t* run, ea_group_t* group) {
+	if (group->warm) {
+		return;
+	}
+	if (group != run->group) {
+		warm_up(run, group->parent);
+	}
+	group->warm = 1;
 	if (group->setup) {
 		group->setup(group->setup_opaque);
 	}
+}
+
+static void run_group(ea__run_t* run, ea_group_t* group, int namebufpos) {
+	char* namebuf = run->namebuf;
+
+	// write group name to name buffer
+	namebufpos = ea__append_name(namebuf, namebufpos, group->name);
+
+	// run group setup, unless it was prewarmed
+#ifndef EA_FREESTANDING
+	int prewarmed = run->prewarm && ea__prewarm_wait(run->prewarm, group);
+#else
+	int prewarmed = 0;
+#endif
+	if (group->setup && !run->warm && !prewarmed) {
+		group->setup(group->setup_opaque);
+	}
+
+	// build the next setup while the tests of this group run
+#ifndef EA_FREESTANDING
+	if (run->prewarm) {
+		ea__prewarm_next(run->prewarm, group);
+	}
+#endif
 
 	// run tests in this group
+	int async_count = 0;
 	ea_test_t* test = group->tests_head;
 	while (test) {
-		// set up test name and check filters
-		int testnamepos = append_name_to_buf(namebuf, namebufpos, test->name);
-		int match = match_filters(filters, namebuf, testnamepos);
-		if (!match) {
-			info->filtered_count++;
+		// skip tests that are not selected
+		if (test->selected != ea__selected_yes) {
 			test = test->next;
 			continue;
 		}
-
-		// print test name
-		printf("%.*s", testnamepos, namebuf);
-		for (int i = testnamepos; i < TESTNAME_WIDTH; ++i) {
-			printf(" ");
-		}
-		printf(" => ");
-
-		// create test info
-		ea__test_info_t test_info = { 0 };
-
-		// run test
-		test->test_func(&test_info);
-
-		// if success, print result
-		if (!test_info.current_failed) {
-			printf("OK\n");
+		// async tests are run together after the others
+		if (test->async) {
+			async_count++;
+			test = test->next;
+			continue;
 		}
-
-		// if failed, increment failed counter
-		else {
-			info->failed_count++;
+		if (run->warm) {
+			warm_up(run, group);
 		}
-
-		// increment total counter
-		info->total_count++;
-
+		int testnamepos = ea__append_name(namebuf, namebufpos, test->name);
+		ea__run_test(run, test, testnamepos);
 		test = test->next;
 	}
+#ifndef EA_FREESTANDING
+	if (async_count) {
+		if (run->warm) {
+			warm_up(run, group);
+		}
+		ea__async_run(run, group, namebufpos);
+	}
+#endif
 
 	// run child groups
 	ea_group_t* child = group->children_head;
 	while (child) {
-		run_group(child, namebuf, namebufpos, info, filters);
+		run_group(run, child, namebufpos);
 		child = child->next_sibling;
 	}
 
 	// run group teardown
-	if (group->teardown) {
+	if (group->teardown && !run->warm) {
 		group->teardown(group->teardown_opaque);
 	}
 }
 
-void ea_run(ea_group_t* group, const char* filterstring) {
+#ifndef EA_FREESTANDING
+// report the tests finished in a previous run from the journal, failures are printed
+static void report_resumed(ea__run_t* run, ea_group_t* group, int namebufpos) {
+	namebufpos = ea__append_name(run->namebuf, namebufpos, group->name);
+	for (ea_test_t* test = group->tests_head; test; test = test->next) {
+		if (test->selected != ea__selected_resumed) {
+			continue;
+		}
+		int namelen = ea__append_name(run->namebuf, namebufpos, test->name);
+		ea__journal_result_t previous;
+		ea__journal_lookup(run->journal, run->namebuf, namelen, &previous);
+		run->info.total_count++;
+		if (previous.status != EA_TEST_PASSED) {
+			run->info.failed_count++;
+			ea__print_test_name(run->namebuf, namelen);
+			ea__printf("%s (in a previous run)\n", (previous.status == EA_TEST_CRASHED) ? "CRASHED" : "FAILED");
+		}
+		if (run->results) {
+			ea__test_info_t test_info = { 0 };
+			test_info.assertion_count = previous.assertion_count;
+			run->test_ns = previous.duration_ns;
+			ea__record_result(run, test, namelen, previous.status, &test_info);
+		}
+	}
+	for (ea_group_t* child = group->children_head; child; child = child->next_sibling) {
+		report_resumed(run, child, namebufpos);
+	}
+}
+#endif
+
+// failures printed in full per assertion site, the rest is only counted
+#ifndef FAILURES_PER_SITE
+#define FAILURES_PER_SITE 5
+#endif
+
+static ea_results_t* run_tree(ea_group_t* group, const char* filterstring, int record, int warm) {
+	const ea_config_t* config = ea__get_config(group);
+	ea__run_t run = { 0 };
+	run.group = group;
+	run.config = config;
+	run.warm = warm;
+
+	int listing = (config->list_mode != ea__list_none);
+
+#ifndef EA_FREESTANDING
+	// serve the runs instead, each request is a warm run
+	if (config->serve && !warm && !listing) {
+		ea__serve(group, config->serve);
+		ea_results_t* results = NULL;
+		if (record) {
+			results = (ea_results_t*)group->mem_alloc(NULL, sizeof(ea_results_t), group->mem_alloc_opaque);
+			memset(results, 0, sizeof(ea_results_t));
+		}
+		return results;
+	}
+#endif
+
 	// parse filter string
-	const ea_filter_t* filters = 0;
 	if (filterstring) {
-		printf("Applying test filter: %s\n", filterstring);
-		filters = parse_filters(group, filterstring);
+		if (!listing) {
+			ea__printf("Applying test filter: %s\n", filterstring);
+		}
+		run.filters = parse_filters(group, filterstring);
 	}
 
-	// run the group
-	ea__test_info_t test_info = { 0 };
-	char namebuf[TESTNAME_BUF_LEN + 1];
-	run_group(group, namebuf, 0, &test_info, filters);
+	// parse tag selector
+	if (config->tags) {
+		if (!listing) {
+			ea__printf("Applying tag selector: %s\n", config->tags);
+		}
+		ea__tags_selector(group, config->tags, &run.tags);
+		run.use_tags = 1;
+	}
+
+	// count the failures per assertion site
+	if (!listing) {
+		run.sites = ea__sites_create(ea__get_root(group), config->failures_per_site ? config->failures_per_site : FAILURES_PER_SITE);
+	}
+
+#ifndef EA_FREESTANDING
+	// load the change cache
+	if (config->changed_since) {
+		if (!listing) {
+			ea__printf("Selecting tests changed since: %s\n", config->changed_since);
+		}
+		run.changes = ea__changes_load(ea__get_root(group), config->changed_since);
+	}
+
+	// load the duration history
+	if (config->durations && !listing) {
+		run.durations = ea__durations_load(ea__get_root(group), config->durations);
+	}
+
+	// start the profiler, the tests run on the usual stack then
+	if (config->profile && !listing) {
+		ea__printf("Profiling tests to: %s\n", config->profile);
+		if (config->stack_size || config->stack_budget) {
+			ea__printf("Stack measurement is off while profiling.\n");
+		}
+		run.profile = ea__profile_create(ea__get_root(group), config->profile, config->profile_hz);
+	}
+
+	// capture the output of the tests
+	if (config->capture && !listing) {
+		run.capture = ea__capture_create(ea__get_root(group), config->capture);
+	}
+
+	// open the results journal
+	if (config->journal && !listing) {
+		if (config->resume) {
+			ea__printf("Resuming from journal: %s\n", config->journal);
+		}
+		run.journal = ea__journal_open(ea__get_root(group), config->journal, config->resume);
+	}
+#endif
+
+	// select tests, with the tags inherited from the ancestors of the group
+	ea__tag_mask_t tags = 0;
+	for (const ea_group_t* g = group->parent; g; g = g->parent) {
+		tags |= g->tags;
+	}
+	int selected = select_group(&run, group, 0, tags);
+#ifndef EA_FREESTANDING
+	ea__prewarm_select_end(&run);
+
+	// prewarm group setups in serial runs (a server runs them once anyway),
+	// if any test runs next to them
+	if (!warm && !listing && (selected > 0)) {
+		run.prewarm = ea__prewarm_create(ea__get_root(group), &run);
+	}
+#endif
+
+	// allocate the results in one block: header, records, names
+	ea_results_t* results = NULL;
+	if (record) {
+		selected += run.info.resumed_count;
+		int size = (int)sizeof(ea_results_t) + (int)sizeof(ea_test_result_t) * selected + run.result_names_cap;
+		results = (ea_results_t*)group->mem_alloc(NULL, size, group->mem_alloc_opaque);
+		memset(results, 0, sizeof(ea_results_t));
+		results->tests = (ea_test_result_t*)(results + 1);
+		run.results = results;
+		run.results_cap = selected;
+		run.result_names = (char*)(results->tests + selected);
+	}
+
+#ifndef EA_FREESTANDING
+	// only list the selected tests if requested
+	if (listing) {
+		ea__list(group, config->list_mode == ea__list_json);
+		ea__fixtures_finish(group);
+		if (run.changes) {
+			ea__changes_finish(run.changes, 0);
+		}
+		if (run.filters) {
+			group->mem_alloc((void*)run.filters, 0, group->mem_alloc_opaque);
+		}
+		return results;
+	}
+
+	// report what the journal knows, then run the rest
+	if (run.info.resumed_count) {
+		report_resumed(&run, group, 0);
+	}
+
+	// run the group, in worker processes if requested (not when warm, the
+	// workers would build everything again)
+	if (warm || (config->jobs <= 1) || !ea__run_parallel(&run, config->jobs)) {
+		run_group(&run, group, 0);
+	}
+	if (!warm) {
+		ea__fixtures_finish(group);
+	}
+	if (run.changes) {
+		ea__changes_finish(run.changes, 1);
+	}
+	if (run.durations) {
+		ea__durations_finish(run.durations, 1);
+	}
+	if (run.stack) {
+		ea__stack_finish(run.stack);
+	}
+	if (run.journal) {
+		ea__journal_close(run.journal);
+	}
+	if (run.profile) {
+		ea__profile_finish(run.profile);
+	}
+	if (run.capture) {
+		ea__capture_finish(run.capture);
+	}
+	if (run.prewarm) {
+		ea__prewarm_finish(run.prewarm);
+	}
+#else
+	run_group(&run, group, 0);
+	ea__fixtures_finish(group);
+#endif
 
 	// print summary
-	if (test_info.failed_count == 0) {
-		printf("All %d tests passed.\n", test_info.total_count);
+	ea__test_info_t* info = &run.info;
+	if (info->failed_count == 0) {
+		ea__printf("All %d tests passed.\n", info->total_count);
 	}
 	else {
-		printf("%d test(s) out of %d failed.\n", test_info.failed_count, test_info.total_count);
+		ea__printf("%d test(s) out of %d failed.\n", info->failed_count, info->total_count);
 	}
-	if (test_info.filtered_count > 0) {
-		printf("%d test(s) were filtered out.\n", test_info.filtered_count);
+	if (run.sites) {
+		ea__sites_finish(run.sites);
+	}
+	if (info->filtered_count > 0) {
+		ea__printf("%d test(s) were filtered out.\n", info->filtered_count);
+	}
+	if (info->unchanged_count > 0) {
+		ea__printf("%d test(s) were skipped as unchanged.\n", info->unchanged_count);
+	}
+	if (info->resumed_count > 0) {
+		ea__printf("%d test(s) were resumed from the journal.\n", info->resumed_count);
+	}
+	if (run.makespan_predicted_ns > 0) {
+		// tests without a history were predicted as average ones
+		unsigned long long actual = run.makespan_ns / 100000, predicted = run.makespan_predicted_ns / 100000;
+		if (run.makespan_unknown == run.makespan_tests) {
+			ea__printf("Makespan: %llu.%llu ms (not predicted, no duration history yet).\n", actual / 10, actual % 10);
+		}
+		else if (run.makespan_unknown > 0) {
+			ea__printf("Makespan: %llu.%llu ms (estimated %llu.%llu ms, %d test(s) without history).\n", actual / 10, actual % 10,
+				predicted / 10, predicted % 10, run.makespan_unknown);
+		}
+		else {
+			ea__printf("Makespan: %llu.%llu ms (predicted %llu.%llu ms).\n", actual / 10, actual % 10, predicted / 10, predicted % 10);
+		}
 	}
 
 	// free filters
-	if (filters) {
-		group->mem_alloc((void*)filters, 0, group->mem_alloc_opaque);
+	if (run.filters) {
+		group->mem_alloc((void*)run.filters, 0, group->mem_alloc_opaque);
 	}
+
+	if (results) {
+		results->total_count = info->total_count;
+		results->failed_count = info->failed_count;
+		results->filtered_count = info->filtered_count;
+		results->unchanged_count = info->unchanged_count;
+		results->resumed_count = info->resumed_count;
+	}
+	return results;
+}
+
+void ea_run(ea_group_t* group, const char* filterstring) {
+	run_tree(group, filterstring, 0, 0);
+}
+
+ea_results_t* ea_run_ex(ea_group_t* group, const char* filterstring) {
+	return run_tree(group, filterstring, 1, 0);
 }
 
-void ea__print_assertion_failed(ea__test_info_t* test_info, const char* file, int line) {
+#ifndef EA_FREESTANDING
+ea_results_t* ea__run_warm(ea_group_t* group, const char* filterstring, int record) {
+	return run_tree(group, filterstring, record, 1);
+}
+#endif
+
+void ea_results_free(ea_group_t* group, ea_results_t* results) {
+	for (int i = 0; i < results->count; ++i) {
+		if (results->tests[i].output) {
+			group->mem_alloc(results->tests[i].output, 0, group->mem_alloc_opaque);
+		}
+	}
+	group->mem_alloc(results, 0, group->mem_alloc_opaque);
+}
+
+int ea__print_assertion_failed(ea__test_info_t* test_info, const char* file, int line) {
 	// mark test as failed and print message
-	if (!test_info->current_failed) {
+	if (test_info->quiet) {
+		test_info->current_failed = 1;
+		return 0;
+	}
+	if (test_info->capture) {
+		test_info->current_failed = 1;
+		if (test_info->failure_file) {
+			return 0;
+		}
+		test_info->failure_file = file;
+		test_info->failure_line = line;
+		test_info->failure_message_len = 0;
+		return 1;
+	}
+	int first_failure = !test_info->current_failed;
+	if (first_failure) {
 		test_info->current_failed = 1;
-		printf("FAILED\n");
+		ea__printf("FAILED\n");
+	}
+
+	// count the failure at its site, only the first ones of a site print in full
+	int full = !test_info->sites || ea__sites_note(test_info->sites, file, line);
+
+	// capture the details of the first failed assertion for the results
+	if (!test_info->failure_file) {
+		test_info->failure_file = file;
+		test_info->failure_line = line;
+		test_info->failure_message_len = 0;
+	}
+	else {
+		test_info->failure_message_len = -1;
 	}
 
 	// cut filename to last path component
@@ -411,26 +1236,98 @@ void ea__print_assertion_failed(ea__test_info_t* test_info, const char* file, in
 		}
 	}
 
-	// print assertion details
-	printf("  Assertion failed at %s line %d:\n", short_file, line);
+	// print assertion details, or a single line for the first suppressed failure of the test
+	if (!full) {
+		if (first_failure) {
+			ea__printf("  Assertion failed at %s line %d (details suppressed, see the failure sites)\n", short_file, line);
+		}
+		if (test_info->failure_message && (test_info->failure_message_len == 0)) {
+			static const char suppressed[] = "  Details suppressed, the site failed repeatedly\n";
+			memcpy(test_info->failure_message, suppressed, sizeof(suppressed));
+			test_info->failure_message_len = -1;
+		}
+		return 0;
+	}
+	ea__printf("  Assertion failed at %s line %d:\n", short_file, line);
+	return 1;
+}
+
+int ea__fail_test(ea__test_info_t* test_info) {
+	// a failure without an assertion is located at the test
+	int first_failure = !test_info->current_failed;
+	test_info->current_failed = 1;
+	if (test_info->quiet || (test_info->capture && test_info->failure_file)) {
+		return 0;
+	}
+	if (first_failure && !test_info->capture) {
+		ea__printf("FAILED\n");
+	}
+
+	// capture the details if this is the first failure
+	if (!test_info->failure_file) {
+		test_info->failure_file = test_info->test->file;
+		test_info->failure_line = test_info->test->line;
+		test_info->failure_message_len = 0;
+	}
+	else {
+		test_info->failure_message_len = -1;
+	}
+	return 1;
+}
+
+// print failure details, also captured for the results while recording the first failure
+static void fail_vprintf(ea__test_info_t* test_info, const char* fmt, va_list args) {
+	if (test_info->failure_message && (test_info->failure_message_len >= 0)) {
+		va_list copy;
+		va_copy(copy, args);
+		test_info->failure_message_len = ea__vformat_append(test_info->failure_message, EA_RESULT_MESSAGE_LEN, test_info->failure_message_len, fmt, copy);
+		va_end(copy);
+	}
+	if (!test_info->capture) {
+		ea__vprintf(fmt, args);
+	}
+}
+
+static void fail_printf(ea__test_info_t* test_info, const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	fail_vprintf(test_info, fmt, args);
+	va_end(args);
+}
+
+void ea__fail_printf(ea__test_info_t* test_info, const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	fail_vprintf(test_info, fmt, args);
+	va_end(args);
 }
 
+#ifndef EA_NO_MESSAGES
 #define print_message() if (msg) { \
-	printf("  Message: "); \
+	fail_printf(test_info, "  Message: "); \
 	va_list args; \
 	va_start(args, msg); \
-	vprintf(msg, args); \
+	fail_vprintf(test_info, msg, args); \
 	va_end(args); \
-	printf("\n"); \
+	fail_printf(test_info, "\n"); \
+}
+#else
+// the message is printed as written, its arguments are not formatted
+#define print_message() if (msg) { \
+	fail_printf(test_info, "  Message: %s\n", msg); \
 }
+#endif
 
 int ea__assert_bool_check(ea__test_info_t* test_info, int actual, const char* actual_str, int exp, const char* file, int line, const char* msg, ...) {
+	test_info->assertion_count++;
 	if (actual == exp) {
 		return 1;
 	}
-	ea__print_assertion_failed(test_info, file, line);
+	if (!ea__print_assertion_failed(test_info, file, line)) {
+		return 0;
+	}
 	const char* boolstrs[] = { "true", "false" };
-	printf("  Expected %s (which is %s) to be %s\n", actual_str, boolstrs[!actual], boolstrs[!exp]);
+	fail_printf(test_info, "  Expected %s (which is %s) to be %s\n", actual_str, boolstrs[!actual], boolstrs[!exp]);
 	print_message();
 	return 0;
 }
@@ -448,6 +1345,7 @@ static const char* get_opstr(int op) {
 }
 
 int ea__assert_int_check(ea__test_info_t* test_info, long long a, long long b, int op, const char* sa, const char* sb, const char* file, int line, const char* msg, ...) {
+	test_info->assertion_count++;
 	int res = 0;
 	switch (op) {
 	case ea__op_eq: res = (a == b); break;
@@ -460,13 +1358,20 @@ int ea__assert_int_check(ea__test_info_t* test_info, long long a, long long b, i
 	if (res) {
 		return 1;
 	}
-	ea__print_assertion_failed(test_info, file, line);
-	printf("  Expected %s (which is %lld)\n  to be %s %s (which is %lld)\n", sa, a, get_opstr(op), sb, b);
+	int full = ea__print_assertion_failed(test_info, file, line);
+	if (test_info->sites) {
+		ea__sites_int(test_info->sites, file, line, a);
+	}
+	if (!full) {
+		return 0;
+	}
+	fail_printf(test_info, "  Expected %s (which is %lld)\n  to be %s %s (which is %lld)\n", sa, a, get_opstr(op), sb, b);
 	print_message();
 	return 0;
 }
 
 int ea__assert_uint_check(ea__test_info_t* test_info, unsigned long long a, unsigned long long b, int op, const char* sa, const char* sb, const char* file, int line, const char* msg, ...) {
+	test_info->assertion_count++;
 	int res = 0;
 	switch (op) {
 	case ea__op_eq: res = (a == b); break;
@@ -479,13 +1384,20 @@ int ea__assert_uint_check(ea__test_info_t* test_info, unsigned long long a, unsi
 	if (res) {
 		return 1;
 	}
-	ea__print_assertion_failed(test_info, file, line);
-	printf("  Expected %s (which is %llu)\n  to be %s %s (which is %llu)\n", sa, a, get_opstr(op), sb, b);
+	int full = ea__print_assertion_failed(test_info, file, line);
+	if (test_info->sites) {
+		ea__sites_uint(test_info->sites, file, line, a);
+	}
+	if (!full) {
+		return 0;
+	}
+	fail_printf(test_info, "  Expected %s (which is %llu)\n  to be %s %s (which is %llu)\n", sa, a, get_opstr(op), sb, b);
 	print_message();
 	return 0;
 }
 
 int ea__assert_ptr_check(ea__test_info_t* test_info, const void* a, const void* b, int op, const char* sa, const char* sb, const char* file, int line, const char* msg, ...) {
+	test_info->assertion_count++;
 	int res = 0;
 	switch (op) {
 	case ea__op_eq: res = (a == b); break;
@@ -494,29 +1406,35 @@ int ea__assert_ptr_check(ea__test_info_t* test_info, const void* a, const void*
 	if (res) {
 		return 1;
 	}
-	ea__print_assertion_failed(test_info, file, line);
-	printf("  Expected %s (which is %p)\n  to be %s %s (which is %p)\n", sa, a, get_opstr(op), sb, b);
+	if (!ea__print_assertion_failed(test_info, file, line)) {
+		return 0;
+	}
+	fail_printf(test_info, "  Expected %s (which is %p)\n  to be %s %s (which is %p)\n", sa, a, get_opstr(op), sb, b);
 	print_message();
 	return 0;
 }
 
 int ea__assert_ptr_null_check(ea__test_info_t* test_info, const void* a, int is_null, const char* sa, const char* file, int line, const char* msg, ...) {
+	test_info->assertion_count++;
 	int res = is_null ? (a == NULL) : (a != NULL);
 	if (res) {
 		return 1;
 	}
-	ea__print_assertion_failed(test_info, file, line);
+	if (!ea__print_assertion_failed(test_info, file, line)) {
+		return 0;
+	}
 	if (is_null) {
-		printf("  Expected %s (which is %p) to be NULL\n", sa, a);
+		fail_printf(test_info, "  Expected %s (which is %p) to be NULL\n", sa, a);
 	}
 	else {
-		printf("  Expected %s (which is NULL) to be not NULL\n", sa);
+		fail_printf(test_info, "  Expected %s (which is NULL) to be not NULL\n", sa);
 	}
 	print_message();
 	return 0;
 }
 
 int ea__assert_str_check(ea__test_info_t* test_info, const char* a, const char* b, int size, int op, const char* sa, const char* sb, const char* file, int line, const char* msg, ...) {
+	test_info->assertion_count++;
 	// determine comparison result
 	int cmpres;
 	if (size < 0) {
@@ -539,18 +1457,22 @@ int ea__assert_str_check(ea__test_info_t* test_info, const char* a, const char*
 	}
 
 	// assertion failed
-	ea__print_assertion_failed(test_info, file, line);
+	if (!ea__print_assertion_failed(test_info, file, line)) {
+		return 0;
+	}
 	if (size < 0) {
-		printf("  Expected %s (which is \"%s\")\n  to be %s %s (which is \"%s\")\n", sa, a, get_opstr(op), sb, b);
+		fail_printf(test_info, "  Expected %s (which is \"%s\")\n  to be %s %s (which is \"%s\")\n", sa, a, get_opstr(op), sb, b);
 	}
 	else {
-		printf("  Expected first %d characters of %s (which is \"%.*s\")\n  to be %s first %d characters of %s (which is \"%.*s\")\n", size, sa, size, a, get_opstr(op), size, sb, size, b);
+		fail_printf(test_info, "  Expected first %d characters of %s (which is \"%.*s\")\n  to be %s first %d characters of %s (which is \"%.*s\")\n", size, sa, size, a, get_opstr(op), size, sb, size, b);
 	}
 	print_message();
 	return 0;
 }
 
+#ifndef EA_NO_DOUBLE
 int ea__assert_double_check(ea__test_info_t* test_info, double a, double b, double reltol, double abstol, int op, const char* sa, const char* sb, const char* file, int line, const char* msg, ...) {
+	test_info->assertion_count++;
 	// find effective tolerance
 	{
 		double aa = (a >= 0.0) ? a : -a;
@@ -581,8 +1503,30 @@ int ea__assert_double_check(ea__test_info_t* test_info, double a, double b, doub
 	}
 
 	// assertion failed
-	ea__print_assertion_failed(test_info, file, line);
-	printf("  Expected %s (which is %f)\n  to be %s %s (which is %f)\n", sa, a, get_opstr(op), sb, b);
+	int full = ea__print_assertion_failed(test_info, file, line);
+	if (test_info->sites) {
+		ea__sites_double(test_info->sites, file, line, a);
+	}
+	if (!full) {
+		return 0;
+	}
+	fail_printf(test_info, "  Expected %s (which is %f)\n  to be %s %s (which is %f)\n", sa, a, get_opstr(op), sb, b);
+	print_message();
+	return 0;
+}
+#endif // EA_NO_DOUBLE
+
+int ea__assert_values_check(ea__test_info_t* test_info, int ok, const char* sa, const char* va, int op, const char* sb, const char* vb, const char* file, int line, const char* msg, ...) {
+	test_info->assertion_count++;
+	if (ok) {
+		return 1;
+	}
+
+	// assertion failed
+	if (!ea__print_assertion_failed(test_info, file, line)) {
+		return 0;
+	}
+	fail_printf(test_info, "  Expected %s (which is %s)\n  to be %s %s (which is %s)\n", sa, va, get_opstr(op), sb, vb);
 	print_message();
 	return 0;
 }